@@ -0,0 +1,373 @@
+//
+//  Native benchmarks of the BVH core: parse, channel to transform conversion and save throughput, and peak memory,
+//  over synthetic files from tiny to extreme shapes. Results are printed as a table and written as JSON.
+//
+//  Usage: BVHBenchmark [--case=<name>[,<name>...]] [--scale=1.0] [--repeat=3] [--dir=<temp dir>] [--json=<file>] [--keep]
+//
+
+#include "BVHFile.h"
+#include "BVHStream.h"
+
+#include "BVHSyntheticFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef  _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef  __GLIBC__
+#include <malloc.h>
+#endif
+
+
+namespace
+{
+	struct  BenchmarkCase
+	{
+		const char*            name;
+		const char*            description;
+		FBVHSyntheticSettings  settings;
+	};
+
+	struct  BenchmarkResult
+	{
+		std::string  name;
+		std::string  description;
+		bool         is_success = false;
+		long long    file_bytes = 0;
+		long long    saved_bytes = 0;
+		int          num_joints = 0;
+		int          num_channels = 0;
+		int          num_frames = 0;
+		size_t       max_line_bytes = 0;
+		double       parse_seconds = 0.0;
+		double       reopen_seconds = 0.0;     // parse through the FBVHFile of the previous parse, as a batch does
+		double       convert_seconds = 0.0;
+		double       save_seconds = 0.0;
+		double       peak_memory_mb = 0.0;
+	};
+
+	double  Now()
+	{
+		return  std::chrono::duration< double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Peak resident memory of the process since the last ResetPeakMemory(), or since it started where it cannot be reset
+	void  ResetPeakMemory()
+	{
+		FBVHFile::ClearHierarchyCache();
+#ifdef  __GLIBC__
+		// Memory freed by the previous case would otherwise count towards this one
+		malloc_trim(0);
+#endif
+#ifdef  __linux__
+		std::ofstream  clear_refs("/proc/self/clear_refs");
+		clear_refs << "5";
+#endif
+	}
+
+	double  GetPeakMemoryMB()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS  counters;
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return  counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#elif defined(__linux__)
+		std::ifstream  status("/proc/self/status");
+		std::string    line;
+		while (std::getline(status, line))
+		{
+			if (line.compare(0, 6, "VmHWM:") == 0)
+			{
+				return  atof(line.c_str() + 6) / 1024.0;
+			}
+		}
+		return  0.0;
+#else
+		struct rusage  usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return  usage.ru_maxrss / (1024.0 * 1024.0);
+#endif
+	}
+
+	std::vector< BenchmarkCase >  MakeCases(double scale)
+	{
+		auto  frames = [scale](int num_frames) { return  std::max(1, (int)(num_frames * scale)); };
+		std::vector< BenchmarkCase >  cases;
+
+		BenchmarkCase  body{ "body_long", "24 joint body, long take", FBVHSyntheticSettings() };
+		body.settings.num_frames = frames(200000);
+		cases.push_back(body);
+
+		BenchmarkCase  dense{ "dense_rig", "300 joints with 6 channels (fingers and face)", FBVHSyntheticSettings() };
+		dense.settings.num_joints = 300;
+		dense.settings.branching = 4;
+		dense.settings.all_positions = true;
+		dense.settings.num_frames = frames(10000);
+		cases.push_back(dense);
+
+		// Frame lines of more than 4 MB, beyond the read block and the old fixed line buffer
+		BenchmarkCase  wide{ "huge_lines", "70000 joints, frame lines above 4 MB", FBVHSyntheticSettings() };
+		wide.settings.num_joints = 70000;
+		wide.settings.branching = 8;
+		wide.settings.all_positions = true;
+		wide.settings.num_frames = std::max(2, frames(8));
+		cases.push_back(wide);
+
+		BenchmarkCase  chain{ "deep_chain", "1000 joint chain", FBVHSyntheticSettings() };
+		chain.settings.num_joints = 1000;
+		chain.settings.branching = 1;
+		chain.settings.num_frames = frames(2000);
+		cases.push_back(chain);
+
+		BenchmarkCase  order{ "xyz_positions_last", "XYZ rotations, positions after rotations", FBVHSyntheticSettings() };
+		order.settings.num_joints = 60;
+		order.settings.rotation_order = "XYZ";
+		order.settings.positions_last = true;
+		order.settings.num_frames = frames(50000);
+		cases.push_back(order);
+
+		BenchmarkCase  scientific{ "scientific_tabs_crlf", "%e values, tab separators, CRLF", FBVHSyntheticSettings() };
+		scientific.settings.num_joints = 60;
+		scientific.settings.scientific = true;
+		scientific.settings.precision = 9;
+		scientific.settings.separator = '\t';
+		scientific.settings.crlf = true;
+		scientific.settings.num_frames = frames(50000);
+		cases.push_back(scientific);
+
+		BenchmarkCase  tiny{ "tiny_many", "3 joints, 2 decimals", FBVHSyntheticSettings() };
+		tiny.settings.num_joints = 3;
+		tiny.settings.precision = 2;
+		tiny.settings.num_frames = frames(500000);
+		cases.push_back(tiny);
+
+		return  cases;
+	}
+
+	// Local transforms of every joint at every frame, in parallel over blocks of frames like the engine converter
+	double  ConvertAll(const FBVHFile& file)
+	{
+		const int  frames_per_block = 256;
+		const int  num_frames = file.GetNumFrame();
+		const int  num_joints = file.GetNumJoint();
+		const int  num_blocks = (num_frames + frames_per_block - 1) / frames_per_block;
+		std::vector< double >  sums(num_blocks, 0.0);
+
+		FBVHCore::ParallelFor(num_blocks, [&](int block)
+		{
+			const int  last_frame = std::min(num_frames, (block + 1) * frames_per_block);
+			double  sum = 0.0;
+			for (int f = block * frames_per_block; f < last_frame; f++)
+			{
+				for (int j = 0; j < num_joints; j++)
+				{
+					const FBVHTransform  transform = file.GetTransform(f, j);
+					sum += transform.Translation.X + transform.Rotation.W;
+				}
+			}
+			sums[block] = sum;
+		});
+
+		double  total = 0.0;
+		for (double sum : sums)
+		{
+			total += sum;
+		}
+		return  total;
+	}
+
+	BenchmarkResult  RunCase(const BenchmarkCase& benchmark, const std::string& dir, int repeat, bool keep_files)
+	{
+		BenchmarkResult  result;
+		result.name = benchmark.name;
+		result.description = benchmark.description;
+
+		const std::string  source_name = dir + "/" + benchmark.name + ".bvh";
+		const std::string  saved_name = dir + "/" + benchmark.name + ".saved.bvh";
+		if (!WriteSyntheticBVH(source_name, benchmark.settings, &result.max_line_bytes))
+		{
+			fprintf(stderr, "%s: cannot write %s\n", benchmark.name, source_name.c_str());
+			return  result;
+		}
+		result.file_bytes = (long long)std::filesystem::file_size(source_name);
+
+		result.parse_seconds = result.reopen_seconds = result.convert_seconds = result.save_seconds = 1e30;
+		volatile double  checksum = 0.0;
+		for (int run = 0; run < repeat; run++)
+		{
+			ResetPeakMemory();
+
+			FBVHFile  file(source_name.c_str());
+			double  start = Now();
+			if (!file.Open())
+			{
+				fprintf(stderr, "%s: parse failed\n", benchmark.name);
+				return  result;
+			}
+			result.parse_seconds = std::min(result.parse_seconds, Now() - start);
+
+			// The motion buffer and the read blocks are reused, only the parse is left
+			file.SetFileName(source_name.c_str());
+			start = Now();
+			if (!file.Open())
+			{
+				fprintf(stderr, "%s: reopen failed\n", benchmark.name);
+				return  result;
+			}
+			result.reopen_seconds = std::min(result.reopen_seconds, Now() - start);
+
+			start = Now();
+			checksum = checksum + ConvertAll(file);
+			result.convert_seconds = std::min(result.convert_seconds, Now() - start);
+
+			FBVHOutputFile  output;
+			start = Now();
+			if (!output.Open(saved_name.c_str()) || !file.Save(output, benchmark.settings.precision))
+			{
+				fprintf(stderr, "%s: save failed\n", benchmark.name);
+				return  result;
+			}
+			result.saved_bytes = output.Tell();
+			output.Close();
+			result.save_seconds = std::min(result.save_seconds, Now() - start);
+
+			result.num_joints = file.GetNumJoint();
+			result.num_channels = file.GetNumChannel();
+			result.num_frames = file.GetNumFrame();
+			result.peak_memory_mb = std::max(result.peak_memory_mb, GetPeakMemoryMB());
+		}
+
+		if (!keep_files)
+		{
+			std::filesystem::remove(source_name);
+			std::filesystem::remove(saved_name);
+		}
+		result.is_success = true;
+		return  result;
+	}
+
+	double  Rate(double amount, double seconds)
+	{
+		return  seconds > 0.0 ? amount / seconds : 0.0;
+	}
+
+	void  WriteJson(const std::string& file_name, const std::vector< BenchmarkResult >& results, double scale, int repeat)
+	{
+		FILE*  file = fopen(file_name.c_str(), "w");
+		if (file == NULL)
+		{
+			fprintf(stderr, "Cannot write %s\n", file_name.c_str());
+			return;
+		}
+
+		fprintf(file, "{\n  \"schema\": 1,\n  \"timestamp\": %lld,\n  \"scale\": %g,\n  \"repeat\": %d,\n  \"cases\": [\n",
+			(long long)std::time(NULL), scale, repeat);
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const BenchmarkResult&  r = results[i];
+			const double  mb = r.file_bytes / (1024.0 * 1024.0);
+			fprintf(file,
+				"    {\"name\": \"%s\", \"description\": \"%s\", \"success\": %s, \"file_bytes\": %lld, \"max_line_bytes\": %zu, \"joints\": %d, \"channels\": %d, \"frames\": %d, "
+				"\"parse_seconds\": %.6f, \"parse_mb_per_s\": %.3f, \"reopen_seconds\": %.6f, \"reopen_mb_per_s\": %.3f, \"convert_seconds\": %.6f, \"convert_frames_per_s\": %.1f, "
+				"\"save_seconds\": %.6f, \"save_mb_per_s\": %.3f, \"peak_memory_mb\": %.1f}%s\n",
+				r.name.c_str(), r.description.c_str(), r.is_success ? "true" : "false", r.file_bytes, r.max_line_bytes, r.num_joints, r.num_channels, r.num_frames,
+				r.parse_seconds, Rate(mb, r.parse_seconds), r.reopen_seconds, Rate(mb, r.reopen_seconds), r.convert_seconds, Rate(r.num_frames, r.convert_seconds),
+				r.save_seconds, Rate(r.saved_bytes / (1024.0 * 1024.0), r.save_seconds), r.peak_memory_mb,
+				(i + 1 < results.size()) ? "," : "");
+		}
+		fprintf(file, "  ]\n}\n");
+		fclose(file);
+	}
+
+	bool  ReadOption(const char* arg, const char* name, std::string& value)
+	{
+		const size_t  length = strlen(name);
+		if (strncmp(arg, name, length) == 0 && arg[length] == '=')
+		{
+			value = arg + length + 1;
+			return  true;
+		}
+		return  false;
+	}
+}
+
+
+int  main(int argc, char** argv)
+{
+	std::string  selected;
+	std::string  dir = std::filesystem::temp_directory_path().string();
+	std::string  json_name = "bvh_benchmark.json";
+	double  scale = 1.0;
+	int     repeat = 3;
+	bool    keep_files = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string  value;
+		if (ReadOption(argv[i], "--case", value))
+		{
+			selected = "," + value + ",";
+		}
+		else if (ReadOption(argv[i], "--scale", value))
+		{
+			scale = atof(value.c_str());
+		}
+		else if (ReadOption(argv[i], "--repeat", value))
+		{
+			repeat = std::max(1, atoi(value.c_str()));
+		}
+		else if (ReadOption(argv[i], "--dir", value))
+		{
+			dir = value;
+		}
+		else if (ReadOption(argv[i], "--json", value))
+		{
+			json_name = value;
+		}
+		else if (strcmp(argv[i], "--keep") == 0)
+		{
+			keep_files = true;
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--case=<name>[,<name>...]] [--scale=1.0] [--repeat=3] [--dir=<temp dir>] [--json=<file>] [--keep]\n", argv[0]);
+			return  2;
+		}
+	}
+
+	std::vector< BenchmarkResult >  results;
+	bool  is_success = true;
+
+	printf("%-22s %10s %10s %11s %12s %10s %10s\n", "case", "MB", "parse MB/s", "reopen MB/s", "convert f/s", "save MB/s", "peak MB");
+	for (const BenchmarkCase& benchmark : MakeCases(scale))
+	{
+		if (!selected.empty() && selected.find("," + std::string(benchmark.name) + ",") == std::string::npos)
+		{
+			continue;
+		}
+
+		const BenchmarkResult  r = RunCase(benchmark, dir, repeat, keep_files);
+		results.push_back(r);
+		is_success = is_success && r.is_success;
+
+		const double  mb = r.file_bytes / (1024.0 * 1024.0);
+		printf("%-22s %10.1f %10.1f %11.1f %12.0f %10.1f %10.1f\n", r.name.c_str(), mb, Rate(mb, r.parse_seconds), Rate(mb, r.reopen_seconds),
+			Rate(r.num_frames, r.convert_seconds), Rate(r.saved_bytes / (1024.0 * 1024.0), r.save_seconds), r.peak_memory_mb);
+	}
+
+	WriteJson(json_name, results, scale, repeat);
+	return  is_success ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+#include "BVHSyntheticFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+
+namespace
+{
+	struct  SyntheticChannel
+	{
+		bool    is_position;
+		double  base;
+		double  amplitude;
+		double  frequency;
+		double  phase;
+	};
+
+	// Deterministic across platforms, unlike the distributions of <random>
+	class  Random
+	{
+		unsigned long long  state;
+
+	public:
+		explicit Random(unsigned seed) : state(seed * 6364136223846793005ULL + 1442695040888963407ULL) {}
+
+		double  Next()
+		{
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			return  (double)(state >> 11) / (double)(1ULL << 53);
+		}
+
+		double  Range(double low, double high) { return  low + (high - low) * Next(); }
+	};
+
+	void  AppendIndent(std::string& text, int depth)
+	{
+		text.append((size_t)depth, '\t');
+	}
+
+	void  AppendLine(std::string& text, const char* line, const FBVHSyntheticSettings& settings)
+	{
+		text.append(line);
+		text.append(settings.crlf ? "\r\n" : "\n");
+	}
+
+	void  AppendChannels(std::string& text, bool has_position, const FBVHSyntheticSettings& settings)
+	{
+		std::string  rotations;
+		for (char axis : settings.rotation_order)
+		{
+			rotations += ' ';
+			rotations += axis;
+			rotations += "rotation";
+		}
+		const char*  positions = " Xposition Yposition Zposition";
+
+		char  count[32];
+		snprintf(count, sizeof(count), "CHANNELS %d", has_position ? 6 : 3);
+		text.append(count);
+		if (has_position && !settings.positions_last)
+		{
+			text.append(positions);
+		}
+		text.append(rotations);
+		if (has_position && settings.positions_last)
+		{
+			text.append(positions);
+		}
+		text.append(settings.crlf ? "\r\n" : "\n");
+	}
+}
+
+
+int  GetSyntheticNumChannels(const FBVHSyntheticSettings& settings)
+{
+	return  settings.all_positions ? settings.num_joints * 6 : settings.num_joints * 3 + 3;
+}
+
+bool  WriteSyntheticBVH(const std::string& file_name, const FBVHSyntheticSettings& settings, size_t* max_line_bytes)
+{
+	const int  num_joints = settings.num_joints > 0 ? settings.num_joints : 1;
+	const int  branching = settings.branching > 0 ? settings.branching : 1;
+
+	// Joint i is a child of (i - 1) / branching, written depth first so the file order is the channel order
+	std::vector< std::vector< int > >  children(num_joints);
+	for (int i = 1; i < num_joints; i++)
+	{
+		children[(i - 1) / branching].push_back(i);
+	}
+
+	Random  random(settings.seed);
+	std::vector< SyntheticChannel >  channels;
+	std::string  text;
+	AppendLine(text, "HIERARCHY", settings);
+
+	struct  StackEntry { int joint; int depth; size_t next_child; };
+	std::vector< StackEntry >  stack;
+	stack.push_back({ 0, 0, 0 });
+
+	char  line[256];
+	while (!stack.empty())
+	{
+		StackEntry&  entry = stack.back();
+		const int    depth = entry.depth;
+		const int    joint = entry.joint;
+
+		if (entry.next_child == 0)
+		{
+			const bool  has_position = (joint == 0) || settings.all_positions;
+
+			AppendIndent(text, depth);
+			snprintf(line, sizeof(line), "%s J%d", joint == 0 ? "ROOT" : "JOINT", joint);
+			AppendLine(text, line, settings);
+			AppendIndent(text, depth);
+			AppendLine(text, "{", settings);
+			AppendIndent(text, depth + 1);
+			snprintf(line, sizeof(line), "OFFSET %.6f %.6f %.6f", random.Range(-10.0, 10.0), random.Range(0.0, 20.0), random.Range(-10.0, 10.0));
+			AppendLine(text, line, settings);
+			AppendIndent(text, depth + 1);
+			AppendChannels(text, has_position, settings);
+
+			for (int c = 0; c < 6; c++)
+			{
+				const bool  is_position = settings.positions_last ? (c >= 3) : (c < 3);
+				if (is_position && !has_position)
+				{
+					continue;
+				}
+				SyntheticChannel  channel;
+				channel.is_position = is_position;
+				channel.base = is_position ? random.Range(-100.0, 100.0) : random.Range(-30.0, 30.0);
+				channel.amplitude = is_position ? random.Range(0.0, 50.0) : random.Range(0.0, 90.0);
+				channel.frequency = random.Range(0.5, 3.0);
+				channel.phase = random.Range(0.0, 6.283185307179586);
+				channels.push_back(channel);
+			}
+
+			if (children[joint].empty())
+			{
+				AppendIndent(text, depth + 1);
+				AppendLine(text, "End Site", settings);
+				AppendIndent(text, depth + 1);
+				AppendLine(text, "{", settings);
+				AppendIndent(text, depth + 2);
+				AppendLine(text, "OFFSET 0.000000 5.000000 0.000000", settings);
+				AppendIndent(text, depth + 1);
+				AppendLine(text, "}", settings);
+			}
+		}
+
+		if (entry.next_child < children[joint].size())
+		{
+			const int  child = children[joint][entry.next_child++];
+			stack.push_back({ child, depth + 1, 0 });
+			continue;
+		}
+
+		AppendIndent(text, depth);
+		AppendLine(text, "}", settings);
+		stack.pop_back();
+	}
+
+	const double  frame_time = 1.0 / 120.0;
+	AppendLine(text, "MOTION", settings);
+	snprintf(line, sizeof(line), "Frames: %d", settings.num_frames);
+	AppendLine(text, line, settings);
+	snprintf(line, sizeof(line), "Frame Time: %.6f", frame_time);
+	AppendLine(text, line, settings);
+
+	FILE*  file = fopen(file_name.c_str(), "wb");
+	if (file == NULL)
+	{
+		return  false;
+	}
+	bool  is_success = fwrite(text.data(), 1, text.size(), file) == text.size();
+
+	char  format[16];
+	snprintf(format, sizeof(format), "%%.%d%c", settings.precision, settings.scientific ? 'e' : 'f');
+
+	// Written a line at a time, a frame line can be far larger than any read block of the parser
+	std::string  frame_line;
+	size_t  longest_line = 0;
+	char  value[64];
+	for (int f = 0; f < settings.num_frames && is_success; f++)
+	{
+		const double  time = f * frame_time;
+		frame_line.clear();
+		for (size_t c = 0; c < channels.size(); c++)
+		{
+			const SyntheticChannel&  channel = channels[c];
+			const double  v = channel.base + channel.amplitude * std::sin(channel.frequency * time + channel.phase);
+			const int  length = snprintf(value, sizeof(value), format, v);
+			if (c > 0)
+			{
+				frame_line += settings.separator;
+			}
+			frame_line.append(value, (size_t)length);
+		}
+		frame_line.append(settings.crlf ? "\r\n" : "\n");
+		longest_line = std::max(longest_line, frame_line.size());
+		is_success = fwrite(frame_line.data(), 1, frame_line.size(), file) == frame_line.size();
+	}
+
+	if (max_line_bytes != NULL)
+	{
+		*max_line_bytes = longest_line;
+	}
+	return  (fclose(file) == 0) && is_success;
+}
@@ -0,0 +1,32 @@
+#ifndef  _BVH_SYNTHETIC_FILE_H_
+#define  _BVH_SYNTHETIC_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+//
+//  Writes BVH files of any size and shape for the benchmarks, with smooth pseudo random motion.
+//  The text is formatted here rather than with FBVHFile::Save(), so the parser is not only fed what the writer produces.
+//
+struct  FBVHSyntheticSettings
+{
+	int          num_joints = 24;
+	int          branching = 3;              // children per joint, 1 makes a single chain
+	int          num_frames = 1000;
+	bool         all_positions = false;      // every joint has 6 channels, otherwise only the root has positions
+	bool         positions_last = false;     // rotation channels before position channels
+	std::string  rotation_order = "ZXY";     // order of the rotation channels, any permutation of XYZ
+	int          precision = 6;              // digits after the decimal point
+	bool         scientific = false;         // %e instead of fixed notation
+	char         separator = ' ';            // between values, ' ' or '\t'
+	bool         crlf = false;               // Windows line breaks
+	unsigned     seed = 1;
+};
+
+// Returns false when the file cannot be written, max_line_bytes receives the length of the longest line
+bool  WriteSyntheticBVH(const std::string& file_name, const FBVHSyntheticSettings& settings, size_t* max_line_bytes = NULL);
+
+// Number of channels of a file written with the settings
+int  GetSyntheticNumChannels(const FBVHSyntheticSettings& settings);
+
+#endif // _BVH_SYNTHETIC_FILE_H_
@@ -28,6 +28,7 @@ public class BVHPlugin : ModuleRules
 				"Core",
 				"CoreUObject",
 				"AnimationCore",
+				"BVHRuntime",
 				"Engine",
 				"InputCore",
 				"Slate",
@@ -36,8 +37,15 @@ public class BVHPlugin : ModuleRules
 				"UnrealEd",
 				"MainFrame",
 				"PropertyEditor",
+				"Json",
+				"DerivedDataCache",
+				"AssetRegistry",
+				"AnimGraph",
+				"BlueprintGraph",
 				"RenderCore",
-				"RHI"
+				"RHI",
+				"DeveloperSettings",
+				"EditorSubsystem"
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -50,6 +58,8 @@ public class BVHPlugin : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
+				"MessageLog",
+				"Projects",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
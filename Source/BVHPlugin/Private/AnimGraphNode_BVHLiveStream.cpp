@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimGraphNode_BVHLiveStream.h"
+
+#define LOCTEXT_NAMESPACE "AnimGraphNode_BVHLiveStream"
+
+UAnimGraphNode_BVHLiveStream::UAnimGraphNode_BVHLiveStream(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+FText UAnimGraphNode_BVHLiveStream::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (TitleType == ENodeTitleType::ListView || TitleType == ENodeTitleType::MenuTitle)
+	{
+		return LOCTEXT("NodeTitle", "BVH Live Stream");
+	}
+	return FText::Format(LOCTEXT("NodeTitleWithEndpoint", "BVH Live Stream\n{0}:{1}"), FText::FromString(Node.Host), FText::AsNumber(Node.Port, &FNumberFormattingOptions::DefaultNoGrouping()));
+}
+
+FText UAnimGraphNode_BVHLiveStream::GetTooltipText() const
+{
+	return LOCTEXT("NodeTooltip", "Pose received from a live BVH stream over TCP or UDP");
+}
+
+FLinearColor UAnimGraphNode_BVHLiveStream::GetNodeTitleColor() const
+{
+	return FLinearColor(0.75f, 0.4f, 0.1f);
+}
+
+FString UAnimGraphNode_BVHLiveStream::GetNodeCategory() const
+{
+	return TEXT("BVH");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimGraphNode_BVHMotionPlayer.h"
+
+#include "BVHMotionAsset.h"
+
+#define LOCTEXT_NAMESPACE "AnimGraphNode_BVHMotionPlayer"
+
+UAnimGraphNode_BVHMotionPlayer::UAnimGraphNode_BVHMotionPlayer(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+FText UAnimGraphNode_BVHMotionPlayer::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (TitleType == ENodeTitleType::ListView || TitleType == ENodeTitleType::MenuTitle || Node.Motion == nullptr)
+	{
+		return LOCTEXT("NodeTitle", "Play BVH Motion");
+	}
+	return FText::Format(LOCTEXT("NodeTitleWithMotion", "Play BVH Motion\n{0}"), FText::FromString(Node.Motion->GetName()));
+}
+
+FText UAnimGraphNode_BVHMotionPlayer::GetTooltipText() const
+{
+	return LOCTEXT("NodeTooltip", "Plays a BVH file without importing it, only the played frames are evaluated");
+}
+
+FLinearColor UAnimGraphNode_BVHMotionPlayer::GetNodeTitleColor() const
+{
+	return FLinearColor(0.75f, 0.4f, 0.1f);
+}
+
+FString UAnimGraphNode_BVHMotionPlayer::GetNodeCategory() const
+{
+	return TEXT("BVH");
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,30 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHAnimSequenceExporter.h"
+
+#include "Animation/AnimSequence.h"
+
+#include "BVHAnimExporter.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHAnimSequenceExporter)
+
+UBVHAnimSequenceExporter::UBVHAnimSequenceExporter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SupportedClass = UAnimSequence::StaticClass();
+	bText = false;
+	PreferredFormatIndex = 0;
+	FormatExtension.Add(TEXT("bvh"));
+	FormatDescription.Add(TEXT("Biovision Hierarchy"));
+}
+
+bool UBVHAnimSequenceExporter::SupportsObject(UObject* Object) const
+{
+	const UAnimSequence* Sequence = Cast<UAnimSequence>(Object);
+	return Sequence && Sequence->GetSkeleton();
+}
+
+bool UBVHAnimSequenceExporter::ExportBinary(UObject* Object, const TCHAR* Type, FArchive& Ar, FFeedbackContext* Warn, int32 FileIndex, uint32 PortFlags)
+{
+	return FBVHAnimExporter::ExportToArchive(CastChecked<UAnimSequence>(Object), Ar);
+}
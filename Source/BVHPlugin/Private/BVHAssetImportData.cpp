@@ -1,12 +1,48 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "BVHAssetImportData.h"
+#include "Animation/AnimSequence.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(BVHAssetImportData)
 
 UBVHAssetImportData::UBVHAssetImportData(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
+	SamplingHash = 0;
+	bIsClip = false;
+	FrameStart = 0;
+	FrameEnd = 0;
+	FrameNum = 0;
+	bIsMirrored = false;
+	MirrorAxis = EAxis::X;
+}
 
+bool UBVHAssetImportData::HasTrimmedRange() const
+{
+	if (bIsClip)
+	{
+		return true;
+	}
+	const bool bToLastFrame = FrameEnd < FrameStart || FrameEnd >= FrameNum - 1;
+	return FrameNum > 0 && (FrameStart > 0 || !bToLastFrame);
 }
 
+UBVHAssetImportData* UBVHAssetImportData::GetImportDataForSequence(UAnimSequence* Sequence)
+{
+	check(Sequence);
+
+	UBVHAssetImportData* ImportData = Cast<UBVHAssetImportData>(Sequence->AssetImportData);
+	if (ImportData == nullptr)
+	{
+		ImportData = NewObject<UBVHAssetImportData>(Sequence, NAME_None, RF_NoFlags);
+
+		// Keep the source file list of the previous import data
+		if (Sequence->AssetImportData != nullptr)
+		{
+			ImportData->SourceData = Sequence->AssetImportData->SourceData;
+		}
+		Sequence->AssetImportData = ImportData;
+	}
+
+	return ImportData;
+}
@@ -0,0 +1,183 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHDiffCommandlet.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "BVHDiff.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHDiffCommandlet)
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHDiffCommandlet, Log, All);
+
+namespace BVHDiffCommandlet
+{
+	/** Result of a pair of files, bLoaded is false when either could not be read */
+	struct FPairResult
+	{
+		bool bLoaded = false;
+		FBVHDiffResult Diff;
+	};
+
+	/** Pairs every BVH file under DirA with the file at the same relative path under DirB */
+	static void FindPairs(const FString& DirA, const FString& DirB, TArray<FString>& OutFilesA, TArray<FString>& OutFilesB)
+	{
+		IFileManager::Get().FindFilesRecursive(OutFilesA, *DirA, TEXT("*.bvh"), true, false, false);
+		IFileManager::Get().FindFilesRecursive(OutFilesA, *DirA, TEXT("*.bvh.gz"), true, false, false);
+		OutFilesA.Sort();
+
+		for (const FString& FileA : OutFilesA)
+		{
+			FString RelativePath = FileA;
+			FPaths::MakePathRelativeTo(RelativePath, *(DirA / TEXT("")));
+			OutFilesB.Add(DirB / RelativePath);
+		}
+	}
+
+	static void LogResult(const FString& FileA, const FString& FileB, const FPairResult& Result)
+	{
+		if (!Result.bLoaded)
+		{
+			UE_LOG(LogBVHDiffCommandlet, Error, TEXT("%s: could not be compared with %s."), *FileA, *FileB);
+			return;
+		}
+
+		const FBVHDiffResult& Diff = Result.Diff;
+		if (Diff.IsEqual())
+		{
+			UE_LOG(LogBVHDiffCommandlet, Log, TEXT("%s: equal."), *FileA);
+			return;
+		}
+
+		UE_LOG(LogBVHDiffCommandlet, Display, TEXT("%s: %d structural differences, %d of %d channels over tolerance, %d with NaN values."), *FileA,
+			Diff.StructuralDifferences.Num(), Diff.NumChannelsOver, Diff.NumChannelsCompared, Diff.NumChannelsNaN);
+		for (const FString& Difference : Diff.StructuralDifferences)
+		{
+			UE_LOG(LogBVHDiffCommandlet, Display, TEXT("    %s"), *Difference);
+		}
+		for (const FBVHChannelDiff& Channel : Diff.WorstChannels)
+		{
+			UE_LOG(LogBVHDiffCommandlet, Display, TEXT("    %s: max %g at frame %d (%.1fx tolerance), %d frames over, %d NaN"),
+				*Channel.Name, Channel.MaxError, Channel.WorstFrame, Channel.Score, Channel.NumFramesOver, Channel.NumFramesNaN);
+		}
+		for (const FBVHFrameDiff& Frame : Diff.WorstFrames)
+		{
+			UE_LOG(LogBVHDiffCommandlet, Display, TEXT("    frame %d: %.1fx tolerance on %s"), Frame.Frame, Frame.Score, *Frame.WorstChannel);
+		}
+	}
+
+	static void AppendReportLine(const FString& FileA, const FPairResult& Result, FString& Report)
+	{
+		const FBVHDiffResult& Diff = Result.Diff;
+		const FBVHChannelDiff Worst = Diff.WorstChannels.Num() > 0 ? Diff.WorstChannels[0] : FBVHChannelDiff();
+		const TCHAR* Status = !Result.bLoaded ? TEXT("error") : (Diff.IsEqual() ? TEXT("equal") : TEXT("different"));
+		Report += FString::Printf(TEXT("\"%s\",%s,%d,%d,%d,%s,%g,%d\n"), *FileA, Status, Diff.StructuralDifferences.Num(), Diff.NumChannelsOver,
+			Diff.NumChannelsNaN, *Worst.Name, Worst.MaxError, Worst.WorstFrame);
+	}
+}
+
+UBVHDiffCommandlet::UBVHDiffCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UBVHDiffCommandlet::Main(const FString& Params)
+{
+	using namespace BVHDiffCommandlet;
+
+	FString PathA;
+	FString PathB;
+	FString ReportPath;
+	FString Tolerances;
+	int32 BatchSize = 16;
+	FBVHDiffSettings Settings;
+
+	FParse::Value(*Params, TEXT("A="), PathA);
+	FParse::Value(*Params, TEXT("B="), PathB);
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+	FParse::Value(*Params, TEXT("Tolerances="), Tolerances);
+	FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+	FParse::Value(*Params, TEXT("PositionTolerance="), Settings.PositionTolerance);
+	FParse::Value(*Params, TEXT("RotationTolerance="), Settings.RotationTolerance);
+	FParse::Value(*Params, TEXT("OffsetTolerance="), Settings.OffsetTolerance);
+	FParse::Value(*Params, TEXT("Worst="), Settings.NumWorst);
+	BatchSize = FMath::Max(BatchSize, 1);
+
+	if (PathA.IsEmpty() || PathB.IsEmpty())
+	{
+		UE_LOG(LogBVHDiffCommandlet, Error, TEXT("-A=<File|Dir> and -B=<File|Dir> are required."));
+		return 1;
+	}
+
+	TArray<FString> Overrides;
+	Tolerances.ParseIntoArray(Overrides, TEXT("+"));
+	for (const FString& Override : Overrides)
+	{
+		FString ChannelName;
+		FString Value;
+		if (!Override.Split(TEXT("="), &ChannelName, &Value) || !Value.IsNumeric())
+		{
+			UE_LOG(LogBVHDiffCommandlet, Error, TEXT("Invalid tolerance '%s', expected Joint.Channel=Value."), *Override);
+			return 1;
+		}
+		Settings.ChannelTolerances.Add(ChannelName, FCString::Atod(*Value));
+	}
+
+	TArray<FString> FilesA;
+	TArray<FString> FilesB;
+	if (IFileManager::Get().DirectoryExists(*PathA))
+	{
+		FindPairs(PathA, PathB, FilesA, FilesB);
+	}
+	else
+	{
+		FilesA.Add(PathA);
+		FilesB.Add(PathB);
+	}
+	if (FilesA.Num() == 0)
+	{
+		UE_LOG(LogBVHDiffCommandlet, Error, TEXT("No BVH files under %s."), *PathA);
+		return 1;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumDifferent = 0;
+	FString Report = TEXT("File,Status,StructuralDifferences,ChannelsOver,ChannelsNaN,WorstChannel,MaxError,WorstFrame\n");
+
+	// Pairs of a batch are loaded and compared in parallel, a batch bounds how many files are held at once
+	for (int32 BatchStart = 0; BatchStart < FilesA.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchNum = FMath::Min(BatchSize, FilesA.Num() - BatchStart);
+
+		TArray<FPairResult> Results;
+		Results.SetNum(BatchNum);
+		ParallelFor(BatchNum, [&](int32 Index)
+		{
+			Results[Index].bLoaded = FBVHDiff::CompareFiles(FilesA[BatchStart + Index], FilesB[BatchStart + Index], Settings, Results[Index].Diff);
+		});
+
+		for (int32 Index = 0; Index < BatchNum; ++Index)
+		{
+			const FPairResult& Result = Results[Index];
+			LogResult(FilesA[BatchStart + Index], FilesB[BatchStart + Index], Result);
+			AppendReportLine(FilesA[BatchStart + Index], Result, Report);
+			NumDifferent += Result.bLoaded && Result.Diff.IsEqual() ? 0 : 1;
+		}
+	}
+
+	if (!ReportPath.IsEmpty() && !FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(LogBVHDiffCommandlet, Error, TEXT("Failed to write %s."), *ReportPath);
+	}
+
+	UE_LOG(LogBVHDiffCommandlet, Display, TEXT("%d of %d files differ (%.1fs)"), NumDifferent, FilesA.Num(), FPlatformTime::Seconds() - StartTime);
+	return NumDifferent == 0 ? 0 : 1;
+}
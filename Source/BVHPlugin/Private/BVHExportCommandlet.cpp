@@ -0,0 +1,116 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHExportCommandlet.h"
+
+#include "Animation/AnimSequence.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+
+#include "BVHAnimExporter.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHExportCommandlet)
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHExportCommandlet, Log, All);
+
+UBVHExportCommandlet::UBVHExportCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UBVHExportCommandlet::Main(const FString& Params)
+{
+	FString SourcePath;
+	FString DestDir;
+	int32 Precision = 6;
+	int32 BatchSize = 64;
+
+	FParse::Value(*Params, TEXT("Source="), SourcePath);
+	FParse::Value(*Params, TEXT("Dest="), DestDir);
+	FParse::Value(*Params, TEXT("Precision="), Precision);
+	FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+	const bool bCompress = FParse::Param(*Params, TEXT("Compress"));
+	BatchSize = FMath::Max(BatchSize, 1);
+
+	if (SourcePath.IsEmpty() || DestDir.IsEmpty())
+	{
+		UE_LOG(LogBVHExportCommandlet, Error, TEXT("-Source=<PackagePath> and -Dest=<Dir> are required, e.g. -Source=/Game/Mocap -Dest=D:/Export."));
+		return 1;
+	}
+	SourcePath.RemoveFromEnd(TEXT("/"));
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.PackagePaths.Add(FName(*SourcePath));
+	Filter.bRecursivePaths = true;
+	Filter.ClassPaths.Add(UAnimSequence::StaticClass()->GetClassPathName());
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssets(Filter, Assets);
+	if (Assets.Num() == 0)
+	{
+		UE_LOG(LogBVHExportCommandlet, Error, TEXT("No animation sequences under %s."), *SourcePath);
+		return 1;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumFailed = 0;
+
+	for (int32 BatchStart = 0; BatchStart < Assets.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchNum = FMath::Min(BatchSize, Assets.Num() - BatchStart);
+
+		// Loading has to happen on the game thread
+		TArray<UAnimSequence*> Sequences;
+		TArray<FString> Filenames;
+		Sequences.SetNumZeroed(BatchNum);
+		Filenames.SetNum(BatchNum);
+		for (int32 Index = 0; Index < BatchNum; ++Index)
+		{
+			const FAssetData& Asset = Assets[BatchStart + Index];
+			Sequences[Index] = Cast<UAnimSequence>(Asset.GetAsset());
+
+			FString RelativePath = Asset.PackagePath.ToString();
+			RelativePath.RemoveFromStart(SourcePath);
+			Filenames[Index] = FPaths::Combine(DestDir, RelativePath, Asset.AssetName.ToString() + (bCompress ? TEXT(".bvh.gz") : TEXT(".bvh")));
+			IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filenames[Index]), true);
+		}
+
+		// Sampling and writing only read the sequences
+		TArray<bool> Exported;
+		Exported.SetNumZeroed(BatchNum);
+		ParallelFor(BatchNum, [&](int32 Index)
+		{
+			Exported[Index] = Sequences[Index] && FBVHAnimExporter::ExportToFile(Sequences[Index], Filenames[Index], Precision);
+		});
+
+		for (int32 Index = 0; Index < BatchNum; ++Index)
+		{
+			if (!Exported[Index])
+			{
+				UE_LOG(LogBVHExportCommandlet, Error, TEXT("Failed to export %s."), *Assets[BatchStart + Index].GetObjectPathString());
+				++NumFailed;
+			}
+		}
+
+		UE_LOG(LogBVHExportCommandlet, Display, TEXT("Exported %d/%d"), BatchStart + BatchNum, Assets.Num());
+
+		// Exported sequences are no longer needed, drop them before the next batch to keep memory flat
+		Sequences.Reset();
+		CollectGarbage(RF_NoFlags);
+	}
+
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogBVHExportCommandlet, Display, TEXT("Exported %d sequences (%d failed) in %.2fs: %.2f sequences/s"),
+		Assets.Num(), NumFailed, TotalSeconds, Assets.Num() / FMath::Max(TotalSeconds, UE_SMALL_NUMBER));
+
+	return NumFailed == 0 ? 0 : 1;
+}
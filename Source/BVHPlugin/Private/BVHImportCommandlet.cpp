@@ -0,0 +1,313 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHImportCommandlet.h"
+
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "FileHelpers.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ObjectTools.h"
+#include "PackageTools.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+
+#include "BVHAnimConverter.h"
+#include "BVHFile.h"
+#include "BVHImportContext.h"
+#include "BVHImportFactory.h"
+#include "BVHImportSettings.h"
+#include "BVHTrackCache.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHImportCommandlet)
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHImportCommandlet, Log, All);
+
+namespace BVHImportCommandlet
+{
+	/** Timings and outcome of a single file, written to the report */
+	struct FFileResult
+	{
+		FString Filename;
+		FString AssetPath;
+		int64 SizeBytes = 0;
+		double ParseSeconds = 0.0;
+		double ConvertSeconds = 0.0;
+		double CommitSeconds = 0.0;
+		bool bFromCache = false;
+		bool bSucceeded = false;
+	};
+
+	static bool WriteReport(const FString& ReportPath, const TArray<FFileResult>& Results, double TotalSeconds, uint64 PeakUsedPhysical)
+	{
+		int64 TotalBytes = 0;
+		int32 NumFailed = 0;
+
+		TArray<TSharedPtr<FJsonValue>> FileValues;
+		for (const FFileResult& Result : Results)
+		{
+			TotalBytes += Result.SizeBytes;
+			NumFailed += Result.bSucceeded ? 0 : 1;
+
+			TSharedRef<FJsonObject> FileObject = MakeShared<FJsonObject>();
+			FileObject->SetStringField(TEXT("file"), Result.Filename);
+			FileObject->SetStringField(TEXT("asset"), Result.AssetPath);
+			FileObject->SetNumberField(TEXT("bytes"), Result.SizeBytes);
+			FileObject->SetNumberField(TEXT("parse_s"), Result.ParseSeconds);
+			FileObject->SetNumberField(TEXT("convert_s"), Result.ConvertSeconds);
+			FileObject->SetNumberField(TEXT("commit_s"), Result.CommitSeconds);
+			FileObject->SetBoolField(TEXT("cached"), Result.bFromCache);
+			FileObject->SetBoolField(TEXT("succeeded"), Result.bSucceeded);
+			FileValues.Add(MakeShared<FJsonValueObject>(FileObject));
+		}
+
+		const double SafeSeconds = FMath::Max(TotalSeconds, UE_SMALL_NUMBER);
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetNumberField(TEXT("files"), Results.Num());
+		Root->SetNumberField(TEXT("failed"), NumFailed);
+		Root->SetNumberField(TEXT("total_s"), TotalSeconds);
+		Root->SetNumberField(TEXT("files_per_s"), Results.Num() / SafeSeconds);
+		Root->SetNumberField(TEXT("mb_per_s"), (TotalBytes / (1024.0 * 1024.0)) / SafeSeconds);
+		Root->SetNumberField(TEXT("peak_used_physical_mb"), PeakUsedPhysical / (1024.0 * 1024.0));
+		Root->SetNumberField(TEXT("shared_hierarchies"), FBVHFile::GetHierarchyCacheHits());
+		Root->SetArrayField(TEXT("per_file"), FileValues);
+
+		UE_LOG(LogBVHImportCommandlet, Display, TEXT("Imported %d files (%d failed) in %.2fs: %.2f files/s, %.2f MB/s, peak memory %.1f MB, %d shared hierarchies"),
+			Results.Num(), NumFailed, TotalSeconds, Results.Num() / SafeSeconds, (TotalBytes / (1024.0 * 1024.0)) / SafeSeconds, PeakUsedPhysical / (1024.0 * 1024.0), FBVHFile::GetHierarchyCacheHits());
+
+		if (ReportPath.IsEmpty())
+		{
+			return true;
+		}
+
+		FString Output;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+		FJsonSerializer::Serialize(Root, Writer);
+		return FFileHelper::SaveStringToFile(Output, *ReportPath);
+	}
+
+	/**
+	* Content folder and sequence name of a source file: its subfolder of RootDir under DestPath, and its motion name
+	* with a numbered suffix when another file of the run already took it, so same named takes of different folders do not overwrite each other.
+	*/
+	static void MakeUniqueSequencePath(const FString& DestPath, const FString& RootDir, const FString& Filename, const FString& MotionName, TSet<FString>& UsedPaths, FString& OutFolder, FString& OutName)
+	{
+		FString RelativeDirectory = FPaths::GetPath(Filename);
+		if (RootDir.IsEmpty() || !FPaths::MakePathRelativeTo(RelativeDirectory, *(RootDir / TEXT(""))) || RelativeDirectory.StartsWith(TEXT("..")))
+		{
+			RelativeDirectory.Reset();
+		}
+		OutFolder = RelativeDirectory.IsEmpty() ? DestPath : UPackageTools::SanitizePackageName(DestPath / RelativeDirectory);
+
+		const FString BaseName = ObjectTools::SanitizeObjectName(MotionName);
+		OutName = BaseName;
+		for (int32 Suffix = 2; UsedPaths.Contains(OutFolder / OutName); ++Suffix)
+		{
+			OutName = FString::Printf(TEXT("%s_%d"), *BaseName, Suffix);
+		}
+		UsedPaths.Add(OutFolder / OutName);
+	}
+}
+
+UBVHImportCommandlet::UBVHImportCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+bool UBVHImportCommandlet::GatherSourceFiles(const FString& Params, TArray<FString>& OutFiles, FString& OutRootDir) const
+{
+	FString SourceDir;
+	FString ManifestPath;
+
+	if (FParse::Value(*Params, TEXT("Source="), SourceDir))
+	{
+		OutRootDir = SourceDir;
+		IFileManager::Get().FindFilesRecursive(OutFiles, *SourceDir, TEXT("*.bvh"), true, false, false);
+		IFileManager::Get().FindFilesRecursive(OutFiles, *SourceDir, TEXT("*.bvh.gz"), true, false, false);
+	}
+	else if (FParse::Value(*Params, TEXT("Manifest="), ManifestPath))
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *ManifestPath))
+		{
+			UE_LOG(LogBVHImportCommandlet, Error, TEXT("Failed to read manifest %s."), *ManifestPath);
+			return false;
+		}
+
+		const FString ManifestDir = FPaths::GetPath(ManifestPath);
+		OutRootDir = ManifestDir;
+		for (FString& Line : Lines)
+		{
+			Line.TrimStartAndEndInline();
+			if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+			{
+				continue;
+			}
+			OutFiles.Add(FPaths::IsRelative(Line) ? FPaths::Combine(ManifestDir, Line) : Line);
+		}
+	}
+	else
+	{
+		UE_LOG(LogBVHImportCommandlet, Error, TEXT("Either -Source=<Dir> or -Manifest=<File> is required."));
+		return false;
+	}
+
+	OutFiles.Sort();
+	return OutFiles.Num() > 0;
+}
+
+int32 UBVHImportCommandlet::Main(const FString& Params)
+{
+	using namespace BVHImportCommandlet;
+
+	FString SkeletonPath;
+	FString DestPath;
+	FString ReportPath;
+	int32 BatchSize = 64;
+
+	FParse::Value(*Params, TEXT("Skeleton="), SkeletonPath);
+	FParse::Value(*Params, TEXT("Dest="), DestPath);
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+	FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+	BatchSize = FMath::Max(BatchSize, 1);
+
+	if (DestPath.IsEmpty() || !FPackageName::IsValidLongPackageName(DestPath))
+	{
+		UE_LOG(LogBVHImportCommandlet, Error, TEXT("-Dest=<LongPackagePath> is required, e.g. -Dest=/Game/Mocap."));
+		return 1;
+	}
+
+	USkeleton* Skeleton = LoadObject<USkeleton>(nullptr, *SkeletonPath);
+	if (Skeleton == nullptr)
+	{
+		UE_LOG(LogBVHImportCommandlet, Error, TEXT("Failed to load skeleton '%s'."), *SkeletonPath);
+		return 1;
+	}
+
+	TArray<FString> Files;
+	FString RootDir;
+	if (!GatherSourceFiles(Params, Files, RootDir))
+	{
+		UE_LOG(LogBVHImportCommandlet, Error, TEXT("No BVH files to import."));
+		return 1;
+	}
+
+	// Keep everything used across batches alive, garbage is collected between batches
+	Skeleton->AddToRoot();
+	UBVHImportFactory* Factory = NewObject<UBVHImportFactory>();
+	Factory->AddToRoot();
+
+	// Conversion only reads these, the worker threads never touch a UObject
+	const FReferenceSkeleton RefSkeleton = Skeleton->GetReferenceSkeleton();
+	FBVHImportSnapshot SharedSettings = GetDefault<UBVHImportSettings>()->MakeSnapshot();
+	SharedSettings.Skeleton = Skeleton;
+
+	TArray<FFileResult> Results;
+	Results.SetNum(Files.Num());
+
+	// Counts the files of this run that reuse the hierarchy of an earlier one
+	FBVHFile::ClearHierarchyCache();
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Sequences of the run, one per content path
+	TSet<FString> UsedPaths;
+
+	// Kept across batches, a file converted into the slot of an earlier one rewrites its key arrays in place
+	TArray<FBVHConvertedAnimation> Animations;
+	TArray<bool> Converted;
+
+	for (int32 BatchStart = 0; BatchStart < Files.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchNum = FMath::Min(BatchSize, Files.Num() - BatchStart);
+
+		Animations.SetNum(BatchNum);
+		Converted.Reset();
+		Converted.SetNumZeroed(BatchNum);
+
+		// Parse and convert on the worker pool, each worker reuses the motion buffer of a pooled import context
+		ParallelFor(BatchNum, [&](int32 Index)
+		{
+			Converted[Index] = FBVHTrackCache::ConvertFile(Files[BatchStart + Index], RefSkeleton, SharedSettings, Animations[Index]);
+		});
+
+		// Create the assets on the game thread, without transactions, the batch is compressed in parallel at its end
+		TArray<UPackage*> PackagesToSave;
+		Factory->BeginBatchCommit();
+		for (int32 Index = 0; Index < BatchNum; ++Index)
+		{
+			FBVHConvertedAnimation& Animation = Animations[Index];
+			FFileResult& Result = Results[BatchStart + Index];
+			Result.Filename = Files[BatchStart + Index];
+			Result.SizeBytes = Animation.SourceSize;
+			Result.ParseSeconds = Animation.ParseSeconds;
+			Result.ConvertSeconds = Animation.ConvertSeconds;
+			Result.bFromCache = Animation.bFromCache;
+
+			if (!Converted[Index])
+			{
+				continue;
+			}
+
+			const double CommitStart = FPlatformTime::Seconds();
+
+			// The sequence is named after the motion, the mirrored one after it
+			FString Folder;
+			FString SequenceName;
+			MakeUniqueSequencePath(DestPath, RootDir, Result.Filename, Animation.Settings.MotionName, UsedPaths, Folder, SequenceName);
+			Animation.Settings.MotionName = SequenceName;
+
+			UPackage* Outer = CreatePackage(*(Folder / SequenceName));
+			UAnimSequence* MirroredSequence = nullptr;
+			UAnimSequence* Sequence = Factory->CommitAnimation(Animation, Skeleton, Outer, &MirroredSequence);
+
+			Result.CommitSeconds = FPlatformTime::Seconds() - CommitStart;
+			Result.bSucceeded = Sequence != nullptr;
+			if (Sequence)
+			{
+				Result.AssetPath = Sequence->GetPathName();
+				PackagesToSave.Add(Sequence->GetPackage());
+			}
+			if (MirroredSequence)
+			{
+				PackagesToSave.Add(MirroredSequence->GetPackage());
+			}
+		}
+
+		Factory->EndBatchCommit();
+		UEditorLoadingAndSavingUtils::SavePackages(PackagesToSave, true);
+
+		UE_LOG(LogBVHImportCommandlet, Display, TEXT("Imported %d/%d"), BatchStart + BatchNum, Files.Num());
+
+		// Saved sequences are no longer needed, drop them before the next batch to keep memory flat
+		Factory->CreatedObjects.Reset();
+		Factory->AdditionalImportedObjects.Reset();
+		CollectGarbage(RF_NoFlags);
+	}
+
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FBVHImportContext::Trim();
+	Factory->RemoveFromRoot();
+	Skeleton->RemoveFromRoot();
+
+	const bool bReportWritten = WriteReport(ReportPath, Results, TotalSeconds, FPlatformMemory::GetStats().PeakUsedPhysical);
+	if (!bReportWritten)
+	{
+		UE_LOG(LogBVHImportCommandlet, Error, TEXT("Failed to write report %s."), *ReportPath);
+	}
+
+	const bool bAllSucceeded = !Results.ContainsByPredicate([](const FFileResult& Result) { return !Result.bSucceeded; });
+	return (bAllSucceeded && bReportWritten) ? 0 : 1;
+}
@@ -1,8 +1,10 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "BVHImportFactory.h"
+#include "AssetCompilingManager.h"
 #include "AssetImportTask.h"
 #include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/Async.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/SkeletalMesh.h"
 #include "Editor.h"
@@ -10,13 +12,23 @@
 #include "HAL/FileManager.h"
 #include "Framework/Application/SlateApplication.h"
 #include "Interfaces/IMainFrameModule.h"
+#include "Logging/MessageLog.h"
 #include "Math/UnrealMathUtility.h"
+#include "Misc/PackageName.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/ScopedSlowTask.h"
+#include "ProfilingDebugging/ScopedTimers.h"
 
 #include "BVHImportOptions.h"
 #include "BVHImporter.h"
 #include "BVHImportSettings.h"
 #include "BVHAssetImportData.h"
+#include "BVHAnimConverter.h"
 #include "BVHFile.h"
+#include "BVHImportContext.h"
+#include "BVHPlugin.h"
+#include "BVHStats.h"
+#include "BVHTrackCache.h"
 
 #include "Subsystems/AssetEditorSubsystem.h"
 
@@ -31,6 +43,47 @@
 
 DEFINE_LOG_CATEGORY_STATIC(LogBvhImporter, Verbose, All);
 
+namespace BVHImportFactory
+{
+	static double PerSecond(double Amount, double Seconds)
+	{
+		return Seconds > 0.0 ? Amount / Seconds : 0.0;
+	}
+
+	/** Writes where the time of a written sequence went to the BVH Import message log, one line per sequence */
+	static void ReportImport(const UAnimSequence* Sequence, const FBVHConvertedAnimation& Animation, double KeysSeconds, double FinalizeSeconds, bool bDeferred)
+	{
+		const double SourceMB = Animation.SourceSize / (1024.0 * 1024.0);
+		const double NumKeys = double(Animation.NumKeys) * Animation.Tracks.Num();
+		const double TotalSeconds = Animation.ParseSeconds + Animation.ConvertSeconds + KeysSeconds + FinalizeSeconds;
+
+		const FString Summary = FString::Printf(TEXT("%s: %.1f MB, %d frames, %d tracks%s. Open %.1f ms (%.1f MB/s), convert %.1f ms%s (%.0f keys/s), set keys %.1f ms (%.0f keys/s), finalize %.1f ms%s, total %.1f ms."),
+			*Sequence->GetName(), SourceMB, Animation.NumKeys, Animation.Tracks.Num(), Animation.bIsMirrored ? TEXT(" (mirrored)") : TEXT(""),
+			Animation.ParseSeconds * 1000.0, PerSecond(SourceMB, Animation.ParseSeconds),
+			Animation.ConvertSeconds * 1000.0, Animation.bFromCache ? TEXT(" from cache") : TEXT(""), PerSecond(NumKeys, Animation.ConvertSeconds),
+			KeysSeconds * 1000.0, PerSecond(NumKeys, KeysSeconds),
+			FinalizeSeconds * 1000.0, bDeferred ? TEXT(" (compression deferred)") : TEXT(""), TotalSeconds * 1000.0);
+		FMessageLog(FBVHPluginModule::ImportLogName).Info(FText::FromString(Summary));
+	}
+
+	/** The mirrored sequence imported next to a sequence from the same source, nullptr when there is none */
+	static UAnimSequence* FindMirroredSequence(const UAnimSequence* Sequence, const FString& Filename)
+	{
+		const FString MirroredName = Sequence->GetName() + FBVHAnimConverter::MirroredSuffix;
+		const FString PackageName = FPackageName::GetLongPackagePath(Sequence->GetPackage()->GetName()) / MirroredName;
+		const FString ObjectPath = PackageName + TEXT(".") + MirroredName;
+
+		UAnimSequence* MirroredSequence = FindObject<UAnimSequence>(nullptr, *ObjectPath);
+		if (MirroredSequence == nullptr && FPackageName::DoesPackageExist(PackageName))
+		{
+			MirroredSequence = LoadObject<UAnimSequence>(nullptr, *ObjectPath, nullptr, LOAD_NoWarn | LOAD_Quiet);
+		}
+
+		const UBVHAssetImportData* ImportData = MirroredSequence ? Cast<UBVHAssetImportData>(MirroredSequence->AssetImportData) : nullptr;
+		return (ImportData && ImportData->bIsMirrored && ImportData->GetFirstFilename() == Filename) ? MirroredSequence : nullptr;
+	}
+}
+
 UBVHImportFactory::UBVHImportFactory(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -42,8 +95,11 @@ UBVHImportFactory::UBVHImportFactory(const FObjectInitializer& ObjectInitializer
 	bText = false;
 
 	bShowOption = true;
+	bImportAll = false;
+	bBatchCommit = false;
 
 	Formats.Add(TEXT("bvh;BVH"));
+	Formats.Add(TEXT("gz;BVH (gzip compressed)"));
 }
 
 void UBVHImportFactory::PostInitProperties()
@@ -69,8 +125,19 @@ UClass* UBVHImportFactory::ResolveSupportedClass()
 
 bool UBVHImportFactory::FactoryCanImport(const FString& Filename)
 {
-	const FString Extension = FPaths::GetExtension(Filename);
-	return FPaths::GetExtension(Filename) == TEXT("bvh");
+	return IsBVHFilename(Filename);
+}
+
+bool UBVHImportFactory::IsBVHFilename(const FString& Filename)
+{
+	return Filename.EndsWith(TEXT(".bvh")) || Filename.EndsWith(TEXT(".bvh.gz"));
+}
+
+FString UBVHImportFactory::GetMotionName(const FString& Filename)
+{
+	// Same name FBVHFile::Open() gives the motion, name.bvh.gz is named after name
+	const FString BaseFilename = FPaths::GetBaseFilename(Filename);
+	return Filename.EndsWith(TEXT(".gz")) ? FPaths::GetBaseFilename(BaseFilename) : BaseFilename;
 }
 
 UObject* UBVHImportFactory::FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled)
@@ -81,6 +148,12 @@ UObject* UBVHImportFactory::FactoryCreateFile(UClass* InClass, UObject* InParent
 		|| GIsRunningUnattendedScript);
 	bShowOption = !bIsUnattended;
 
+	// Nobody undoes an unattended import, its sequences are finalized together in CleanUp()
+	if (bIsUnattended && !bBatchCommit)
+	{
+		BeginBatchCommit();
+	}
+
 	// Check if it's a re-import
 	if (InParent != nullptr)
 	{
@@ -116,6 +189,14 @@ UObject* UBVHImportFactory::FactoryCreateFile(UClass* InClass, UObject* InParent
 
 	GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPreImport(this, InClass, InParent, InName, TEXT("BVH"));
 
+	bOutOperationCanceled = false;
+
+	// The remaining files of a multi-file import reuse the options picked for the first one
+	if (bImportAll)
+	{
+		return QueueBatchImport(InParent, Filename, BatchSettings, nullptr);
+	}
+
 	// Use (and show) the settings from the script if provided
 	UBVHImportSettings* ScriptedSettings = AssetImportTask ? Cast<UBVHImportSettings>(AssetImportTask->Options) : nullptr;
 	if (ScriptedSettings)
@@ -123,29 +204,47 @@ UObject* UBVHImportFactory::FactoryCreateFile(UClass* InClass, UObject* InParent
 		ImportSettings = ScriptedSettings;
 	}
 
-	FBVHImporter Importer;
-	Importer.SetImportSetting(ImportSettings);
-	EBVHImportError ErrorCode = Importer.OpenBVHFileForImport(Filename);
+	TSharedPtr<FBVHImporter> Importer = MakeShared<FBVHImporter>();
+	Importer->SetImportSetting(ImportSettings);
+	EBVHImportError ErrorCode = Importer->OpenBVHFileForImport(Filename);
 	ImportSettings->bReimport = false;
 	AdditionalImportedObjects.Empty();
 
 	// Set up message log page name to separate different assets
-	FText ImportingText = FText::Format(LOCTEXT("BVHFactoryImporting", "Importing {0}.bvh"), FText::FromName(InName));
-	const FString& PageName = ImportingText.ToString();
+	FText ImportingText = FText::Format(LOCTEXT("BVHFactoryImporting", "Importing {0}"), FText::FromString(FPaths::GetCleanFilename(Filename)));
+	FMessageLog(FBVHPluginModule::ImportLogName).NewPage(ImportingText);
 
 	if (ErrorCode != BVHImportError_NoError)
 	{
 		return nullptr;
 	}
 
-	bOutOperationCanceled = false;
-
 	if (bShowOption)
 	{
 		TSharedPtr<SBVHImportOptions> Options;
-		ShowImportOptionsWindow(Options, UFactory::CurrentFilename, Importer);
+		ShowImportOptionsWindow(Options, UFactory::CurrentFilename, *Importer);
 		// Set whether or not the user canceled
 		bOutOperationCanceled = !Options->ShouldImport();
+
+		if (!bOutOperationCanceled && Options->ShouldImportAll())
+		{
+			if (ImportSettings->Clips.Num() > 0)
+			{
+				UE_LOG(LogBvhImporter, Warning, TEXT("Clip ranges are specific to one file, they are ignored by Import All."));
+			}
+
+			if (ImportSettings->Skeleton == nullptr)
+			{
+				UE_LOG(LogBvhImporter, Error, TEXT("Skeleton Not Selected."));
+				return nullptr;
+			}
+
+			// Everything but the per-file fields is shared by the whole batch, the first file keeps what was edited in the dialog
+			bImportAll = true;
+			BatchSettings = ImportSettings->MakeSnapshot();
+			BatchRefSkeleton = MakeShared<FReferenceSkeleton>(ImportSettings->Skeleton->GetReferenceSkeleton());
+			return QueueBatchImport(InParent, Filename, BatchSettings, Importer);
+		}
 	}
 
 	TArray<UObject*> ResultAssets;
@@ -153,18 +252,28 @@ UObject* UBVHImportFactory::FactoryCreateFile(UClass* InClass, UObject* InParent
 	{
 		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPreImport(this, InClass, InParent, InName, TEXT("BVH"));
 
-		UObject* AnimSeq = ImportAnimation(ImportSettings->Skeleton.Get(), InParent, &Importer);
-		ResultAssets.Add(AnimSeq);
+		if (ImportSettings->Clips.Num() > 0)
+		{
+			ImportClips(ImportSettings->Skeleton.Get(), InParent, Importer.Get(), ResultAssets);
+		}
+		else
+		{
+			UObject* AnimSeq = ImportAnimation(ImportSettings->Skeleton.Get(), InParent, Importer.Get());
+			ResultAssets.Add(AnimSeq);
+		}
 
+		// PopulateSequence() already called PostEditChange(), or left it to EndBatchCommit(), calling it again would compress twice
 		AdditionalImportedObjects.Reserve(ResultAssets.Num());
 		for (UObject* Object : ResultAssets)
 		{
 			if (Object)
 			{
-				FAssetRegistryModule::AssetCreated(Object);
-				GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, Object);
+				if (!bBatchCommit)
+				{
+					FAssetRegistryModule::AssetCreated(Object);
+				}
+				BroadcastPostImport(Object);
 				Object->MarkPackageDirty();
-				Object->PostEditChange();
 				AdditionalImportedObjects.Add(Object);
 			}
 		}
@@ -173,8 +282,136 @@ UObject* UBVHImportFactory::FactoryCreateFile(UClass* InClass, UObject* InParent
 	return (ResultAssets.Num() > 0) ? ResultAssets[0] : nullptr;
 }
 
+void UBVHImportFactory::CleanUp()
+{
+	Super::CleanUp();
+
+	CommitPendingImports();
+	bImportAll = false;
+
+	if (bBatchCommit)
+	{
+		EndBatchCommit();
+	}
+
+	// The files of the import shared their scratch memory, the next import may be a long time away
+	FBVHImportContext::Trim();
+}
+
+void UBVHImportFactory::ResetState()
+{
+	Super::ResetState();
+
+	bImportAll = false;
+}
+
+UObject* UBVHImportFactory::QueueBatchImport(UObject* InParent, const FString& Filename, const FBVHImportSnapshot& Settings, TSharedPtr<FBVHImporter> OpenedImporter)
+{
+	// The asset is created right away so the caller gets its result, its content is written once the whole batch is converted
+	const FString MotionName = OpenedImporter.IsValid() ? Settings.MotionName : GetMotionName(Filename);
+	UAnimSequence* Sequence = FindOrCreateSequence(MotionName, InParent);
+	if (Sequence == nullptr)
+	{
+		return nullptr;
+	}
+
+	FBVHPendingImport& Pending = PendingImports.AddDefaulted_GetRef();
+	Pending.Sequence = Sequence;
+	Pending.Animation = MakeShared<FBVHConvertedAnimation>();
+
+	// Each task owns a copy of the settings, nothing reads the shared UBVHImportSettings from now on
+	Pending.Result = Async(EAsyncExecution::ThreadPool, [Animation = Pending.Animation, RefSkeleton = BatchRefSkeleton, Settings, Filename, OpenedImporter]()
+	{
+		bool bConverted = false;
+		if (OpenedImporter.IsValid())
+		{
+			Animation->SourceFilename = Filename;
+			Animation->SourceSize = IFileManager::Get().FileSize(*Filename);
+			Animation->ParseSeconds = OpenedImporter->GetOpenSeconds();
+			bConverted = FBVHTrackCache::ConvertCached(*OpenedImporter->GetBvhFile(), *RefSkeleton, Settings, *Animation);
+		}
+		else
+		{
+			bConverted = FBVHTrackCache::ConvertFile(Filename, *RefSkeleton, Settings, *Animation);
+		}
+
+		// The keys are held until CommitPendingImports() writes them into the sequence
+		if (bConverted)
+		{
+			INC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation->GetTrackBytes());
+		}
+		return bConverted;
+	});
+
+	AdditionalImportedObjects.Add(Sequence);
+	return Sequence;
+}
+
+void UBVHImportFactory::CommitPendingImports()
+{
+	if (PendingImports.Num() == 0)
+	{
+		return;
+	}
+
+	FScopedSlowTask SlowTask(PendingImports.Num(), LOCTEXT("CommittingBVHImports", "Creating BVH animations"));
+	SlowTask.MakeDialog();
+
+	// The files of the batch are compressed together once all are written
+	const bool bOwnsBatchCommit = !bBatchCommit;
+	if (bOwnsBatchCommit)
+	{
+		BeginBatchCommit();
+	}
+
+	for (FBVHPendingImport& Pending : PendingImports)
+	{
+		SlowTask.EnterProgressFrame();
+
+		const bool bConverted = Pending.Result.Get();
+		ON_SCOPE_EXIT
+		{
+			if (bConverted)
+			{
+				DEC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Pending.Animation->GetTrackBytes());
+			}
+		};
+
+		UAnimSequence* Sequence = Pending.Sequence.Get();
+		if (Sequence == nullptr)
+		{
+			continue;
+		}
+
+		if (!bConverted)
+		{
+			UE_LOG(LogBvhImporter, Error, TEXT("Failed to import %s."), *Pending.Animation->SourceFilename);
+			continue;
+		}
+
+		PopulateSequence(Sequence, *Pending.Animation, BatchSettings.Skeleton);
+		BroadcastPostImport(Sequence);
+
+		if (UAnimSequence* MirroredSequence = CommitMirroredAnimation(*Pending.Animation, BatchSettings.Skeleton, Sequence->GetPackage()))
+		{
+			BroadcastPostImport(MirroredSequence);
+		}
+	}
+
+	if (bOwnsBatchCommit)
+	{
+		SlowTask.EnterProgressFrame(0.f, LOCTEXT("CompressingBVHImports", "Compressing BVH animations"));
+		EndBatchCommit();
+	}
+
+	PendingImports.Reset();
+	BatchRefSkeleton.Reset();
+}
+
 UAnimSequence* UBVHImportFactory::ImportAnimation(USkeleton* Skeleton, UObject* Outer, FBVHImporter* Importer)
 {
+	SCOPE_CYCLE_COUNTER(STAT_BVHImportAnimation);
+
 	// we need skeleton to create animsequence
 	if (Skeleton == NULL)
 	{
@@ -182,15 +419,136 @@ UAnimSequence* UBVHImportFactory::ImportAnimation(USkeleton* Skeleton, UObject*
 		return NULL;
 	}
 
-	UAnimSequence* LastCreatedAnim = NULL;
+	FBVHConvertedAnimation Animation;
+	Animation.SourceFilename = UFactory::CurrentFilename;
+	Animation.SourceSize = IFileManager::Get().FileSize(*Animation.SourceFilename);
+	Animation.ParseSeconds = Importer->GetOpenSeconds();
+	if (!FBVHTrackCache::ConvertCached(*Importer->GetBvhFile(), Skeleton->GetReferenceSkeleton(), ImportSettings->MakeSnapshot(), Animation))
+	{
+		return NULL;
+	}
 
-	int32 ResampleRate = DEFAULT_SAMPLERATE;
-	if (ImportSettings->ResampleRate > 0)
+	INC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation.GetTrackBytes());
+	UAnimSequence* DestSeq = CommitAnimation(Animation, Skeleton, Outer);
+	DEC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation.GetTrackBytes());
+	return DestSeq;
+}
+
+void UBVHImportFactory::ImportClips(USkeleton* Skeleton, UObject* Outer, FBVHImporter* Importer, TArray<UObject*>& OutSequences)
+{
+	if (Skeleton == NULL)
+	{
+		UE_LOG(LogBvhImporter, Error, TEXT("Skeleton Not Selected."));
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_BVHImportAnimation);
+
+	// The file is parsed once, every clip is converted from the same motion buffer
+	TArray<FBVHConvertedAnimation> Animations;
+	if (!FBVHAnimConverter::ConvertClips(*Importer->GetBvhFile(), UFactory::CurrentFilename, Skeleton->GetReferenceSkeleton(), ImportSettings->MakeSnapshot(), ImportSettings->Clips, Animations))
+	{
+		UE_LOG(LogBvhImporter, Warning, TEXT("Some clips of %s failed to convert."), *UFactory::CurrentFilename);
+	}
+
+	for (FBVHConvertedAnimation& Animation : Animations)
+	{
+		// Every clip reports the parse of the file they share
+		Animation.SourceSize = IFileManager::Get().FileSize(*UFactory::CurrentFilename);
+		Animation.ParseSeconds = Importer->GetOpenSeconds();
+		INC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation.GetTrackBytes());
+	}
+
+	for (const FBVHConvertedAnimation& Animation : Animations)
+	{
+		if (Animation.NumKeys > 0)
+		{
+			OutSequences.Add(CommitAnimation(Animation, Skeleton, Outer));
+		}
+		DEC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation.GetTrackBytes());
+	}
+}
+
+UAnimSequence* UBVHImportFactory::CommitAnimation(const FBVHConvertedAnimation& Animation, USkeleton* Skeleton, UObject* Outer, UAnimSequence** OutMirroredSequence)
+{
+	check(IsInGameThread());
+
+	// we need skeleton to create animsequence
+	if (Skeleton == NULL)
+	{
+		UE_LOG(LogBvhImporter, Error, TEXT("Skeleton Not Selected."));
+		return NULL;
+	}
+
+	UAnimSequence* DestSeq = FindOrCreateSequence(Animation.Settings.MotionName, Outer);
+	if (DestSeq == nullptr)
+	{
+		return nullptr;
+	}
+
+	PopulateSequence(DestSeq, Animation, Skeleton);
+	UAnimSequence* MirroredSequence = CommitMirroredAnimation(Animation, Skeleton, Outer);
+	if (OutMirroredSequence)
 	{
-		ResampleRate = ImportSettings->ResampleRate;
+		*OutMirroredSequence = MirroredSequence;
+	}
+	return DestSeq;
+}
+
+UAnimSequence* UBVHImportFactory::CommitMirroredAnimation(const FBVHConvertedAnimation& Animation, USkeleton* Skeleton, UObject* Outer)
+{
+	if (Animation.MirroredTracks.Num() == 0)
+	{
+		return nullptr;
 	}
 
-	FString SequenceName = ImportSettings->MotionName;
+	FBVHConvertedAnimation Mirrored;
+	FBVHAnimConverter::MakeMirroredAnimation(Animation, Mirrored);
+
+	UAnimSequence* DestSeq = FindOrCreateSequence(Mirrored.Settings.MotionName, Outer);
+	if (DestSeq == nullptr)
+	{
+		return nullptr;
+	}
+
+	PopulateSequence(DestSeq, Mirrored, Skeleton);
+	AdditionalImportedObjects.Add(DestSeq);
+	return DestSeq;
+}
+
+UAnimSequence* UBVHImportFactory::CommitReimport(FBVHConvertedAnimation& Animation, USkeleton* Skeleton, UObject* Outer)
+{
+	check(IsInGameThread());
+
+	UAnimSequence* DestSeq = FindOrCreateSequence(Animation.Settings.MotionName, Outer);
+	if (DestSeq == nullptr)
+	{
+		return nullptr;
+	}
+
+	// The mirrored sequence needs the keys of every bone
+	CommitMirroredAnimation(Animation, Skeleton, Outer);
+
+	const UBVHAssetImportData* ImportData = Cast<UBVHAssetImportData>(DestSeq->AssetImportData);
+	const bool bIncremental = ImportData && ImportData->TrackHashes.Num() > 0 && !ImportData->bIsClip && !ImportData->bIsMirrored
+		&& ImportData->SamplingHash == Animation.Settings.GetSamplingHash() && DestSeq->GetSkeleton() == Skeleton;
+	if (bIncremental)
+	{
+		const TMap<FName, uint32> PreviousHashes = ImportData->TrackHashes;
+		FBVHAnimConverter::RemoveUnchangedTracks(Animation, PreviousHashes);
+		UpdateSequenceInPlace(DestSeq, Animation, PreviousHashes);
+	}
+	else
+	{
+		PopulateSequence(DestSeq, Animation, Skeleton);
+	}
+
+	return DestSeq;
+}
+
+UAnimSequence* UBVHImportFactory::FindOrCreateSequence(const FString& MotionName, UObject* Outer)
+{
+	FString SequenceName = MotionName;
 
 	// See if this sequence already exists.
 	SequenceName = ObjectTools::SanitizeObjectName(SequenceName);
@@ -198,7 +556,7 @@ UAnimSequence* UBVHImportFactory::ImportAnimation(USkeleton* Skeleton, UObject*
 	FString  NewPackageName = FString::Printf(TEXT("%s/%s"), *FPackageName::GetLongPackagePath(*Outer->GetName()), *SequenceName);
 	UPackage* Package = CreatePackage(*NewPackageName);
 
-	UPackage* ExistingTypedObject = FindObject<UPackage>(Package, *SequenceName);
+	UAnimSequence* ExistingTypedObject = FindObject<UAnimSequence>(Package, *SequenceName);
 	UObject* ExistingObject = FindObject<UObject>(Package, *SequenceName);
 
 	if (ExistingTypedObject != nullptr)
@@ -241,22 +599,47 @@ UAnimSequence* UBVHImportFactory::ImportAnimation(USkeleton* Skeleton, UObject*
 	{
 		DestSeq = NewObject<UAnimSequence>(Package, *SequenceName, RF_Public | RF_Standalone);
 		CreatedObjects.Add(DestSeq);
-		// Notify the asset registry
-		FAssetRegistryModule::AssetCreated(DestSeq);
+		// Notify the asset registry, once the batch is finalized in batch commit mode
+		if (bBatchCommit)
+		{
+			BatchCreatedSequences.Add(DestSeq);
+		}
+		else
+		{
+			FAssetRegistryModule::AssetCreated(DestSeq);
+		}
+	}
+
+	return DestSeq;
+}
+
+void UBVHImportFactory::PopulateSequence(UAnimSequence* DestSeq, const FBVHConvertedAnimation& Animation, USkeleton* Skeleton)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BVHPopulateSequence);
+
+	const FBVHImportSnapshot& Settings = Animation.Settings;
+
+	int32 ResampleRate = DEFAULT_SAMPLERATE;
+	if (Settings.ResampleRate > 0)
+	{
+		ResampleRate = Settings.ResampleRate;
 	}
 
 	DestSeq->SetSkeleton(Skeleton);
 
+	// A batch commit is not undoable, the controller then skips recording transactions
+	const bool bShouldTransact = !bBatchCommit;
+
 	float PreviousSequenceLength = DestSeq->GetPlayLength();
 	IAnimationDataController& Controller = DestSeq->GetController();
 	Controller.InitializeModel();
-	Controller.OpenBracket(LOCTEXT("ImportAnimation_Bracket", "Importing Animation"));
+	Controller.OpenBracket(LOCTEXT("ImportAnimation_Bracket", "Importing Animation"), bShouldTransact);
 
 	//This destroy all previously imported animation raw data
-	Controller.RemoveAllBoneTracks();
+	Controller.RemoveAllBoneTracks(bShouldTransact);
 
 	// if you have one pose(thus 0.f duration), it still contains animation, so we'll need to consider that as MINIMUM_ANIMATION_LENGTH time length
-	Controller.SetPlayLength(FGenericPlatformMath::Max<float>(ImportSettings->FrameNum - 1, MINIMUM_ANIMATION_LENGTH) * ImportSettings->TimeStep);
+	Controller.SetPlayLength(FGenericPlatformMath::Max<float>(Animation.NumKeys - 1, MINIMUM_ANIMATION_LENGTH) * Settings.TimeStep, bShouldTransact);
 
 	if (PreviousSequenceLength > MINIMUM_ANIMATION_LENGTH && DestSeq->GetDataModel()->GetNumberOfFloatCurves() > 0)
 	{
@@ -268,102 +651,195 @@ UAnimSequence* UBVHImportFactory::ImportAnimation(USkeleton* Skeleton, UObject*
 			for (const FFloatCurve& Curve : DestSeq->GetDataModel()->GetFloatCurves())
 			{
 				const FAnimationCurveIdentifier CurveId(Curve.Name, ERawCurveTrackTypes::RCT_Float);
-				Controller.ScaleCurve(CurveId, 0.f, ScaleFactor);
+				Controller.ScaleCurve(CurveId, 0.f, ScaleFactor, bShouldTransact);
 			}
 		}
 	}
 
-	
+	Controller.SetFrameRate(FFrameRate(ResampleRate, 1), bShouldTransact);
 
-	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
-
-	Controller.SetFrameRate(FFrameRate(ResampleRate, 1));
+	double KeysSeconds = 0.0;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BVHSetBoneTrackKeys);
+		FScopedDurationTimer KeysTimer(KeysSeconds);
 
-	FBVHFile* BvhFile = Importer->GetBvhFile();	
+		for (const FBVHConvertedTrack& Track : Animation.Tracks)
+		{
+			//add new track
+			Controller.AddBoneTrack(Track.BoneName, bShouldTransact);
+			Controller.SetBoneTrackKeys(Track.BoneName, Track.RawTrack.PosKeys, Track.RawTrack.RotKeys, Track.RawTrack.ScaleKeys, bShouldTransact);
+		}
+	}
 
-	for (int32 j = 0; j < BvhFile->GetNumJoint(); ++j)
+	// Model notifications, then the compression started by PostEditChange()
+	double FinalizeSeconds = 0.0;
 	{
-		int32 NumKeysForTrack = 0;
+		FScopedDurationTimer FinalizeTimer(FinalizeSeconds);
 
-		// see if it's found in Skeleton
-		const Joint* joint = BvhFile->GetJoint(j);
-		int32 JointIdx = joint->index;
-		
-		FName BoneName(ANSI_TO_TCHAR(joint->name.c_str()));
-		int32 BoneTreeIndex = RefSkeleton.FindBoneIndex(BoneName);
-		const int32 NumSamplingFrame = ImportSettings->FrameEnd;
-		const int32 NumTotalTracks = BvhFile->GetNumJoint();
+		Controller.UpdateCurveNamesFromSkeleton(Skeleton, ERawCurveTrackTypes::RCT_Float, bShouldTransact);
+		Controller.NotifyPopulated();
 
-		// update status
-		FFormatNamedArguments Args;
-		Args.Add(TEXT("TrackName"), FText::FromName(BoneName));
-		Args.Add(TEXT("TotalKey"), FText::AsNumber(NumSamplingFrame + 1)); //Key number is Frame + 1
-		Args.Add(TEXT("TrackIndex"), FText::AsNumber(JointIdx + 1));
-		Args.Add(TEXT("TotalTracks"), FText::AsNumber(NumTotalTracks));
-		const FText StatusUpate = FText::Format(LOCTEXT("ImportingAnimTrackDetail", "Importing Animation Track [{TrackName}] ({TrackIndex}/{TotalTracks}) - TotalKey {TotalKey}"), Args);
+		Controller.CloseBracket(bShouldTransact);
 
-		if (BoneTreeIndex != INDEX_NONE)
+		DestSeq->ImportFileFramerate = Settings.ResampleRate;
+		DestSeq->ImportResampleFramerate = 1 / Settings.TimeStep;
+
+		StoreImportData(DestSeq, Animation);
+
+		if (bBatchCommit)
+		{
+			BatchSequences.AddUnique(DestSeq);
+		}
+		else
 		{
-			bool bSuccess = true;
+			SCOPE_CYCLE_COUNTER(STAT_BVHPostEditChange);
+			DestSeq->PostEditChange();
+		}
+	}
 
-			FRawAnimSequenceTrack RawTrack;
-			RawTrack.PosKeys.Empty();
-			RawTrack.RotKeys.Empty();
-			RawTrack.ScaleKeys.Empty();
+	DestSeq->SetPreviewMesh(Skeleton->GetPreviewMesh());
+	DestSeq->MarkPackageDirty();
 
-			TArray<float> TimeKeys;
+	BVHImportFactory::ReportImport(DestSeq, Animation, KeysSeconds, FinalizeSeconds, bBatchCommit);
+}
 
-			for (int32 FrameIdx = 0; FrameIdx < BvhFile->GetNumFrame(); ++FrameIdx)
-			{
-				double CurTime = ImportSettings->TimeStep * FrameIdx;
-				FTransform LocalTransform = BvhFile->GetTransform(FrameIdx, JointIdx);
-				if (LocalTransform.ContainsNaN())
-				{
-					bSuccess = false;
-					UE_LOG(LogBvhImporter, Error, TEXT("Bvh contain NaN."));
-					break;
-				}
+void UBVHImportFactory::UpdateSequenceInPlace(UAnimSequence* DestSeq, const FBVHConvertedAnimation& Animation, const TMap<FName, uint32>& PreviousHashes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BVHPopulateSequence);
 
-				RawTrack.ScaleKeys.Add(FVector3f(LocalTransform.GetScale3D()));
-				RawTrack.PosKeys.Add(FVector3f(LocalTransform.GetTranslation()));
-				RawTrack.RotKeys.Add(FQuat4f(LocalTransform.GetRotation()));
+	const bool bShouldTransact = !bBatchCommit;
 
-				TimeKeys.Add(CurTime);
+	IAnimationDataController& Controller = DestSeq->GetController();
+	Controller.OpenBracket(LOCTEXT("ReimportAnimation_Bracket", "Reimporting Animation"), bShouldTransact);
 
-				++NumKeysForTrack;
-			}
+	// Only the tracks whose source changed were converted, the others keep their keys
+	double KeysSeconds = 0.0;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BVHSetBoneTrackKeys);
+		FScopedDurationTimer KeysTimer(KeysSeconds);
 
-			if (bSuccess)
+		for (const FBVHConvertedTrack& Track : Animation.Tracks)
+		{
+			if (!DestSeq->GetDataModel()->IsValidBoneTrackName(Track.BoneName))
 			{
-				check(RawTrack.ScaleKeys.Num() == NumKeysForTrack);
-				check(RawTrack.PosKeys.Num() == NumKeysForTrack);
-				check(RawTrack.RotKeys.Num() == NumKeysForTrack);
-
-				if (BoneTreeIndex != INDEX_NONE)
-				{
-					//add new track
-					Controller.AddBoneTrack(BoneName);
-					Controller.SetBoneTrackKeys(BoneName, RawTrack.PosKeys, RawTrack.RotKeys, RawTrack.ScaleKeys);
-				}
+				Controller.AddBoneTrack(Track.BoneName, bShouldTransact);
 			}
+			Controller.SetBoneTrackKeys(Track.BoneName, Track.RawTrack.PosKeys, Track.RawTrack.RotKeys, Track.RawTrack.ScaleKeys, bShouldTransact);
 		}
 	}
 
-	Controller.UpdateCurveNamesFromSkeleton(Skeleton, ERawCurveTrackTypes::RCT_Float);
-	Controller.NotifyPopulated();
+	// Joints that disappeared from the file or from the skeleton
+	for (const TPair<FName, uint32>& PreviousHash : PreviousHashes)
+	{
+		if (!Animation.TrackHashes.Contains(PreviousHash.Key) && DestSeq->GetDataModel()->IsValidBoneTrackName(PreviousHash.Key))
+		{
+			Controller.RemoveBoneTrack(PreviousHash.Key, bShouldTransact);
+		}
+	}
 
-	Controller.CloseBracket();
+	double FinalizeSeconds = 0.0;
+	{
+		FScopedDurationTimer FinalizeTimer(FinalizeSeconds);
 
-	DestSeq->ImportFileFramerate = ImportSettings->ResampleRate;
-	DestSeq->ImportResampleFramerate = 1 / ImportSettings->TimeStep;
+		Controller.CloseBracket(bShouldTransact);
+
+		StoreImportData(DestSeq, Animation);
+
+		if (bBatchCommit)
+		{
+			BatchSequences.AddUnique(DestSeq);
+		}
+		else
+		{
+			SCOPE_CYCLE_COUNTER(STAT_BVHPostEditChange);
+			DestSeq->PostEditChange();
+		}
+	}
 
-	DestSeq->PostEditChange();
-	DestSeq->SetPreviewMesh(Skeleton->GetPreviewMesh());
 	DestSeq->MarkPackageDirty();
 
-	LastCreatedAnim = DestSeq;
+	BVHImportFactory::ReportImport(DestSeq, Animation, KeysSeconds, FinalizeSeconds, bBatchCommit);
+}
 
-	return LastCreatedAnim;
+void UBVHImportFactory::StoreImportData(UAnimSequence* DestSeq, const FBVHConvertedAnimation& Animation)
+{
+	UBVHAssetImportData* ImportData = UBVHAssetImportData::GetImportDataForSequence(DestSeq);
+	if (!Animation.SourceFilename.IsEmpty())
+	{
+		ImportData->Update(Animation.SourceFilename);
+	}
+	ImportData->TrackHashes = Animation.TrackHashes;
+	ImportData->SamplingHash = Animation.Settings.GetSamplingHash();
+	ImportData->bIsClip = Animation.bIsClip;
+	ImportData->FrameStart = Animation.Settings.FrameStart;
+	ImportData->FrameEnd = Animation.Settings.FrameEnd;
+	ImportData->FrameNum = Animation.Settings.FrameNum;
+	ImportData->bIsMirrored = Animation.bIsMirrored;
+	ImportData->MirrorAxis = Animation.Settings.MirrorAxis;
+}
+
+void UBVHImportFactory::BeginBatchCommit()
+{
+	check(IsInGameThread());
+	bBatchCommit = true;
+}
+
+void UBVHImportFactory::EndBatchCommit()
+{
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE(UBVHImportFactory::EndBatchCommit);
+
+	bBatchCommit = false;
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<UAnimSequence*> Sequences;
+	Sequences.Reserve(BatchSequences.Num());
+	for (const TWeakObjectPtr<UAnimSequence>& Sequence : BatchSequences)
+	{
+		if (Sequence.IsValid())
+		{
+			Sequences.Add(Sequence.Get());
+		}
+	}
+
+	// Every sequence requests its compression once, the asset compiling manager runs them in parallel
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BVHPostEditChange);
+		for (UAnimSequence* Sequence : Sequences)
+		{
+			Sequence->PostEditChange();
+		}
+		FAssetCompilingManager::Get().FinishAllCompilation();
+	}
+
+	for (const TWeakObjectPtr<UAnimSequence>& Sequence : BatchCreatedSequences)
+	{
+		if (Sequence.IsValid())
+		{
+			FAssetRegistryModule::AssetCreated(Sequence.Get());
+		}
+	}
+	for (UAnimSequence* Sequence : Sequences)
+	{
+		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, Sequence);
+	}
+
+	if (Sequences.Num() > 0)
+	{
+		const FString Summary = FString::Printf(TEXT("Finalized and compressed %d sequences in %.1f ms."), Sequences.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		FMessageLog(FBVHPluginModule::ImportLogName).Info(FText::FromString(Summary));
+	}
+
+	BatchSequences.Reset();
+	BatchCreatedSequences.Reset();
+}
+
+void UBVHImportFactory::BroadcastPostImport(UObject* Object)
+{
+	if (!bBatchCommit)
+	{
+		GEditor->GetEditorSubsystem<UImportSubsystem>()->BroadcastAssetPostImport(this, Object);
+	}
 }
 
 bool UBVHImportFactory::CanReimport(UObject* Obj, TArray<FString>& OutFilenames)
@@ -377,7 +853,7 @@ bool UBVHImportFactory::CanReimport(UObject* Obj, TArray<FString>& OutFilenames)
 
 	if (ImportData)
 	{
-		if (FPaths::GetExtension(ImportData->GetFirstFilename()) == TEXT("bvh") || (Obj->GetClass() == UAnimSequence::StaticClass() && ImportData->GetFirstFilename().IsEmpty()))
+		if (IsBVHFilename(ImportData->GetFirstFilename()) || (Obj->GetClass() == UAnimSequence::StaticClass() && ImportData->GetFirstFilename().IsEmpty()))
 		{
 			ImportData->ExtractFilenames(OutFilenames);
 			return true;
@@ -398,9 +874,190 @@ void UBVHImportFactory::SetReimportPaths(UObject* Obj, const TArray<FString>& Ne
 
 EReimportResult::Type UBVHImportFactory::Reimport(UObject* Obj)
 {
+	UAnimSequence* Sequence = Cast<UAnimSequence>(Obj);
+	if (Sequence == nullptr || Sequence->AssetImportData == nullptr)
+	{
+		return EReimportResult::Failed;
+	}
+
+	USkeleton* Skeleton = Sequence->GetSkeleton();
+	if (Skeleton == nullptr)
+	{
+		UE_LOG(LogBvhImporter, Error, TEXT("Skeleton Not Selected."));
+		return EReimportResult::Failed;
+	}
+
+	const FString Filename = Sequence->AssetImportData->GetFirstFilename();
+	if (Filename.IsEmpty() || !FPaths::FileExists(Filename))
+	{
+		UE_LOG(LogBvhImporter, Error, TEXT("Cannot reimport %s, source file '%s' not found."), *Sequence->GetName(), *Filename);
+		return EReimportResult::Failed;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_BVHImportAnimation);
+
 	ImportSettings->bReimport = true;
 
-	return EReimportResult::Failed;
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+	const UBVHAssetImportData* ImportData = Cast<UBVHAssetImportData>(Sequence->AssetImportData);
+	const TMap<FName, uint32> PreviousHashes = ImportData ? ImportData->TrackHashes : TMap<FName, uint32>();
+
+	FBVHImportSnapshot SharedSettings = ImportSettings->MakeSnapshot();
+	SharedSettings.Skeleton = Skeleton;
+
+	// Clips and sequences trimmed in the import options keep the frame range they were imported with
+	const bool bIsClip = ImportData && ImportData->bIsClip;
+	const bool bKeepsRange = ImportData && ImportData->HasTrimmedRange();
+
+	// A mirrored sequence is converted from its source like the original, then mirrored again
+	const bool bIsMirrored = ImportData && ImportData->bIsMirrored;
+
+	FBVHConvertedAnimation Animation;
+	Animation.SourceFilename = Filename;
+	Animation.SourceSize = IFileManager::Get().FileSize(*Filename);
+
+	// A cache hit holds every track of the whole file, the unchanged ones are filtered out below
+	FString CacheKey;
+	if (SharedSettings.bUseDerivedDataCache && !bKeepsRange)
+	{
+		const FString SourceHash = FBVHTrackCache::HashSourceFile(Filename);
+		if (!SourceHash.IsEmpty())
+		{
+			CacheKey = FBVHTrackCache::BuildKey(SourceHash, RefSkeleton, nullptr);
+		}
+	}
+	const bool bCacheHit = !CacheKey.IsEmpty() && FBVHTrackCache::Get(CacheKey, Animation);
+
+	TUniquePtr<FBVHFile> BvhFile;
+	ON_SCOPE_EXIT
+	{
+		if (BvhFile.IsValid())
+		{
+			DEC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile->GetMotionBytes());
+		}
+	};
+	FBVHImportSnapshot Settings = SharedSettings;
+	if (bCacheHit)
+	{
+		Settings = Animation.Settings;
+		Settings.Skeleton = Skeleton;
+		Settings.SamplingType = SharedSettings.SamplingType;
+	}
+	else
+	{
+		BvhFile = MakeUnique<FBVHFile>(TCHAR_TO_ANSI(*Filename));
+		bool bOpened = false;
+		{
+			SCOPE_CYCLE_COUNTER(STAT_BVHOpenFile);
+			FScopedDurationTimer OpenTimer(Animation.ParseSeconds);
+			bOpened = SharedSettings.ShouldStream(Animation.SourceSize)
+				? BvhFile->OpenStreaming(FBVHAnimConverter::StreamingWindowFrames)
+				: BvhFile->Open();
+		}
+		INC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile->GetMotionBytes());
+		if (!bOpened)
+		{
+			UE_LOG(LogBvhImporter, Error, TEXT("Failed to open %s."), *Filename);
+			return EReimportResult::Failed;
+		}
+		Settings.ApplyFile(*BvhFile);
+	}
+	Settings.MotionName = Sequence->GetName();
+
+	// ApplyFile() selected every frame
+	if (bKeepsRange)
+	{
+		Settings.FrameStart = ImportData->FrameStart;
+		Settings.FrameEnd = ImportData->FrameEnd;
+	}
+	Animation.bIsClip = bIsClip;
+
+	Settings.bCreateMirrored = bIsMirrored;
+	if (bIsMirrored)
+	{
+		Settings.MirrorAxis = ImportData->MirrorAxis;
+		Settings.MirrorBonePairs = SharedSettings.MirrorBonePairs;
+	}
+
+	// Tracks can only be patched when every key lands on the same frame as before
+	const bool bIncremental = ImportData && PreviousHashes.Num() > 0 && ImportData->SamplingHash == Settings.GetSamplingHash();
+
+	if (bCacheHit)
+	{
+		Animation.Settings = Settings;
+		if (bIncremental)
+		{
+			FBVHAnimConverter::RemoveUnchangedTracks(Animation, PreviousHashes);
+		}
+	}
+	else if (BvhFile->IsStreaming())
+	{
+		// Track hashes are only known once the last window is read, every track is converted then the unchanged ones dropped
+		if (!FBVHAnimConverter::ConvertWindows(*BvhFile, RefSkeleton, Settings, Animation))
+		{
+			return EReimportResult::Failed;
+		}
+		if (!CacheKey.IsEmpty())
+		{
+			FBVHTrackCache::Put(CacheKey, Animation);
+		}
+		if (bIncremental)
+		{
+			FBVHAnimConverter::RemoveUnchangedTracks(Animation, PreviousHashes);
+		}
+	}
+	else
+	{
+		if (!FBVHAnimConverter::Convert(*BvhFile, RefSkeleton, Settings, Animation, bIncremental ? &PreviousHashes : nullptr))
+		{
+			return EReimportResult::Failed;
+		}
+
+		// An incremental conversion only holds the changed tracks, it must not end up in the cache
+		if (!bIncremental && !CacheKey.IsEmpty())
+		{
+			FBVHTrackCache::Put(CacheKey, Animation);
+		}
+	}
+
+	// Mirrored sequences store no track hashes, bIncremental is never set for them
+	if (bIsMirrored && Animation.MirroredTracks.Num() == 0)
+	{
+		FBVHAnimConverter::MirrorTracks(Animation);
+	}
+
+	INC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation.GetTrackBytes());
+	if (bIsMirrored)
+	{
+		FBVHConvertedAnimation Mirrored;
+		FBVHAnimConverter::MakeMirroredAnimation(Animation, Mirrored);
+		Mirrored.Settings.MotionName = Sequence->GetName();
+		PopulateSequence(Sequence, Mirrored, Skeleton);
+	}
+	else if (bIncremental)
+	{
+		UE_LOG(LogBvhImporter, Log, TEXT("Reimporting %s: %d of %d tracks changed."), *Sequence->GetName(), Animation.Tracks.Num(), Animation.TrackHashes.Num());
+		UpdateSequenceInPlace(Sequence, Animation, PreviousHashes);
+	}
+	else
+	{
+		PopulateSequence(Sequence, Animation, Skeleton);
+	}
+	DEC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation.GetTrackBytes());
+
+	// The mirrored sequence is converted from the same source, it would keep the keys of the previous take
+	if (!bIsMirrored)
+	{
+		if (UAnimSequence* MirroredSequence = BVHImportFactory::FindMirroredSequence(Sequence, Filename))
+		{
+			if (Reimport(MirroredSequence) != EReimportResult::Succeeded)
+			{
+				UE_LOG(LogBvhImporter, Warning, TEXT("Failed to refresh %s from %s."), *MirroredSequence->GetName(), *Filename);
+			}
+		}
+	}
+
+	return EReimportResult::Succeeded;
 }
 
 void UBVHImportFactory::ShowImportOptionsWindow(TSharedPtr<SBVHImportOptions>& Options, FString FilePath, const FBVHImporter& Importer)
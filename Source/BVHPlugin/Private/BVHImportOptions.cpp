@@ -55,6 +55,15 @@ void SBVHImportOptions::Construct(const FArguments& InArgs)
 				.OnClicked(this, &SBVHImportOptions::OnImport)
 			]
 			+ SUniformGridPanel::Slot(1, 0)
+			[
+				SNew(SButton)
+				.HAlign(HAlign_Center)
+				.Text(LOCTEXT("BVHOptionWindow_ImportAll", "Import All"))
+				.ToolTipText(LOCTEXT("BVHOptionWindow_ImportAll_ToolTip", "Imports all selected BVH files with these options, files are converted in parallel"))
+				.IsEnabled(this, &SBVHImportOptions::CanImport)
+				.OnClicked(this, &SBVHImportOptions::OnImportAll)
+			]
+			+ SUniformGridPanel::Slot(2, 0)
 			[
 				SNew(SButton)
 				.HAlign(HAlign_Center)
@@ -42,6 +42,12 @@ public:
 		return FReply::Handled();
 	}
 
+	FReply OnImportAll()
+	{
+		bShouldImportAll = true;
+		return OnImport();
+	}
+
 	FReply OnCancel()
 	{
 		bShouldImport = false;
@@ -67,10 +73,16 @@ public:
 		return bShouldImport;
 	}
 
+	bool ShouldImportAll() const
+	{
+		return bShouldImportAll;
+	}
+
 
 	SBVHImportOptions()
 	: ImportSettings(nullptr)
 	, bShouldImport(false)
+	, bShouldImportAll(false)
 	{}
 
 private:
@@ -82,5 +94,6 @@ private:
 	TWeakPtr< SWindow > WidgetWindow;
 	TSharedPtr< SButton > ImportButton;
 	bool			bShouldImport;
+	bool			bShouldImportAll;
 	TSharedPtr<IDetailsView> DetailsView;
 };
\ No newline at end of file
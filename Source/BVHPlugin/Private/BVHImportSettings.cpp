@@ -5,6 +5,7 @@
 #include "UObject/Class.h"
 #include "UObject/Package.h"
 #include "UObject/ReleaseObjectVersion.h"
+#include "Animation/Skeleton.h"
 
 UBVHImportSettings::UBVHImportSettings(const FObjectInitializer& ObjectInitializer)
 : Super(ObjectInitializer)
@@ -25,6 +26,25 @@ UBVHImportSettings* UBVHImportSettings::Get()
 	return DefaultSettings;
 }
 
+FBVHImportSnapshot UBVHImportSettings::MakeSnapshot() const
+{
+	FBVHImportSnapshot Snapshot;
+	Snapshot.Skeleton = Skeleton.Get();
+	Snapshot.SamplingType = SamplingType;
+	Snapshot.MotionName = MotionName;
+	Snapshot.TimeStep = TimeStep;
+	Snapshot.FrameNum = FrameNum;
+	Snapshot.FrameStart = FrameStart;
+	Snapshot.FrameEnd = FrameEnd;
+	Snapshot.ResampleRate = ResampleRate;
+	Snapshot.bUseDerivedDataCache = bUseDerivedDataCache;
+	Snapshot.StreamingThresholdMB = StreamingThresholdMB;
+	Snapshot.bCreateMirrored = bCreateMirrored;
+	Snapshot.MirrorAxis = MirrorAxis;
+	Snapshot.MirrorBonePairs = MirrorBonePairs;
+	return Snapshot;
+}
+
 void UBVHImportSettings::Serialize(FArchive& Archive)
 {
 	Super::Serialize( Archive );
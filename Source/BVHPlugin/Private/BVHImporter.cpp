@@ -6,9 +6,11 @@
 #include "Windows/WindowsHWrapper.h"
 #endif
 
+#include "HAL/FileManager.h"
 #include "Misc/Paths.h"
 #include "Misc/FeedbackContext.h"
 #include "Stats/StatsMisc.h"
+#include "ProfilingDebugging/ScopedTimers.h"
 #include "UObject/UObjectIterator.h"
 #include "UObject/UObjectHash.h"
 #include "RawIndexBuffer.h"
@@ -45,6 +47,7 @@
 #include "UObject/Package.h"
 #include "BVHFile.h"
 #include "BVHImportSettings.h"
+#include "BVHStats.h"
 
 #define LOCTEXT_NAMESPACE "BVHImporter"
 
@@ -52,13 +55,14 @@ DEFINE_LOG_CATEGORY_STATIC(LogBVHImporter, Verbose, All);
 
 
 FBVHImporter::FBVHImporter()
-	: ImportSettings(nullptr), BvhFile(nullptr)
+	: ImportSettings(nullptr), BvhFile(nullptr), MotionBytes(0), OpenSeconds(0.0)
 {
 
 }
 
 FBVHImporter::~FBVHImporter()
 {
+	DEC_MEMORY_STAT_BY(STAT_BVHMotionMemory, MotionBytes);
 	delete BvhFile;
 }
 
@@ -79,14 +83,35 @@ FBVHFile* FBVHImporter::GetBvhFile()
 
 const EBVHImportError FBVHImporter::OpenBVHFileForImport(const FString InFilePath)
 {
-	BvhFile = new FBVHFile(TCHAR_TO_ANSI ( * InFilePath));
-	if (!BvhFile->Open())
+	SCOPE_CYCLE_COUNTER(STAT_BVHOpenFile);
+	FScopedDurationTimer OpenTimer(OpenSeconds);
+
+	// Opening another file reuses the motion buffer of the previous one
+	if (BvhFile == nullptr)
+	{
+		BvhFile = new FBVHFile(TCHAR_TO_ANSI(*InFilePath));
+	}
+	else
+	{
+		BvhFile->SetFileName(TCHAR_TO_ANSI(*InFilePath));
+	}
+	DEC_MEMORY_STAT_BY(STAT_BVHMotionMemory, MotionBytes);
+
+	// Large files only get their header parsed, they are converted window by window later
+	const bool bOpened = ImportSettings->MakeSnapshot().ShouldStream(IFileManager::Get().FileSize(*InFilePath))
+		? BvhFile->OpenStreaming(1)
+		: BvhFile->Open();
+
+	MotionBytes = BvhFile->GetMotionBytes();
+	INC_MEMORY_STAT_BY(STAT_BVHMotionMemory, MotionBytes);
+	if (!bOpened)
 	{
 		return EBVHImportError::BVHImportError_FailedToOpenFile;
 	}
 
 	ImportSettings->MotionName = FString(BvhFile->GetMotionName().c_str());
 	ImportSettings->FrameNum = BvhFile->GetNumFrame();
+	ImportSettings->FrameStart = 0;
 	ImportSettings->FrameEnd = BvhFile->GetNumFrame() - 1;
 	ImportSettings->TimeStep = BvhFile->GetInterval();
 	ImportSettings->ResampleRate = 1 / ImportSettings->TimeStep;
@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHLibraryCommandlet.h"
+
+#include "HAL/FileManager.h"
+
+#include "BVHMotionLibrary.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHLibraryCommandlet)
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHLibraryCommandlet, Log, All);
+
+namespace BVHLibraryCommandlet
+{
+	static bool ParseChannel(const FString& Name, ChannelEnum& OutType)
+	{
+		static const TCHAR* Names[] = { TEXT("Xrotation"), TEXT("Yrotation"), TEXT("Zrotation"), TEXT("Xposition"), TEXT("Yposition"), TEXT("Zposition") };
+		for (int32 TypeIdx = 0; TypeIdx < UE_ARRAY_COUNT(Names); ++TypeIdx)
+		{
+			if (Name.Equals(Names[TypeIdx], ESearchCase::IgnoreCase))
+			{
+				OutType = (ChannelEnum)TypeIdx;
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+UBVHLibraryCommandlet::UBVHLibraryCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UBVHLibraryCommandlet::Main(const FString& Params)
+{
+	FString SourceDir;
+	FString LibraryPath;
+	int32 BatchSize = 64;
+
+	FParse::Value(*Params, TEXT("Library="), LibraryPath);
+	FParse::Value(*Params, TEXT("BatchSize="), BatchSize);
+	if (LibraryPath.IsEmpty())
+	{
+		UE_LOG(LogBVHLibraryCommandlet, Error, TEXT("-Library=<File> is required."));
+		return 1;
+	}
+
+	if (FParse::Value(*Params, TEXT("Source="), SourceDir))
+	{
+		TArray<FString> Files;
+		IFileManager::Get().FindFilesRecursive(Files, *SourceDir, TEXT("*.bvh"), true, false, false);
+		IFileManager::Get().FindFilesRecursive(Files, *SourceDir, TEXT("*.bvh.gz"), true, false, false);
+		Files.Sort();
+		if (Files.Num() == 0)
+		{
+			UE_LOG(LogBVHLibraryCommandlet, Error, TEXT("No BVH files under %s."), *SourceDir);
+			return 1;
+		}
+		return FBVHMotionLibrary::Build(Files, LibraryPath, BatchSize) ? 0 : 1;
+	}
+
+	FString JointName;
+	FString ChannelName;
+	double Below = 0.0;
+	ChannelEnum ChannelType = Y_POSITION;
+	if (!FParse::Value(*Params, TEXT("Joint="), JointName) || !FParse::Value(*Params, TEXT("Channel="), ChannelName)
+		|| !FParse::Value(*Params, TEXT("Below="), Below) || !BVHLibraryCommandlet::ParseChannel(ChannelName, ChannelType))
+	{
+		UE_LOG(LogBVHLibraryCommandlet, Error, TEXT("Either -Source=<Dir> or -Joint=<Name> -Channel=<Xrotation..Zposition> -Below=<Value> is required."));
+		return 1;
+	}
+
+	FBVHMotionLibrary Library;
+	if (!Library.Open(LibraryPath))
+	{
+		return 1;
+	}
+
+	TArray<FBVHLibraryRange> Ranges;
+	Library.FindFrames(JointName, ChannelType, [Below](double Value) { return Value < Below; }, Ranges);
+	for (const FBVHLibraryRange& Range : Ranges)
+	{
+		const FBVHLibraryTake& Take = Library.GetTake(Range.Take);
+		UE_LOG(LogBVHLibraryCommandlet, Display, TEXT("%s: frames %d-%d (%.2fs-%.2fs)"), *Take.SourceFilename,
+			Range.FirstFrame, Range.LastFrame, Range.FirstFrame * Take.FrameTime, Range.LastFrame * Take.FrameTime);
+	}
+	UE_LOG(LogBVHLibraryCommandlet, Display, TEXT("%d ranges in %d takes"), Ranges.Num(), Library.GetNumTakes());
+	return 0;
+}
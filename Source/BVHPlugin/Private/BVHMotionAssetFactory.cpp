@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHMotionAssetFactory.h"
+
+#include "AssetTypeCategories.h"
+
+#include "BVHMotionAsset.h"
+
+#define LOCTEXT_NAMESPACE "BVHMotionAssetFactory"
+
+UBVHMotionAssetFactory::UBVHMotionAssetFactory(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	bCreateNew = true;
+	bEditAfterNew = true;
+	SupportedClass = UBVHMotionAsset::StaticClass();
+}
+
+UObject* UBVHMotionAssetFactory::FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn)
+{
+	return NewObject<UBVHMotionAsset>(InParent, InClass, InName, Flags);
+}
+
+FText UBVHMotionAssetFactory::GetDisplayName() const
+{
+	return LOCTEXT("DisplayName", "BVH Motion");
+}
+
+uint32 UBVHMotionAssetFactory::GetMenuCategories() const
+{
+	return EAssetTypeCategories::Animation;
+}
+
+#undef LOCTEXT_NAMESPACE
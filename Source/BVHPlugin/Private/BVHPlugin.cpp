@@ -2,17 +2,29 @@
 
 #include "BVHPlugin.h"
 
+#include "MessageLogInitializationOptions.h"
+#include "MessageLogModule.h"
+
 #define LOCTEXT_NAMESPACE "FBVHPluginModule"
 
+const FName FBVHPluginModule::ImportLogName(TEXT("BVHImport"));
+
 void FBVHPluginModule::StartupModule()
 {
-	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	FMessageLogModule& MessageLogModule = FModuleManager::LoadModuleChecked<FMessageLogModule>("MessageLog");
+	FMessageLogInitializationOptions InitOptions;
+	InitOptions.bShowFilters = true;
+	InitOptions.bShowPages = true;
+	MessageLogModule.RegisterLogListing(ImportLogName, LOCTEXT("BVHImportLogLabel", "BVH Import"), InitOptions);
 }
 
 void FBVHPluginModule::ShutdownModule()
 {
-	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
-	// we call this function before unloading the module.
+	if (FModuleManager::Get().IsModuleLoaded("MessageLog"))
+	{
+		FMessageLogModule& MessageLogModule = FModuleManager::GetModuleChecked<FMessageLogModule>("MessageLog");
+		MessageLogModule.UnregisterLogListing(ImportLogName);
+	}
 }
 
 #undef LOCTEXT_NAMESPACE
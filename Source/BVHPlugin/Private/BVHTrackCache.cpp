@@ -0,0 +1,223 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHTrackCache.h"
+
+#include "DerivedDataCacheInterface.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include "Misc/SecureHash.h"
+#include "ReferenceSkeleton.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include "BVHAnimConverter.h"
+#include "BVHImportContext.h"
+#include "BVHImportFactory.h"
+#include "BVHImportSettings.h"
+
+/** Change this guid whenever the conversion or the serialized layout changes */
+#define BVHTRACKS_DERIVEDDATA_VER TEXT("4C8E2B7A19D3465F9E0A6B1C72D58F03")
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHTrackCache, Log, All);
+
+namespace BVHTrackCache
+{
+	static void SerializeSettings(FArchive& Ar, FBVHImportSnapshot& Settings)
+	{
+		uint8 SamplingType = (uint8)Settings.SamplingType;
+		Ar << SamplingType;
+		Settings.SamplingType = (EBVHSamplingType)SamplingType;
+
+		Ar << Settings.MotionName;
+		Ar << Settings.TimeStep;
+		Ar << Settings.FrameNum;
+		Ar << Settings.FrameStart;
+		Ar << Settings.FrameEnd;
+		Ar << Settings.ResampleRate;
+	}
+
+	static void SerializeAnimation(FArchive& Ar, FBVHConvertedAnimation& Animation)
+	{
+		SerializeSettings(Ar, Animation.Settings);
+
+		int32 NumTracks = Animation.Tracks.Num();
+		Ar << NumTracks;
+		Ar << Animation.NumKeys;
+		if (Ar.IsLoading())
+		{
+			Animation.Tracks.SetNum(NumTracks);
+		}
+		for (FBVHConvertedTrack& Track : Animation.Tracks)
+		{
+			Ar << Track.BoneName;
+			Ar << Track.RawTrack;
+		}
+
+		Ar << Animation.TrackHashes;
+	}
+}
+
+FString FBVHTrackCache::HashSourceFile(const FString& Filename)
+{
+	const FMD5Hash Hash = FMD5Hash::HashFile(*Filename);
+	return Hash.IsValid() ? LexToString(Hash) : FString();
+}
+
+uint32 FBVHTrackCache::GetSkeletonSignature(const FReferenceSkeleton& RefSkeleton)
+{
+	// FName hashes are not stable across runs, the key has to be built from the name strings
+	uint32 Signature = 0;
+	for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetRawBoneNum(); ++BoneIndex)
+	{
+		const FString BoneName = RefSkeleton.GetBoneName(BoneIndex).ToString();
+		const int32 ParentIndex = RefSkeleton.GetParentIndex(BoneIndex);
+		Signature = FCrc::StrCrc32(*BoneName, Signature);
+		Signature = FCrc::MemCrc32(&ParentIndex, sizeof(ParentIndex), Signature);
+	}
+	return Signature;
+}
+
+FString FBVHTrackCache::BuildKey(const FString& SourceHash, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot* Settings)
+{
+	FString KeySuffix = FString::Printf(TEXT("%s_%08x"), *SourceHash, GetSkeletonSignature(RefSkeleton));
+	if (Settings)
+	{
+		KeySuffix += FString::Printf(TEXT("_%d_%08x"), (int32)Settings->SamplingType, Settings->GetSamplingHash());
+	}
+	else
+	{
+		KeySuffix += TEXT("_file");
+	}
+
+	return FDerivedDataCacheInterface::BuildCacheKey(TEXT("BVHTRACKS"), BVHTRACKS_DERIVEDDATA_VER, *KeySuffix);
+}
+
+bool FBVHTrackCache::Get(const FString& Key, FBVHConvertedAnimation& OutAnimation)
+{
+	TArray<uint8> Data;
+	if (!GetDerivedDataCacheRef().GetSynchronous(*Key, Data, OutAnimation.SourceFilename))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	BVHTrackCache::SerializeAnimation(Reader, OutAnimation);
+	if (Reader.IsError())
+	{
+		UE_LOG(LogBVHTrackCache, Warning, TEXT("Discarding corrupted cached tracks for %s."), *OutAnimation.SourceFilename);
+		OutAnimation.Tracks.Reset();
+		OutAnimation.TrackHashes.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FBVHTrackCache::Put(const FString& Key, const FBVHConvertedAnimation& Animation)
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	BVHTrackCache::SerializeAnimation(Writer, const_cast<FBVHConvertedAnimation&>(Animation));
+
+	GetDerivedDataCacheRef().Put(*Key, Data, Animation.SourceFilename);
+}
+
+bool FBVHTrackCache::ConvertCached(const FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FString CacheKey;
+	if (Settings.bUseDerivedDataCache)
+	{
+		const FString SourceHash = HashSourceFile(OutAnimation.SourceFilename);
+		if (!SourceHash.IsEmpty())
+		{
+			CacheKey = BuildKey(SourceHash, RefSkeleton, &Settings);
+		}
+	}
+
+	if (!CacheKey.IsEmpty() && Get(CacheKey, OutAnimation))
+	{
+		OutAnimation.Settings = Settings;
+		OutAnimation.bFromCache = true;
+		if (Settings.bCreateMirrored)
+		{
+			FBVHAnimConverter::MirrorTracks(OutAnimation);
+		}
+		OutAnimation.ConvertSeconds = FPlatformTime::Seconds() - StartTime;
+		return true;
+	}
+
+	// A streaming file only holds its header, the frames are read again from the source
+	const bool bConverted = BvhFile.IsStreaming()
+		? FBVHAnimConverter::ConvertStreaming(OutAnimation.SourceFilename, RefSkeleton, Settings, OutAnimation)
+		: FBVHAnimConverter::Convert(BvhFile, RefSkeleton, Settings, OutAnimation);
+	if (!bConverted)
+	{
+		return false;
+	}
+
+	if (!CacheKey.IsEmpty())
+	{
+		Put(CacheKey, OutAnimation);
+	}
+	return true;
+}
+
+bool FBVHTrackCache::ConvertFile(const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation)
+{
+	FBVHScopedImportContext Context;
+	return ConvertFile(Context.Get(), Filename, RefSkeleton, InSettings, OutAnimation);
+}
+
+bool FBVHTrackCache::ConvertFile(FBVHImportContext& Context, const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The per-file settings are not known before parsing, so the key only covers the source and the skeleton
+	FString CacheKey;
+	if (InSettings.bUseDerivedDataCache)
+	{
+		const FString SourceHash = HashSourceFile(Filename);
+		if (!SourceHash.IsEmpty())
+		{
+			CacheKey = BuildKey(SourceHash, RefSkeleton, nullptr);
+		}
+	}
+
+	OutAnimation.SourceFilename = Filename;
+	if (!CacheKey.IsEmpty() && Get(CacheKey, OutAnimation))
+	{
+		// Cached settings hold the per-file fields, the shared ones come from this import.
+		// The key only covers the content, a copy of a take under another name is named after its own file
+		OutAnimation.Settings.MotionName = UBVHImportFactory::GetMotionName(Filename);
+		OutAnimation.Settings.Skeleton = InSettings.Skeleton;
+		OutAnimation.Settings.SamplingType = InSettings.SamplingType;
+		OutAnimation.Settings.bUseDerivedDataCache = InSettings.bUseDerivedDataCache;
+		OutAnimation.Settings.bCreateMirrored = InSettings.bCreateMirrored;
+		OutAnimation.Settings.MirrorAxis = InSettings.MirrorAxis;
+		OutAnimation.Settings.MirrorBonePairs = InSettings.MirrorBonePairs;
+		if (InSettings.bCreateMirrored)
+		{
+			// Mirrored tracks are not cached, mirroring is cheaper than a cache entry twice the size
+			FBVHAnimConverter::MirrorTracks(OutAnimation);
+		}
+		OutAnimation.SourceSize = IFileManager::Get().FileSize(*Filename);
+		OutAnimation.ParseSeconds = 0.0;
+		OutAnimation.ConvertSeconds = FPlatformTime::Seconds() - StartTime;
+		OutAnimation.bFromCache = true;
+		return true;
+	}
+
+	if (!FBVHAnimConverter::ConvertFile(Context, Filename, RefSkeleton, InSettings, OutAnimation))
+	{
+		return false;
+	}
+
+	if (!CacheKey.IsEmpty())
+	{
+		Put(CacheKey, OutAnimation);
+	}
+	return true;
+}
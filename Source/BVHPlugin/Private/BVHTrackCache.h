@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBVHFile;
+class FBVHImportContext;
+struct FBVHConvertedAnimation;
+struct FBVHImportSnapshot;
+struct FReferenceSkeleton;
+
+/**
+* Stores converted bone tracks in the Derived Data Cache, so unchanged sources are never parsed or converted twice.
+* All functions are thread safe.
+*/
+class FBVHTrackCache
+{
+public:
+	/**
+	* Builds the cache key of a source file converted onto a skeleton.
+	*
+	* @param SourceHash - Content hash of the source file, see HashSourceFile()
+	* @param Settings - Settings used for the conversion, nullptr when the per-file fields are taken from the file itself
+	*/
+	static FString BuildKey(const FString& SourceHash, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot* Settings);
+
+	/** Returns the content hash of a file, or an empty string if it cannot be read */
+	static FString HashSourceFile(const FString& Filename);
+
+	/** Signature of the bone names and hierarchy, which is all the conversion reads from the skeleton */
+	static uint32 GetSkeletonSignature(const FReferenceSkeleton& RefSkeleton);
+
+	static bool Get(const FString& Key, FBVHConvertedAnimation& OutAnimation);
+	static void Put(const FString& Key, const FBVHConvertedAnimation& Animation);
+
+	/**
+	* FBVHAnimConverter::Convert(), first looking the tracks up in the cache when the settings allow it.
+	* OutAnimation.SourceFilename must name the file BvhFile was opened from, a file opened for streaming is converted from it.
+	*/
+	static bool ConvertCached(const FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation);
+
+	/** FBVHAnimConverter::ConvertFile(), on a cache hit the file is never opened */
+	static bool ConvertFile(const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation);
+
+	/** Same as above, parsing into the file of a context on a cache miss */
+	static bool ConvertFile(FBVHImportContext& Context, const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation);
+};
@@ -0,0 +1,19 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHWatchFolderSettings.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHWatchFolderSettings)
+
+UBVHWatchFolderSettings::UBVHWatchFolderSettings(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	// Per user, every animator picks the folders of their own stage
+	ContainerName = TEXT("Editor");
+	CategoryName = TEXT("Plugins");
+
+	bEnabled = false;
+	SettleSeconds = 2.0f;
+	PollSeconds = 1.0f;
+	MaxConcurrentImports = 4;
+	bSaveImportedPackages = false;
+}
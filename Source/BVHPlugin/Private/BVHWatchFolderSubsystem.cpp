@@ -0,0 +1,367 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHWatchFolderSubsystem.h"
+
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/Async.h"
+#include "Editor.h"
+#include "EditorFramework/AssetImportData.h"
+#include "FileHelpers.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "ObjectTools.h"
+#include "PackageTools.h"
+#include "UObject/Package.h"
+
+#include "BVHAnimConverter.h"
+#include "BVHImportContext.h"
+#include "BVHImportFactory.h"
+#include "BVHImportSettings.h"
+#include "BVHStats.h"
+#include "BVHTrackCache.h"
+#include "BVHWatchFolderSettings.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHWatchFolderSubsystem)
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHWatchFolder, Log, All);
+
+namespace BVHWatchFolder
+{
+	/** Seconds between two ticks, a finished conversion waits at most this long to be committed */
+	static const float TickInterval = 0.1f;
+
+	/** Import data only keeps time stamps to the second */
+	static bool IsSameTimestamp(const FDateTime& A, const FDateTime& B)
+	{
+		return FMath::Abs((A - B).GetTotalSeconds()) < 1.0;
+	}
+}
+
+bool UBVHWatchFolderSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Commandlets import explicitly, see UBVHImportCommandlet
+	return Super::ShouldCreateSubsystem(Outer) && !IsRunningCommandlet();
+}
+
+void UBVHWatchFolderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UBVHWatchFolderSubsystem::Tick), BVHWatchFolder::TickInterval);
+}
+
+void UBVHWatchFolderSubsystem::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	// The workers only hold copies and shared pointers, they are waited for so none outlives the module
+	if (PendingScan.IsValid())
+	{
+		PendingScan.Wait();
+	}
+	for (FBVHWatchedImport& Import : Imports)
+	{
+		if (Import.Result.Get())
+		{
+			DEC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Import.Animation->GetTrackBytes());
+		}
+	}
+	Imports.Reset();
+	Files.Reset();
+	FBVHImportContext::Trim();
+
+	Super::Deinitialize();
+}
+
+void UBVHWatchFolderSubsystem::RequestScan()
+{
+	NextScanTime = 0.0;
+}
+
+int32 UBVHWatchFolderSubsystem::GetNumPendingFiles() const
+{
+	int32 NumPending = 0;
+	for (const TPair<FString, FBVHWatchedFile>& File : Files)
+	{
+		NumPending += (File.Value.bImporting || !BVHWatchFolder::IsSameTimestamp(File.Value.Timestamp, File.Value.ImportedTimestamp)) ? 1 : 0;
+	}
+	return NumPending;
+}
+
+bool UBVHWatchFolderSubsystem::Tick(float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UBVHWatchFolderSubsystem::Tick);
+
+	// One sequence per tick, writing the keys and compressing is the only work done on the game thread
+	for (int32 ImportIdx = 0; ImportIdx < Imports.Num(); ++ImportIdx)
+	{
+		if (Imports[ImportIdx].Result.IsReady())
+		{
+			FBVHWatchedImport Import = MoveTemp(Imports[ImportIdx]);
+			Imports.RemoveAt(ImportIdx);
+			CommitImport(Import);
+
+			// Takes written together reuse the motion buffers of each other, a single take does not keep them
+			if (Imports.Num() == 0)
+			{
+				FBVHImportContext::Trim();
+			}
+			break;
+		}
+	}
+
+	if (PendingScan.IsValid())
+	{
+		if (!PendingScan.IsReady())
+		{
+			return true;
+		}
+		ProcessScan(PendingScan.Consume());
+	}
+
+	const UBVHWatchFolderSettings* Settings = GetDefault<UBVHWatchFolderSettings>();
+	if (!Settings->bEnabled)
+	{
+		// Enabling again starts over from the import data of the sequences
+		Files.Reset();
+		return true;
+	}
+
+	// Which takes were already imported is only known once the registry finished its initial scan
+	const FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
+	if (AssetRegistryModule.Get().IsLoadingAssets())
+	{
+		return true;
+	}
+
+	if (FPlatformTime::Seconds() >= NextScanTime)
+	{
+		StartScan();
+	}
+	return true;
+}
+
+void UBVHWatchFolderSubsystem::StartScan()
+{
+	const UBVHWatchFolderSettings* Settings = GetDefault<UBVHWatchFolderSettings>();
+	NextScanTime = FPlatformTime::Seconds() + Settings->PollSeconds;
+
+	TArray<FBVHWatchFolder> Folders = Settings->Folders;
+	PendingScan = Async(EAsyncExecution::ThreadPool, [Folders = MoveTemp(Folders)]()
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(BVHWatchFolder_Scan);
+
+		TArray<FBVHScannedFile> ScannedFiles;
+		for (int32 FolderIndex = 0; FolderIndex < Folders.Num(); ++FolderIndex)
+		{
+			const FString& Directory = Folders[FolderIndex].Directory.Path;
+			if (Directory.IsEmpty() || !IFileManager::Get().DirectoryExists(*Directory))
+			{
+				continue;
+			}
+
+			auto Visitor = [&ScannedFiles, FolderIndex](const TCHAR* Path, const FFileStatData& StatData)
+			{
+				if (!StatData.bIsDirectory && UBVHImportFactory::IsBVHFilename(Path))
+				{
+					FBVHScannedFile& Scanned = ScannedFiles.AddDefaulted_GetRef();
+					Scanned.Filename = Path;
+					Scanned.FolderIndex = FolderIndex;
+					Scanned.Size = StatData.FileSize;
+					Scanned.Timestamp = StatData.ModificationTime;
+				}
+				return true;
+			};
+
+			if (Folders[FolderIndex].bIncludeSubfolders)
+			{
+				IFileManager::Get().IterateDirectoryStatRecursively(*Directory, Visitor);
+			}
+			else
+			{
+				IFileManager::Get().IterateDirectoryStat(*Directory, Visitor);
+			}
+		}
+		return ScannedFiles;
+	});
+}
+
+void UBVHWatchFolderSubsystem::ProcessScan(const TArray<FBVHScannedFile>& ScannedFiles)
+{
+	const UBVHWatchFolderSettings* Settings = GetDefault<UBVHWatchFolderSettings>();
+	const double Now = FPlatformTime::Seconds();
+
+	TSet<FString> ScannedNames;
+	ScannedNames.Reserve(ScannedFiles.Num());
+
+	for (const FBVHScannedFile& Scanned : ScannedFiles)
+	{
+		// The folders were edited while scanning, the next scan sees the new ones
+		if (!Settings->Folders.IsValidIndex(Scanned.FolderIndex))
+		{
+			continue;
+		}
+		ScannedNames.Add(Scanned.Filename);
+
+		FBVHWatchedFile* File = Files.Find(Scanned.Filename);
+		if (File == nullptr)
+		{
+			File = &Files.Add(Scanned.Filename);
+			File->ImportedTimestamp = GetImportedTimestamp(GetDestinationPath(Scanned.Filename, Scanned.FolderIndex), Scanned.Filename);
+		}
+
+		// Still being written, or written again: wait until it settles
+		if (File->Size != Scanned.Size || File->Timestamp != Scanned.Timestamp)
+		{
+			File->Size = Scanned.Size;
+			File->Timestamp = Scanned.Timestamp;
+			File->LastChangeTime = Now;
+			continue;
+		}
+
+		const bool bSettled = Now - File->LastChangeTime >= Settings->SettleSeconds;
+		const bool bChanged = !BVHWatchFolder::IsSameTimestamp(File->Timestamp, File->ImportedTimestamp);
+		if (bSettled && bChanged && !File->bImporting && File->Size > 0 && Imports.Num() < Settings->MaxConcurrentImports)
+		{
+			StartImport(Scanned.Filename, Scanned.FolderIndex, *File);
+		}
+	}
+
+	// A removed file is forgotten, written again it is a new take
+	for (TMap<FString, FBVHWatchedFile>::TIterator It = Files.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.bImporting && !ScannedNames.Contains(It->Key))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UBVHWatchFolderSubsystem::StartImport(const FString& Filename, int32 FolderIndex, FBVHWatchedFile& File)
+{
+	const FBVHWatchFolder& Folder = GetDefault<UBVHWatchFolderSettings>()->Folders[FolderIndex];
+	USkeleton* Skeleton = Folder.Skeleton.LoadSynchronous();
+	if (Skeleton == nullptr)
+	{
+		// Not retried until the file changes again
+		UE_LOG(LogBVHWatchFolder, Error, TEXT("No skeleton set for the watch folder %s, %s is not imported."), *Folder.Directory.Path, *Filename);
+		File.ImportedTimestamp = File.Timestamp;
+		return;
+	}
+
+	FBVHImportSnapshot Settings = GetDefault<UBVHImportSettings>()->MakeSnapshot();
+	Settings.Skeleton = Skeleton;
+	TSharedPtr<const FReferenceSkeleton> RefSkeleton = MakeShared<FReferenceSkeleton>(Skeleton->GetReferenceSkeleton());
+
+	UE_LOG(LogBVHWatchFolder, Display, TEXT("Importing %s."), *Filename);
+
+	FBVHWatchedImport& Import = Imports.AddDefaulted_GetRef();
+	Import.Filename = Filename;
+	Import.DestinationPath = GetDestinationPath(Filename, FolderIndex);
+	Import.Timestamp = File.Timestamp;
+	Import.Skeleton = Skeleton;
+	Import.Animation = MakeShared<FBVHConvertedAnimation>();
+
+	// The conversion only reads copies, the game thread keeps ticking while the file is parsed
+	Import.Result = Async(EAsyncExecution::ThreadPool, [Animation = Import.Animation, RefSkeleton, Settings, Filename]()
+	{
+		const bool bConverted = FBVHTrackCache::ConvertFile(Filename, *RefSkeleton, Settings, *Animation);
+		if (bConverted)
+		{
+			INC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Animation->GetTrackBytes());
+		}
+		return bConverted;
+	});
+
+	File.bImporting = true;
+}
+
+void UBVHWatchFolderSubsystem::CommitImport(FBVHWatchedImport& Import)
+{
+	// A file changed during the conversion differs from ImportedTimestamp and is imported again
+	if (FBVHWatchedFile* File = Files.Find(Import.Filename))
+	{
+		File->bImporting = false;
+		File->ImportedTimestamp = Import.Timestamp;
+	}
+
+	const bool bConverted = Import.Result.Get();
+	if (bConverted)
+	{
+		DEC_MEMORY_STAT_BY(STAT_BVHTrackMemory, Import.Animation->GetTrackBytes());
+	}
+
+	USkeleton* Skeleton = Import.Skeleton.Get();
+	if (!bConverted || Skeleton == nullptr)
+	{
+		UE_LOG(LogBVHWatchFolder, Error, TEXT("Failed to import %s."), *Import.Filename);
+		return;
+	}
+
+	// A new factory per sequence, so the previous one and the objects it lists can be collected
+	Factory = NewObject<UBVHImportFactory>(this);
+
+	const FString PackageName = Import.DestinationPath / ObjectTools::SanitizeObjectName(Import.Animation->Settings.MotionName);
+	UPackage* Outer = CreatePackage(*PackageName);
+
+	// Captured takes are not undoable, Ctrl+Z in the editor must not revert them. EndBatchCommit() sends the post import notifications
+	Factory->BeginBatchCommit();
+	UAnimSequence* Sequence = Factory->CommitReimport(*Import.Animation, Skeleton, Outer);
+	Factory->EndBatchCommit();
+	if (Sequence == nullptr)
+	{
+		UE_LOG(LogBVHWatchFolder, Error, TEXT("Failed to create the sequence of %s in %s."), *Import.Filename, *Import.DestinationPath);
+		return;
+	}
+
+	if (GetDefault<UBVHWatchFolderSettings>()->bSaveImportedPackages)
+	{
+		// The mirrored sequence is listed with the additional objects
+		TArray<UPackage*> Packages = { Sequence->GetPackage() };
+		for (UObject* Object : Factory->AdditionalImportedObjects)
+		{
+			if (Object)
+			{
+				Packages.AddUnique(Object->GetPackage());
+			}
+		}
+		UEditorLoadingAndSavingUtils::SavePackages(Packages, true);
+	}
+
+	UE_LOG(LogBVHWatchFolder, Display, TEXT("Imported %s as %s."), *Import.Filename, *Sequence->GetPathName());
+}
+
+FString UBVHWatchFolderSubsystem::GetDestinationPath(const FString& Filename, int32 FolderIndex)
+{
+	const FBVHWatchFolder& Folder = GetDefault<UBVHWatchFolderSettings>()->Folders[FolderIndex];
+
+	FString RelativePath = Filename;
+	FPaths::MakePathRelativeTo(RelativePath, *(Folder.Directory.Path / TEXT("")));
+	const FString RelativeDirectory = FPaths::GetPath(RelativePath);
+
+	const FString Destination = Folder.Destination.Path.IsEmpty() ? FString(TEXT("/Game")) : Folder.Destination.Path;
+	return UPackageTools::SanitizePackageName(RelativeDirectory.IsEmpty() ? Destination : Destination / RelativeDirectory);
+}
+
+FDateTime UBVHWatchFolderSubsystem::GetImportedTimestamp(const FString& DestinationPath, const FString& Filename)
+{
+	const FString SequenceName = ObjectTools::SanitizeObjectName(UBVHImportFactory::GetMotionName(Filename));
+	const FSoftObjectPath ObjectPath(DestinationPath / SequenceName + TEXT(".") + SequenceName);
+
+	const FAssetRegistryModule& AssetRegistryModule = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry");
+	const FAssetData AssetData = AssetRegistryModule.Get().GetAssetByObjectPath(ObjectPath);
+
+	FString ImportInfoJson;
+	if (AssetData.IsValid() && AssetData.GetTagValue(UObject::SourceFileTagName(), ImportInfoJson))
+	{
+		const TOptional<FAssetImportInfo> ImportInfo = FAssetImportInfo::FromJson(ImportInfoJson);
+		if (ImportInfo.IsSet() && ImportInfo->SourceFiles.Num() > 0)
+		{
+			return ImportInfo->SourceFiles[0].Timestamp;
+		}
+	}
+	return FDateTime::MinValue();
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Animation/AnimData/IAnimationDataModel.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#include "BVHAnimConverter.h"
+#include "BVHAssetImportData.h"
+#include "BVHFile.h"
+#include "BVHImportFactory.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace BVHReimportTest
+{
+	/** Transient skeleton with one bone per joint of the file, so that every joint converts to a track */
+	static USkeleton* MakeSkeleton(const FBVHFile& BvhFile)
+	{
+		USkeleton* Skeleton = NewObject<USkeleton>(GetTransientPackage());
+		{
+			FReferenceSkeletonModifier Modifier(Skeleton);
+			for (int32 JointIdx = 0; JointIdx < BvhFile.GetNumJoint(); ++JointIdx)
+			{
+				const Joint* joint = BvhFile.GetJoint(JointIdx);
+				const FString Name(joint->name.c_str());
+				Modifier.Add(FMeshBoneInfo(FName(*Name), Name, joint->parent ? joint->parent->index : INDEX_NONE), FTransform::Identity);
+			}
+		}
+		return Skeleton;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBVHTrimmedReimportTest, "BVHPlugin.Import.TrimmedReimport", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FBVHTrimmedReimportTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::ConvertRelativePathToFull(IPluginManager::Get().FindPlugin(TEXT("BVHPlugin"))->GetBaseDir() / TEXT("testdata/walk4_subject1.bvh"));
+	FBVHFile BvhFile(TCHAR_TO_ANSI(*Filename));
+	if (!TestTrue(TEXT("The sample take opens"), BvhFile.Open()))
+	{
+		return false;
+	}
+	USkeleton* Skeleton = BVHReimportTest::MakeSkeleton(BvhFile);
+
+	// Import frames 10 to 59 only, as picked in the import options
+	FBVHImportSnapshot Settings;
+	Settings.Skeleton = Skeleton;
+	Settings.ApplyFile(BvhFile);
+	Settings.FrameStart = 10;
+	Settings.FrameEnd = 59;
+
+	FBVHConvertedAnimation Animation;
+	Animation.SourceFilename = Filename;
+	if (!TestTrue(TEXT("The trimmed range converts"), FBVHAnimConverter::Convert(BvhFile, Skeleton->GetReferenceSkeleton(), Settings, Animation)))
+	{
+		return false;
+	}
+
+	UBVHImportFactory* Factory = NewObject<UBVHImportFactory>();
+	UAnimSequence* Sequence = Factory->CommitAnimation(Animation, Skeleton, CreatePackage(TEXT("/Temp/BVHTrimmedReimportTest")));
+	if (!TestNotNull(TEXT("The sequence is created"), Sequence))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Keys after import"), Sequence->GetDataModel()->GetNumberOfKeys(), 50);
+
+	// A full reimport starts by removing every bone track, an incremental one of an unchanged file touches none
+	int32 NumTracksRemoved = 0;
+	const FDelegateHandle Handle = Sequence->GetDataModel()->GetModifiedEvent().AddLambda(
+		[&NumTracksRemoved](const EAnimDataModelNotifyType& NotifyType, IAnimationDataModel* Model, const FAnimDataModelNotifPayload& Payload)
+		{
+			NumTracksRemoved += NotifyType == EAnimDataModelNotifyType::TrackRemoved ? 1 : 0;
+		});
+	const EReimportResult::Type Result = Factory->Reimport(Sequence);
+	Sequence->GetDataModel()->GetModifiedEvent().Remove(Handle);
+
+	const UBVHAssetImportData* ImportData = Cast<UBVHAssetImportData>(Sequence->AssetImportData);
+	TestEqual(TEXT("Reimport result"), (int32)Result, (int32)EReimportResult::Succeeded);
+	TestEqual(TEXT("Keys after reimport"), Sequence->GetDataModel()->GetNumberOfKeys(), 50);
+	TestTrue(TEXT("The range is stored"), ImportData && ImportData->FrameStart == 10 && ImportData->FrameEnd == 59);
+	TestEqual(TEXT("Tracks removed by the reimport of an unchanged file"), NumTracksRemoved, 0);
+
+	Sequence->ClearFlags(RF_Public | RF_Standalone);
+	Sequence->MarkAsGarbage();
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "AnimGraphNode_Base.h"
+#include "AnimNode_BVHLiveStream.h"
+#include "AnimGraphNode_BVHLiveStream.generated.h"
+
+/** Anim graph node of FAnimNode_BVHLiveStream */
+UCLASS()
+class UAnimGraphNode_BVHLiveStream : public UAnimGraphNode_Base
+{
+	GENERATED_UCLASS_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FAnimNode_BVHLiveStream Node;
+
+	//~ Begin UEdGraphNode Interface
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual FLinearColor GetNodeTitleColor() const override;
+	//~ End UEdGraphNode Interface
+
+	//~ Begin UAnimGraphNode_Base Interface
+	virtual FString GetNodeCategory() const override;
+	//~ End UAnimGraphNode_Base Interface
+};
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "AnimGraphNode_Base.h"
+#include "AnimNode_BVHMotionPlayer.h"
+#include "AnimGraphNode_BVHMotionPlayer.generated.h"
+
+/** Anim graph node of FAnimNode_BVHMotionPlayer */
+UCLASS()
+class UAnimGraphNode_BVHMotionPlayer : public UAnimGraphNode_Base
+{
+	GENERATED_UCLASS_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FAnimNode_BVHMotionPlayer Node;
+
+	//~ Begin UEdGraphNode Interface
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual FLinearColor GetNodeTitleColor() const override;
+	//~ End UEdGraphNode Interface
+
+	//~ Begin UAnimGraphNode_Base Interface
+	virtual FString GetNodeCategory() const override;
+	//~ End UAnimGraphNode_Base Interface
+};
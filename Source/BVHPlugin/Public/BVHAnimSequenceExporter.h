@@ -0,0 +1,18 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Exporters/Exporter.h"
+#include "BVHAnimSequenceExporter.generated.h"
+
+/** Exports animation sequences as .bvh from the content browser, including folder bulk export */
+UCLASS()
+class UBVHAnimSequenceExporter : public UExporter
+{
+	GENERATED_UCLASS_BODY()
+
+	//~ Begin UExporter Interface
+	virtual bool SupportsObject(UObject* Object) const override;
+	virtual bool ExportBinary(UObject* Object, const TCHAR* Type, FArchive& Ar, FFeedbackContext* Warn, int32 FileIndex = 0, uint32 PortFlags = 0) override;
+	//~ End UExporter Interface
+};
@@ -7,6 +7,8 @@
 #include "EditorFramework/AssetImportData.h"
 #include "BVHAssetImportData.generated.h"
 
+class UAnimSequence;
+
 /**
 * Base class for import data and options used when importing any asset from Alembic
 */
@@ -17,4 +19,40 @@ class BVHPLUGIN_API UBVHAssetImportData : public UAssetImportData
 public:
 	UPROPERTY()
 	FString SubjectName;
+
+	/** Content hash of the source channels of every imported bone track, used to only rewrite changed tracks on reimport */
+	UPROPERTY()
+	TMap<FName, uint32> TrackHashes;
+
+	/** Hash of the frame range and timing the tracks were imported with, any change forces a full reimport */
+	UPROPERTY()
+	uint32 SamplingHash;
+
+	/** Set when the sequence is a clip cut from a longer file, reimport then converts the same frame range */
+	UPROPERTY()
+	bool bIsClip;
+
+	/** Frame range imported from the source, kept on reimport unless it covered the whole file */
+	UPROPERTY()
+	int32 FrameStart;
+
+	UPROPERTY()
+	int32 FrameEnd;
+
+	/** Frames of the source when it was imported, 0 for sequences imported before the range was stored */
+	UPROPERTY()
+	int32 FrameNum;
+
+	/** Whether reimport converts the stored frame range, a sequence of the whole file follows the length of the new take */
+	bool HasTrimmedRange() const;
+
+	/** Set when the sequence is the mirrored animation of its source, reimport mirrors it again */
+	UPROPERTY()
+	bool bIsMirrored;
+
+	UPROPERTY()
+	TEnumAsByte<EAxis::Type> MirrorAxis;
+
+	/** Returns the BVH import data of the sequence, replacing generic import data while keeping its source files */
+	static UBVHAssetImportData* GetImportDataForSequence(UAnimSequence* Sequence);
 };
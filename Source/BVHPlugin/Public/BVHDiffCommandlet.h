@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BVHDiffCommandlet.generated.h"
+
+/**
+* Compares BVH files structurally and numerically, see FBVHDiff.
+*
+* Usage:
+*   UnrealEditor-Cmd.exe Project.uproject -run=BVHDiff -A=<File|Dir> -B=<File|Dir> [-PositionTolerance=0.001] [-RotationTolerance=0.001]
+*       [-OffsetTolerance=0.0001] [-Tolerances=Hips.Yposition=0.5+LeftHand.Zrotation=2] [-Worst=10] [-Report=<Csv>] [-BatchSize=16]
+*
+* With directories, every BVH file under A is compared with the file at the same relative path under B.
+* Returns 0 when every pair is equal within the tolerances, 1 otherwise.
+*/
+UCLASS()
+class UBVHDiffCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
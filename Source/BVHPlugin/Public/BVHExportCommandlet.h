@@ -0,0 +1,25 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BVHExportCommandlet.generated.h"
+
+/**
+* Headless bulk export of animation sequences to BVH.
+*
+* Usage:
+*   UnrealEditor-Cmd.exe Project.uproject -run=BVHExport -Source=/Game/Path -Dest=<Dir> [-Compress] [-Precision=6] [-BatchSize=64]
+*
+* Every UAnimSequence under the package path is written to Dest, keeping the folder layout below Source.
+* Sequences are loaded on the game thread, then sampled and written in parallel.
+*/
+UCLASS()
+class UBVHExportCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BVHImportCommandlet.generated.h"
+
+/**
+* Headless batch import of BVH libraries.
+*
+* Usage:
+*   UnrealEditor-Cmd.exe Project.uproject -run=BVHImport -Source=<Dir> | -Manifest=<File>
+*       -Skeleton=/Game/Path/Skeleton.Skeleton -Dest=/Game/Path [-Report=<File>] [-BatchSize=64]
+*
+* Files are parsed and converted in parallel, the UAnimSequence creation and saving happens on the game thread.
+* A manifest is a text file with one BVH path per line, relative paths are resolved against the manifest folder.
+* Subfolders of the source or manifest folder are created under -Dest, a name already used in the run gets a numbered suffix.
+*/
+UCLASS()
+class UBVHImportCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+private:
+	/** Collects the BVH files named by -Source or -Manifest, OutRootDir receives the folder their subfolders are relative to */
+	bool GatherSourceFiles(const FString& Params, TArray<FString>& OutFiles, FString& OutRootDir) const;
+};
@@ -4,6 +4,8 @@
 
 #include "Factories/Factory.h"
 #include "EditorReimportHandler.h"
+#include "Async/Future.h"
+#include "BVHImportSettings.h"
 #include "BVHImportFactory.generated.h"
 
 class UBVHImportSettings;
@@ -12,6 +14,16 @@ class UBVHAssetImportData;
 class SBVHImportOptions;
 
 class FBVHImporter;
+struct FBVHConvertedAnimation;
+struct FReferenceSkeleton;
+
+/** A file of a multi-file import that is parsed and converted in the background */
+struct FBVHPendingImport
+{
+	TWeakObjectPtr<UAnimSequence> Sequence;
+	TSharedPtr<FBVHConvertedAnimation> Animation;
+	TFuture<bool> Result;
+};
 
 UCLASS(hidecategories = Object)
 class BVHPLUGIN_API UBVHImportFactory : public UFactory, public FReimportHandler
@@ -27,6 +39,16 @@ class BVHPLUGIN_API UBVHImportFactory : public UFactory, public FReimportHandler
 
 	TArray<TWeakObjectPtr<UObject>> CreatedObjects;
 
+	/** Set when "Import All" was picked, the remaining files of the import reuse the same options */
+	bool bImportAll;
+
+	/** Options shared by every file of the current multi-file import */
+	FBVHImportSnapshot BatchSettings;
+	TSharedPtr<const FReferenceSkeleton> BatchRefSkeleton;
+
+	/** Files whose conversion is running, committed together in CleanUp() */
+	TArray<FBVHPendingImport> PendingImports;
+
 	//~ Begin UObject Interface
 	void PostInitProperties();
 	//~ End UObject Interface
@@ -37,6 +59,8 @@ class BVHPLUGIN_API UBVHImportFactory : public UFactory, public FReimportHandler
 	virtual UClass* ResolveSupportedClass() override;
 	virtual bool FactoryCanImport(const FString& Filename) override;
 	virtual UObject* FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled) override;
+	virtual void CleanUp() override;
+	virtual void ResetState() override;
 	//~ End UFactory Interface
 
 	//~ Begin FReimportHandler Interface
@@ -49,7 +73,71 @@ class BVHPLUGIN_API UBVHImportFactory : public UFactory, public FReimportHandler
 	virtual int32 GetPriority() const override;
 	//~ End FReimportHandler Interface
 
-	UAnimSequence* UBVHImportFactory::ImportAnimation(USkeleton* Skeleton, UObject* Outer, FBVHImporter* importer);
+	/** True for .bvh and gzip compressed .bvh.gz files */
+	static bool IsBVHFilename(const FString& Filename);
+
+	/** Name of the motion stored in a BVH file, the file name without its .bvh(.gz) extension */
+	static FString GetMotionName(const FString& Filename);
+
+	UAnimSequence* ImportAnimation(USkeleton* Skeleton, UObject* Outer, FBVHImporter* importer);
+
+	/** Imports every clip range of the settings as its own sequence from the already parsed file */
+	void ImportClips(USkeleton* Skeleton, UObject* Outer, FBVHImporter* Importer, TArray<UObject*>& OutSequences);
+
+	/**
+	* Creates or updates the UAnimSequence for already converted tracks, must be called on the game thread
+	*
+	* @param OutMirroredSequence - Receives the mirrored sequence written next to it, nullptr when the animation was not mirrored
+	*/
+	UAnimSequence* CommitAnimation(const FBVHConvertedAnimation& Animation, USkeleton* Skeleton, UObject* Outer, UAnimSequence** OutMirroredSequence = nullptr);
+
+	/** Creates or updates the mirrored sequence of a converted animation, nullptr when it was not mirrored */
+	UAnimSequence* CommitMirroredAnimation(const FBVHConvertedAnimation& Animation, USkeleton* Skeleton, UObject* Outer);
+
+	/**
+	* Writes an animation converted from a changed file into its sequence the way Reimport() does: only the changed tracks are rewritten
+	* when the sequence was imported with the same sampling, otherwise it is populated again. Creates the sequence when there is none.
+	* Animation loses its unchanged tracks.
+	*/
+	UAnimSequence* CommitReimport(FBVHConvertedAnimation& Animation, USkeleton* Skeleton, UObject* Outer);
+
+	/** Finds the sequence named after the motion next to Outer, or creates it */
+	UAnimSequence* FindOrCreateSequence(const FString& MotionName, UObject* Outer);
+
+	/** Replaces the animation data of DestSeq with the converted tracks */
+	void PopulateSequence(UAnimSequence* DestSeq, const FBVHConvertedAnimation& Animation, USkeleton* Skeleton);
+
+	/** Rewrites only the converted (changed) tracks of DestSeq and drops the tracks that are gone, without recreating the asset */
+	void UpdateSequenceInPlace(UAnimSequence* DestSeq, const FBVHConvertedAnimation& Animation, const TMap<FName, uint32>& PreviousHashes);
+
+	/**
+	* Starts committing a batch of sequences for unattended imports: the sequences are written without undo transactions and
+	* without PostEditChange(). EndBatchCommit() then finalizes them all at once, their compression running in parallel,
+	* and sends the asset registry and post import notifications.
+	*/
+	void BeginBatchCommit();
+	void EndBatchCommit();
+
+	bool IsBatchCommit() const { return bBatchCommit; }
+
+private:
+	/** Creates the asset for a file of a multi-file import and starts converting it in the background */
+	UObject* QueueBatchImport(UObject* InParent, const FString& Filename, const FBVHImportSnapshot& Settings, TSharedPtr<FBVHImporter> OpenedImporter);
+
+	/** Waits for the background conversions and writes their results into the assets */
+	void CommitPendingImports();
+
+	/** Records the source file and the per-track hashes on the sequence */
+	void StoreImportData(UAnimSequence* DestSeq, const FBVHConvertedAnimation& Animation);
+
+	/** Broadcasts the post import of an asset, or leaves it to EndBatchCommit() */
+	void BroadcastPostImport(UObject* Object);
+
+	bool bBatchCommit;
+
+	/** Sequences written since BeginBatchCommit(), and the ones created among them */
+	TArray<TWeakObjectPtr<UAnimSequence>> BatchSequences;
+	TArray<TWeakObjectPtr<UAnimSequence>> BatchCreatedSequences;
 
 
 };
\ No newline at end of file
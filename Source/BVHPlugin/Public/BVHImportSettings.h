@@ -4,22 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
-#include "BVHImportSettings.generated.h"
-
-UENUM(BlueprintType)
-enum class EEulerOrder : uint8
-{
-	None = 0 UMETA(Hidden),
-	ZXY = 1,
-};
 
-UENUM(BlueprintType)
-enum class EBVHSamplingType : uint8
-{
-	PerFrame,	
-	PerXFrames UMETA(DisplayName = "Per X Frames"),
-	PerTimeStep
-};
+#include "BVHConversionSettings.h"
+#include "BVHImportSettings.generated.h"
 
 UCLASS(Blueprintable)
 class BVHPLUGIN_API UBVHImportSettings : public UObject
@@ -33,6 +20,10 @@ public:
 		TimeStep = 0.0f;
 		FrameNum = FrameStart = FrameEnd = 0;
 		ResampleRate = DEFAULT_SAMPLERATE;
+		bUseDerivedDataCache = true;
+		StreamingThresholdMB = 512;
+		bCreateMirrored = false;
+		MirrorAxis = EAxis::X;
 	}
 
 	/** Skeleton to use for imported asset. When importing a mesh, leaving this as "None" will create a new skeleton. When importing an animation this MUST be specified to import the asset. */
@@ -67,10 +58,37 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Sampling)
 	int32 ResampleRate;	
 
+	/** Named frame ranges to import as separate animations from a single parse of the file, the whole range is imported when empty */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Clips)
+	TArray<FBVHClipRange> Clips;
+
+	/** Look converted tracks up in the Derived Data Cache, unchanged sources then skip parsing and conversion */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Cache)
+	bool bUseDerivedDataCache;
+
+	/** Files of at least this many megabytes are converted window by window instead of being loaded whole, 0 always loads them whole */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Memory, meta = (ClampMin = "0"))
+	int32 StreamingThresholdMB;
+
+	/** Also creates a left/right mirrored animation, named after the motion with a _Mirrored suffix, from the same parse */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mirror)
+	bool bCreateMirrored;
+
+	/** Normal of the mirror plane, X mirrors left and right for a character facing Y */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mirror, meta = (EditCondition = "bCreateMirrored"))
+	TEnumAsByte<EAxis::Type> MirrorAxis;
+
+	/** Bones swapped by the mirror, e.g. LeftUpLeg and RightUpLeg. Bones not listed swap Left and Right in their name */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Mirror, meta = (EditCondition = "bCreateMirrored"))
+	TMap<FName, FName> MirrorBonePairs;
+
 	/** Accessor and initializer **/
 	static UBVHImportSettings* Get();
 	bool bReimport;
 
+	/** Copies the current values into a snapshot that is owned by a single import */
+	FBVHImportSnapshot MakeSnapshot() const;
+
 public:
 	virtual void Serialize(class FArchive& Archive) override;
 };
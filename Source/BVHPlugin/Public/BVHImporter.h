@@ -57,6 +57,9 @@ public:
 
 	FBVHFile* GetBvhFile();
 
+	/** Time OpenBVHFileForImport() spent reading and parsing the file */
+	double GetOpenSeconds() const { return OpenSeconds; }
+
 private:
 	/**
 	* Creates an template object instance taking into account existing Instances and Objects (on reimporting)
@@ -79,4 +82,9 @@ private:
 
 	/** ABC file representation for currently opened filed */
 	FBVHFile* BvhFile;
+
+	/** Motion buffer of BvhFile counted in STAT_BVHMotionMemory */
+	SIZE_T MotionBytes;
+
+	double OpenSeconds;
 };
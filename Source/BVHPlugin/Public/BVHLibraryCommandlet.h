@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BVHLibraryCommandlet.generated.h"
+
+/**
+* Builds and queries motion libraries, see FBVHMotionLibrary.
+*
+* Usage:
+*   UnrealEditor-Cmd.exe Project.uproject -run=BVHLibrary -Source=<Dir> -Library=<File> [-BatchSize=64]
+*   UnrealEditor-Cmd.exe Project.uproject -run=BVHLibrary -Library=<File> -Joint=Hips -Channel=Yposition -Below=40
+*
+* The first form parses every BVH file under Source in parallel into one library file, the second one
+* lists the frame ranges where a channel is below a value.
+*/
+UCLASS()
+class UBVHLibraryCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
@@ -12,4 +12,7 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+	/** Message log listing that receives the timing summary of every import */
+	static const FName ImportLogName;
 };
@@ -0,0 +1,66 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Engine/EngineTypes.h"
+
+#include "BVHWatchFolderSettings.generated.h"
+
+class USkeleton;
+
+/** A folder whose BVH files are imported as soon as they are written */
+USTRUCT()
+struct FBVHWatchFolder
+{
+	GENERATED_BODY()
+
+	/** Folder the capture solver writes to, local or on a network share */
+	UPROPERTY(EditAnywhere, Category = "Watch Folder")
+	FDirectoryPath Directory;
+
+	/** Content folder the sequences are created in, subfolders of Directory are created under it */
+	UPROPERTY(EditAnywhere, Category = "Watch Folder", meta = (ContentDir))
+	FDirectoryPath Destination;
+
+	/** Skeleton the files are converted onto */
+	UPROPERTY(EditAnywhere, Category = "Watch Folder")
+	TSoftObjectPtr<USkeleton> Skeleton;
+
+	UPROPERTY(EditAnywhere, Category = "Watch Folder")
+	bool bIncludeSubfolders = true;
+};
+
+/**
+* Folders watched by UBVHWatchFolderSubsystem, under Editor Preferences > Plugins. New and changed files are converted
+* with the defaults of UBVHImportSettings: sampling, cache, streaming and mirror options.
+*/
+UCLASS(Config = EditorPerProjectUserSettings, meta = (DisplayName = "BVH Watch Folders"))
+class BVHPLUGIN_API UBVHWatchFolderSettings : public UDeveloperSettings
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	UPROPERTY(Config, EditAnywhere, Category = "Watch Folder")
+	bool bEnabled;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Watch Folder", meta = (EditCondition = "bEnabled"))
+	TArray<FBVHWatchFolder> Folders;
+
+	/** A file is imported once its size and time stamp stayed the same for this long, files still being written are left alone */
+	UPROPERTY(Config, EditAnywhere, Category = "Watch Folder", meta = (ClampMin = "0.1", Units = "s"))
+	float SettleSeconds;
+
+	/** Interval between two scans of the folders. Network shares do not report changes reliably, the folders are polled */
+	UPROPERTY(Config, EditAnywhere, Category = "Watch Folder", meta = (ClampMin = "0.1", Units = "s"))
+	float PollSeconds;
+
+	/** Files parsed and converted at the same time */
+	UPROPERTY(Config, EditAnywhere, Category = "Watch Folder", meta = (ClampMin = "1"))
+	int32 MaxConcurrentImports;
+
+	/** Saves the packages of every imported sequence. Otherwise they are left unsaved, like after a manual import, until the project is saved */
+	UPROPERTY(Config, EditAnywhere, Category = "Watch Folder")
+	bool bSaveImportedPackages;
+};
@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Containers/Ticker.h"
+#include "EditorSubsystem.h"
+
+#include "BVHWatchFolderSubsystem.generated.h"
+
+class UBVHImportFactory;
+class USkeleton;
+struct FBVHConvertedAnimation;
+
+/** A file found by a scan of the watch folders */
+struct FBVHScannedFile
+{
+	FString Filename;
+	int32 FolderIndex = INDEX_NONE;
+	int64 Size = 0;
+	FDateTime Timestamp;
+};
+
+/** What is known of a file of the watch folders between two scans */
+struct FBVHWatchedFile
+{
+	int64 Size = -1;
+	FDateTime Timestamp;
+
+	/** Time the size or time stamp last changed, in FPlatformTime::Seconds() */
+	double LastChangeTime = 0.0;
+
+	/** Time stamp of the source the sequence was last imported from, MinValue() when it never was */
+	FDateTime ImportedTimestamp = FDateTime::MinValue();
+
+	bool bImporting = false;
+};
+
+/** A file being parsed and converted in the background */
+struct FBVHWatchedImport
+{
+	FString Filename;
+	FString DestinationPath;
+	FDateTime Timestamp;
+	TWeakObjectPtr<USkeleton> Skeleton;
+	TSharedPtr<FBVHConvertedAnimation> Animation;
+	TFuture<bool> Result;
+};
+
+/**
+* Imports the BVH files written to the folders of UBVHWatchFolderSettings. A file is picked up once it stopped changing
+* for SettleSeconds, parsed and converted on the thread pool, then written into its sequence through UBVHImportFactory::CommitReimport(),
+* so a changed take only rewrites its changed tracks. Scans run on a worker thread and at most one sequence is committed per tick.
+*/
+UCLASS()
+class BVHPLUGIN_API UBVHWatchFolderSubsystem : public UEditorSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~ Begin USubsystem Interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~ End USubsystem Interface
+
+	/** Scans the folders at the next tick instead of waiting for the poll interval */
+	void RequestScan();
+
+	/** Files waiting to settle or being converted */
+	int32 GetNumPendingFiles() const;
+
+private:
+	bool Tick(float DeltaTime);
+
+	/** Lists the files of every folder on a worker thread */
+	void StartScan();
+
+	/** Records the sizes and time stamps of a finished scan, and starts converting the files that settled */
+	void ProcessScan(const TArray<FBVHScannedFile>& ScannedFiles);
+
+	void StartImport(const FString& Filename, int32 FolderIndex, FBVHWatchedFile& File);
+
+	/** Writes a finished conversion into its sequence */
+	void CommitImport(FBVHWatchedImport& Import);
+
+	/** Content folder of the sequence of a file, mirroring the subfolders of the watch folder */
+	static FString GetDestinationPath(const FString& Filename, int32 FolderIndex);
+
+	/** Time stamp of the source a sequence was imported from, read from the asset registry without loading the sequence */
+	static FDateTime GetImportedTimestamp(const FString& DestinationPath, const FString& Filename);
+
+	UPROPERTY(Transient)
+	TObjectPtr<UBVHImportFactory> Factory;
+
+	TMap<FString, FBVHWatchedFile> Files;
+	TArray<FBVHWatchedImport> Imports;
+	TFuture<TArray<FBVHScannedFile>> PendingScan;
+
+	double NextScanTime = 0.0;
+	FTSTicker::FDelegateHandle TickHandle;
+};
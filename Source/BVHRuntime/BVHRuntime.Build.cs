@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using System.IO;
+using UnrealBuildTool;
+
+public class BVHRuntime : ModuleRules
+{
+	public BVHRuntime(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Engine independent parsing and writing, also built natively by the CMakeLists.txt at the plugin root
+		PublicIncludePaths.Add(Path.Combine(ModuleDirectory, "Core", "Public"));
+
+		// No editor modules here, this module ships in packaged builds
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"AnimationCore",
+			}
+			);
+
+		// Live streams
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Sockets",
+				"Networking",
+			}
+			);
+
+		// Streaming .bvh.gz input and output
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+	}
+}
@@ -0,0 +1,60 @@
+#include "BVHCore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+	std::atomic< FBVHCore::ParallelForFunction >  parallel_for_function(NULL);
+}
+
+
+void  FBVHCore::SetParallelFor(ParallelForFunction function)
+{
+	parallel_for_function.store(function);
+}
+
+void  FBVHCore::ParallelFor(int num, const std::function< void(int) >& body, bool force_single_thread)
+{
+	ParallelForFunction  function = parallel_for_function.load();
+	if (function != NULL)
+	{
+		function(num, body, force_single_thread);
+		return;
+	}
+
+	const int  num_threads = force_single_thread ? 1 : std::min< int >(num, (int)std::thread::hardware_concurrency());
+	if (num_threads <= 1)
+	{
+		for (int i = 0; i < num; i++)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	// Indices are handed out one at a time, the calling thread works too
+	std::atomic< int >  next(0);
+	auto  worker = [&]()
+	{
+		for (int i = next++; i < num; i = next++)
+		{
+			body(i);
+		}
+	};
+
+	std::vector< std::thread >  threads;
+	threads.reserve(num_threads - 1);
+	for (int t = 1; t < num_threads; t++)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
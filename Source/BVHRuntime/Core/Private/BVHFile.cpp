@@ -0,0 +1,1080 @@
+#include "BVHFile.h"
+
+#ifdef  _MSC_VER
+#pragma warning( disable : 4996)
+#pragma warning( disable : 4244)
+#pragma warning( disable : 4018)
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string.h>
+#include <unordered_map>
+
+#include "BVHStream.h"
+#include "BVHTextBuffer.h"
+
+
+namespace
+{
+	// The least recently used hierarchy is dropped above this count, files still holding one keep it
+	const size_t  max_cached_hierarchies = 64;
+
+	// HIERARCHY sections longer than this are parsed straight from the file and not cached
+	const size_t  max_hierarchy_bytes = 1 << 20;
+
+	const double  degrees_to_radians = 3.14159265358979323846 / 180.0;
+	const double  radians_to_degrees = 180.0 / 3.14159265358979323846;
+
+	struct  CachedHierarchy
+	{
+		std::shared_ptr< const FBVHHierarchy >  hierarchy;
+		unsigned long long                      last_use;
+	};
+
+	std::mutex  hierarchy_cache_mutex;
+	std::unordered_map< std::string, CachedHierarchy >  hierarchy_cache;
+	unsigned long long  hierarchy_cache_uses = 0;
+	std::atomic< int >  hierarchy_cache_hits(0);
+
+	const std::shared_ptr< const FBVHHierarchy >&  EmptyHierarchy()
+	{
+		static const std::shared_ptr< const FBVHHierarchy >  empty = std::make_shared< FBVHHierarchy >();
+		return  empty;
+	}
+}
+
+
+FBVHHierarchy::~FBVHHierarchy()
+{
+	for (int i = 0; i < channels.size(); i++)
+	{
+		delete  channels[i];
+	}
+	for (int i = 0; i < joints.size(); i++)
+	{
+		delete  joints[i];
+	}
+}
+
+
+FBVHFile::FBVHFile(const char* file_name)
+	: hierarchy(EmptyHierarchy())
+	, is_sample_ready(false)
+{
+	bvh_file_name = file_name;
+	motion = NULL;
+	motion_capacity = 0;
+	reader = NULL;
+	stream_reader = NULL;
+	window_capacity = 0;
+	window_first_frame = 0;
+	window_num_frame = 0;
+}
+
+FBVHFile::~FBVHFile()
+{
+	Clear();
+	ReleaseMotion();
+}
+
+void  FBVHFile::Clear()
+{
+	is_load_success = false;
+	num_channel = 0;
+	hierarchy = EmptyHierarchy();
+
+	num_frame = 0;
+	interval = 0.0;
+
+	CloseStreaming();
+	window_capacity = 0;
+	window_first_frame = 0;
+	window_num_frame = 0;
+
+	ResetSamples();
+}
+
+void  FBVHFile::SetFileName(const char* file_name)
+{
+	Clear();
+	bvh_file_name = file_name;
+}
+
+void  FBVHFile::ReleaseMotion()
+{
+	CloseStreaming();
+	delete[]  motion;
+	motion = NULL;
+	motion_capacity = 0;
+	delete  reader;
+	reader = NULL;
+}
+
+double*  FBVHFile::ReserveMotion(size_t num_values)
+{
+	if (num_values > motion_capacity)
+	{
+		delete[]  motion;
+		motion = new double[num_values];
+		motion_capacity = num_values;
+	}
+	return  motion;
+}
+
+FBVHLineReader&  FBVHFile::GetReader()
+{
+	if (reader == NULL)
+	{
+		reader = new FBVHLineReader();
+	}
+	return  *reader;
+}
+
+
+void  FBVHFile::Init(const char* name,
+	int n_joi, const Joint** a_joi, int n_chan, const Channel** a_chan,
+	int n_frame, double inter, const double* mo)
+{
+	SetSkeleton(name, n_joi, a_joi, n_chan, a_chan);
+	SetMotion(n_frame, inter, mo);
+}
+
+
+void  FBVHFile::SetSkeleton(const char* name,
+	int n_joi, const Joint** a_joi, int n_chan, const Channel** a_chan)
+{
+	Clear();
+	int  i, j;	
+
+	if (name)
+	{
+		motion_name = name;
+	}
+	num_channel = n_chan;
+
+	std::shared_ptr< FBVHHierarchy >  copied = std::make_shared< FBVHHierarchy >();
+	std::vector< Channel* >&  channels = copied->channels;
+	std::vector< Joint* >&  joints = copied->joints;
+
+	channels.resize(num_channel);
+	for (i = 0; i < num_channel; i++)
+	{
+		channels[i] = new Channel();
+	}
+	joints.resize(n_joi);
+	for (i = 0; i < n_joi; i++)
+	{
+		joints[i] = new Joint();
+	}
+
+	for (i = 0; i < num_channel; i++)
+	{
+		*channels[i] = *a_chan[i];
+		channels[i]->joint = joints[a_chan[i]->joint->index];
+	}
+	for (i = 0; i < n_joi; i++)
+	{
+		*joints[i] = *a_joi[i];
+		for (j = 0; j < joints[i]->channels.size(); j++)
+		{
+			joints[i]->channels[j] = channels[a_joi[i]->channels[j]->index];
+		}
+		if (a_joi[i]->parent == NULL)
+		{
+			joints[i]->parent = NULL;
+		}
+		else
+		{
+			joints[i]->parent = joints[a_joi[i]->parent->index];
+		}
+		for (j = 0; j < joints[i]->children.size(); j++)
+		{
+			joints[i]->children[j] = joints[a_joi[i]->children[j]->index];
+		}
+
+		if (joints[i]->name.size() > 0)
+		{
+			copied->joint_index[joints[i]->name] = joints[i];
+		}
+	}
+	hierarchy = copied;
+}
+
+
+void  FBVHFile::SetMotion(int n_frame, double inter, const double* mo)
+{
+	// Transforms built for Sample() are of the previous motion
+	ResetSamples();
+
+	num_frame = n_frame;
+	interval = inter;
+	ReserveMotion((size_t)num_frame * num_channel);
+	if (mo != NULL)
+	{
+		memcpy(motion, mo, sizeof(double) * num_frame * num_channel);
+	}
+}
+
+bool  FBVHFile::Open()
+{
+	BVH_TRACE_SCOPE(BVHFile_Open);
+
+	Clear();
+
+	FBVHLineReader&  file = GetReader();
+
+	SetMotionNameFromFile();
+
+	if (file.Open(bvh_file_name.c_str()))
+	{
+		Read(file, false);
+	}
+	file.Close();
+	return is_load_success;
+}
+
+void  FBVHFile::SetMotionNameFromFile()
+{
+	const char* mn_first = bvh_file_name.c_str();
+	const char* mn_last = bvh_file_name.c_str() + strlen(bvh_file_name.c_str());
+	if (strrchr(bvh_file_name.c_str(), '\\') != NULL)
+	{
+		mn_first = strrchr(bvh_file_name.c_str(), '\\') + 1;
+	}
+	else if (strrchr(bvh_file_name.c_str(), '/') != NULL)
+	{
+		mn_first = strrchr(bvh_file_name.c_str(), '/') + 1;
+	}
+	if (FBVHOutputFile::IsCompressedName(bvh_file_name.c_str()))
+	{
+		// name.bvh.gz
+		mn_last -= 3;
+	}
+	for (const char* c = mn_last - 1; c >= mn_first; c--)
+	{
+		if (*c == '.')
+		{
+			mn_last = c;
+			break;
+		}
+	}
+	if (mn_last < mn_first)
+	{
+		mn_last = bvh_file_name.c_str() + strlen(bvh_file_name.c_str());
+	}
+	motion_name.assign(mn_first, mn_last);
+}
+
+bool  FBVHFile::ParseHeader(const char* text, size_t length)
+{
+	Clear();
+
+	FBVHLineReader&  file = GetReader();
+	if (file.Open(text, length))
+	{
+		Read(file, true);
+	}
+	file.Close();
+
+	// Frames follow one by one, e.g. on a live stream
+	num_frame = 0;
+	return is_load_success;
+}
+
+bool  FBVHFile::OpenStreaming(int window_frames)
+{
+	BVH_TRACE_SCOPE(BVHFile_OpenStreaming);
+
+	Clear();
+	SetMotionNameFromFile();
+
+	stream_reader = &GetReader();
+	if (!stream_reader->Open(bvh_file_name.c_str()) || !Read(*stream_reader, true))
+	{
+		CloseStreaming();
+		return false;
+	}
+
+	window_capacity = (window_frames > 0) ? window_frames : 1;
+	ReserveMotion((size_t)window_capacity * num_channel);
+	return true;
+}
+
+int  FBVHFile::ReadWindow()
+{
+	BVH_TRACE_SCOPE(BVHFile_ReadWindow);
+
+	window_first_frame += window_num_frame;
+	window_num_frame = 0;
+	if (stream_reader == NULL)
+	{
+		return 0;
+	}
+
+	while (window_num_frame < window_capacity && window_first_frame + window_num_frame < num_frame)
+	{
+		char*  line = stream_reader->ReadLine();
+		if (line == NULL || !ParseFrame(line, &motion[(size_t)window_num_frame * num_channel]))
+		{
+			// Fewer or shorter frame lines than the header announced
+			is_load_success = false;
+			CloseStreaming();
+			break;
+		}
+		window_num_frame++;
+	}
+	return window_num_frame;
+}
+
+void  FBVHFile::CloseStreaming()
+{
+	if (stream_reader != NULL)
+	{
+		// The reader is kept with its blocks for the next file
+		stream_reader->Close();
+		stream_reader = NULL;
+	}
+}
+
+bool  FBVHFile::ParseFrame(char* line, double* frame) const
+{
+	char  separater[] = " :,\t";
+	char* token = strtok(line, separater);
+	for (int j = 0; j < num_channel; j++)
+	{
+		if (token == NULL)
+		{
+			return false;
+		}
+		frame[j] = atof(token);
+		token = strtok(NULL, separater);
+	}
+	return true;
+}
+
+void  FBVHFile::ParseHierarchy(FBVHLineReader& file, FBVHHierarchy& parsed, FBVHLineReader* rest)
+{
+	BVH_TRACE_SCOPE(BVHFile_ParseHierarchy);
+
+	char*          line;
+	char*          token;
+	char           separater[] = " :,\t";
+	
+	std::vector< Channel* >&  channels = parsed.channels;
+	std::vector< Joint* >&    joints = parsed.joints;
+	std::map< std::string, Joint* >&  joint_index = parsed.joint_index;
+
+	std::vector< Joint* >   joint_stack;
+	Joint*        joint = NULL;
+	Joint*        new_joint = NULL;
+	bool          is_site = false;
+	double        x, y, z;
+	int           i;
+
+	while ((line = file.ReadLine()) != NULL || (rest != NULL && (line = rest->ReadLine()) != NULL))
+	{
+		token = strtok(line, separater);
+		if (token == NULL)  continue;
+		if (strcmp(token, "{") == 0)
+		{
+			joint_stack.push_back(joint);
+			joint = new_joint;
+			continue;
+		}
+		if (strcmp(token, "}") == 0)
+		{
+			joint = joint_stack.back();
+			joint_stack.pop_back();
+			is_site = false;
+			continue;
+		}
+
+		if ((strcmp(token, "ROOT") == 0) || (strcmp(token, "JOINT") == 0))
+		{
+			new_joint = new Joint();
+			new_joint->index = joints.size();
+			new_joint->parent = joint;
+			new_joint->has_site = false;
+			new_joint->offset[0] = 0.0;  new_joint->offset[1] = 0.0;  new_joint->offset[2] = 0.0;
+			new_joint->site[0] = 0.0;  new_joint->site[1] = 0.0;  new_joint->site[2] = 0.0;
+			joints.push_back(new_joint);
+			if (joint)
+			{
+				joint->children.push_back(new_joint);
+			}
+
+			token = strtok(NULL, "");
+			while (*token == ' ')
+			{
+				token++;
+			}
+			new_joint->name = token;
+
+			joint_index[new_joint->name] = new_joint;
+			continue;
+		}
+
+		if ((strcmp(token, "End") == 0))
+		{
+			new_joint = joint;
+			is_site = true;
+			continue;
+		}
+
+		if (strcmp(token, "OFFSET") == 0)
+		{
+			token = strtok(NULL, separater);
+			x = token ? atof(token) : 0.0;
+			token = strtok(NULL, separater);
+			y = token ? atof(token) : 0.0;
+			token = strtok(NULL, separater);
+			z = token ? atof(token) : 0.0;
+
+			if (is_site)
+			{
+				joint->has_site = true;
+				joint->site[0] = x;
+				joint->site[1] = y;
+				joint->site[2] = z;
+			}
+			else
+			{
+				joint->offset[0] = x;
+				joint->offset[1] = y;
+				joint->offset[2] = z;
+			}
+			continue;
+		}
+
+		if (strcmp(token, "CHANNELS") == 0)
+		{
+			token = strtok(NULL, separater);
+			joint->channels.resize(token ? atoi(token) : 0);
+
+			for (i = 0; i < joint->channels.size(); i++)
+			{
+				Channel* channel = new Channel();
+				channel->joint = joint;
+				channel->index = channels.size();
+				channels.push_back(channel);
+				joint->channels[i] = channel;
+
+				token = strtok(NULL, separater);
+				if (strcmp(token, "Xrotation") == 0)
+				{
+					channel->type = X_ROTATION;
+				}
+				else if (strcmp(token, "Yrotation") == 0)
+				{
+					channel->type = Y_ROTATION;
+				}
+				else if (strcmp(token, "Zrotation") == 0)
+				{
+					channel->type = Z_ROTATION;
+				}
+				else if (strcmp(token, "Xposition") == 0)
+				{
+					channel->type = X_POSITION;
+				}
+				else if (strcmp(token, "Yposition") == 0)
+				{
+					channel->type = Y_POSITION;
+				}
+				else if (strcmp(token, "Zposition") == 0)
+				{
+					channel->type = Z_POSITION;
+				}
+			}
+		}
+
+		if (strcmp(token, "MOTION") == 0)
+		{
+			break;
+		}
+	}
+}
+
+void  FBVHFile::ClearHierarchyCache()
+{
+	std::lock_guard< std::mutex >  lock(hierarchy_cache_mutex);
+	hierarchy_cache.clear();
+	hierarchy_cache_hits = 0;
+}
+
+int  FBVHFile::GetHierarchyCacheHits()
+{
+	return  hierarchy_cache_hits;
+}
+
+bool  FBVHFile::Read(FBVHLineReader& file, bool is_header_only)
+{
+	char*          line;
+	char*          token;
+	char           separater[] = " :,\t";
+	bool           is_found = false;
+	bool           is_motion_found = false;
+	bool           is_cacheable = false;
+	int            i;
+
+	// The HIERARCHY text is looked up before being parsed, files of the same rig skip straight to MOTION
+	std::string  hierarchy_text;
+	while (hierarchy_text.size() < max_hierarchy_bytes && (line = file.ReadLine()) != NULL)
+	{
+		hierarchy_text.append(line);
+		hierarchy_text.push_back('\n');
+
+		token = strtok(line, separater);
+		if (token != NULL && strcmp(token, "MOTION") == 0)
+		{
+			is_motion_found = true;
+			break;
+		}
+	}
+
+	if (is_motion_found)
+	{
+		std::lock_guard< std::mutex >  lock(hierarchy_cache_mutex);
+		auto  cached = hierarchy_cache.find(hierarchy_text);
+		if (cached != hierarchy_cache.end())
+		{
+			hierarchy = cached->second.hierarchy;
+			cached->second.last_use = ++hierarchy_cache_uses;
+			hierarchy_cache_hits++;
+		}
+	}
+	if (hierarchy == EmptyHierarchy())
+	{
+		std::shared_ptr< FBVHHierarchy >  parsed = std::make_shared< FBVHHierarchy >();
+
+		// A text cut at max_hierarchy_bytes is parsed on from the file, the hierarchy is then not shared
+		FBVHLineReader  hierarchy_reader;
+		hierarchy_reader.Open(hierarchy_text.data(), hierarchy_text.size());
+		ParseHierarchy(hierarchy_reader, *parsed, is_motion_found ? NULL : &file);
+		parsed->hash = is_motion_found ? std::hash< std::string >()(hierarchy_text) : 0;
+		hierarchy = parsed;
+		is_cacheable = is_motion_found;
+	}
+
+	is_found = false;
+	while ((line = file.ReadLine()) != NULL)
+	{
+		token = strtok(line, separater);
+		if (!token)
+		{
+			continue;
+		}
+		if (strcmp(token, "Frames") == 0)
+		{
+			is_found = true;
+			break;
+		}
+	}
+	if (!is_found)
+	{
+		goto bvh_error;
+	}
+	token = strtok(NULL, separater);
+	if (token == NULL)
+	{
+		goto bvh_error;
+	}
+	num_frame = atoi(token);
+
+	is_found = false;
+	while ((line = file.ReadLine()) != NULL)
+	{
+		token = strtok(line, ":");
+		if (!token)
+		{
+			continue;
+		}
+		if (strcmp(token, "Frame Time") == 0)
+		{
+			is_found = true;
+			break;
+		}
+	}
+	if (!is_found)
+	{
+		goto bvh_error;
+	}
+	token = strtok(NULL, separater);
+	if (token == NULL)
+	{
+		goto bvh_error;
+	}
+	interval = atof(token);
+
+	num_channel = hierarchy->channels.size();
+	if (!is_header_only)
+	{
+		BVH_TRACE_SCOPE(BVHFile_ParseMotion);
+
+		ReserveMotion((size_t)num_frame * num_channel);
+
+		for (i = 0; i < num_frame; i++)
+		{
+			line = file.ReadLine();
+			if (line == NULL || !ParseFrame(line, &motion[i * num_channel]))
+			{
+				goto bvh_error;
+			}
+		}
+
+		// The gzip trailer after the last frame is what checks the inflated text
+		if (file.IsCompressed())
+		{
+			while (file.ReadLine() != NULL)
+			{
+			}
+		}
+		if (file.HasError())
+		{
+			goto bvh_error;
+		}
+	}
+
+	// Only hierarchies of files that read completely are shared, a file cut short or malformed does not replace a good one
+	if (is_cacheable)
+	{
+		std::lock_guard< std::mutex >  lock(hierarchy_cache_mutex);
+		if (hierarchy_cache.size() >= max_cached_hierarchies)
+		{
+			auto  oldest = hierarchy_cache.begin();
+			for (auto entry = hierarchy_cache.begin(); entry != hierarchy_cache.end(); ++entry)
+			{
+				oldest = (entry->second.last_use < oldest->second.last_use) ? entry : oldest;
+			}
+			hierarchy_cache.erase(oldest);
+		}
+		CachedHierarchy  cached = { hierarchy, ++hierarchy_cache_uses };
+		hierarchy_cache.emplace(std::move(hierarchy_text), cached);
+	}
+	is_load_success = true;
+
+bvh_error:
+	return is_load_success;
+}
+
+FBVHTransform FBVHFile::GetTransform(int n_frame, int n_joint) const
+{
+	return GetTransform(&motion[n_frame * num_channel], n_joint);
+}
+
+FBVHTransform FBVHFile::GetTransform(const double* p, int n_joint) const
+{
+	const Joint* j = hierarchy->joints[n_joint];
+
+	FBVHVector Offset;
+	FBVHVector Euler;
+
+	Offset.X = j->offset[0];
+	Offset.Y = -j->offset[1];
+	Offset.Z = j->offset[2];
+
+	for (int i = 0; i < j->channels.size(); ++i)
+	{
+		Channel* c = j->channels[i];
+		if (c->type == ChannelEnum::X_POSITION)
+		{
+			Offset.X = p[c->index];
+		}
+		else if (c->type == ChannelEnum::Y_POSITION)
+		{
+			Offset.Y = -p[c->index];
+		}
+		else if (c->type == ChannelEnum::Z_POSITION)
+		{
+			Offset.Z = p[c->index];
+		}
+		else 
+			
+		if (c->type == ChannelEnum::Z_ROTATION)
+		{
+			Euler.Z = -p[c->index];
+		}
+		else if (c->type == ChannelEnum::Y_ROTATION)
+		{
+			Euler.Y = p[c->index];
+		}
+		else if (c->type == ChannelEnum::X_ROTATION)
+		{
+			Euler.X = -p[c->index];
+		}
+	}
+
+	double RadX = Euler.X * degrees_to_radians;
+	double RadY = Euler.Y * degrees_to_radians;
+	double RadZ = Euler.Z * degrees_to_radians;
+
+	FBVHQuat RotationZ(FBVHVector(0.0, 0.0, 1.0), RadZ);
+	FBVHQuat RotationY(FBVHVector(0.0, 1.0, 0.0), RadY);
+	FBVHQuat RotationX(FBVHVector(1.0, 0.0, 0.0), RadX);
+	FBVHQuat Rotation = RotationZ * RotationY * RotationX;
+
+	return FBVHTransform(Rotation, Offset);
+}
+
+void  FBVHFile::ResetSamples()
+{
+	std::lock_guard< std::mutex >  lock(sample_mutex);
+	is_sample_ready = false;
+	sample_positions.clear();
+	sample_positions.shrink_to_fit();
+	sample_rotations.clear();
+	sample_rotations.shrink_to_fit();
+}
+
+void  FBVHFile::BuildSamples() const
+{
+	std::lock_guard< std::mutex >  lock(sample_mutex);
+	if (is_sample_ready.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	BVH_TRACE_SCOPE(BVHFile_BuildSamples);
+
+	const int  num_joint = hierarchy->joints.size();
+	sample_positions.resize((size_t)num_frame * num_joint);
+	sample_rotations.resize((size_t)num_frame * num_joint);
+
+	const int  frames_per_block = 256;
+	const int  num_block = (num_frame + frames_per_block - 1) / frames_per_block;
+	FBVHCore::ParallelFor(num_block, [&](int block)
+	{
+		const int  first_frame = block * frames_per_block;
+		const int  last_frame = (first_frame + frames_per_block < num_frame) ? first_frame + frames_per_block : num_frame;
+		for (int f = first_frame; f < last_frame; f++)
+		{
+			for (int j = 0; j < num_joint; j++)
+			{
+				const FBVHTransform  transform = GetTransform(f, j);
+				sample_positions[(size_t)f * num_joint + j] = transform.GetTranslation();
+				sample_rotations[(size_t)f * num_joint + j] = transform.GetRotation();
+			}
+		}
+	});
+
+	is_sample_ready.store(true, std::memory_order_release);
+}
+
+void  FBVHFile::Sample(double time, const int* sample_joints, int num_sample_joints, FBVHTransform* out_transforms) const
+{
+	SampleMany(&time, 1, sample_joints, num_sample_joints, out_transforms);
+}
+
+void  FBVHFile::SampleMany(const double* times, int num_times, const int* sample_joints, int num_sample_joints, FBVHTransform* out_transforms) const
+{
+	if (sample_joints == NULL)
+	{
+		num_sample_joints = hierarchy->joints.size();
+	}
+	if (num_frame == 0)
+	{
+		for (int i = 0; i < num_times * num_sample_joints; i++)
+		{
+			out_transforms[i] = FBVHTransform();
+		}
+		return;
+	}
+	if (!is_sample_ready.load(std::memory_order_acquire))
+	{
+		BuildSamples();
+	}
+
+	// Small batches are not worth a task
+	const int  times_per_block = 64;
+	const int  num_block = (num_times + times_per_block - 1) / times_per_block;
+	FBVHCore::ParallelFor(num_block, [&](int block)
+	{
+		const int  first_time = block * times_per_block;
+		const int  last_time = (first_time + times_per_block < num_times) ? first_time + times_per_block : num_times;
+		for (int t = first_time; t < last_time; t++)
+		{
+			SampleFrame(times[t], sample_joints, num_sample_joints, &out_transforms[(size_t)t * num_sample_joints]);
+		}
+	}, num_block < 2);
+}
+
+void  FBVHFile::SampleFrame(double time, const int* sample_joints, int num_sample_joints, FBVHTransform* out_transforms) const
+{
+	const int  num_joint = hierarchy->joints.size();
+
+	double  position = (interval > 0.0) ? time / interval : 0.0;
+	if (position < 0.0)
+	{
+		position = 0.0;
+	}
+	else if (position > num_frame - 1)
+	{
+		position = num_frame - 1;
+	}
+	const int     frame = (int)position;
+	const int     next_frame = (frame + 1 < num_frame) ? frame + 1 : frame;
+	const double  alpha = position - frame;
+
+	const FBVHVector*  positions = &sample_positions[(size_t)frame * num_joint];
+	const FBVHVector*  next_positions = &sample_positions[(size_t)next_frame * num_joint];
+	const FBVHQuat*    rotations = &sample_rotations[(size_t)frame * num_joint];
+	const FBVHQuat*    next_rotations = &sample_rotations[(size_t)next_frame * num_joint];
+
+	for (int i = 0; i < num_sample_joints; i++)
+	{
+		const int  j = (sample_joints != NULL) ? sample_joints[i] : i;
+		if (alpha <= 0.0)
+		{
+			out_transforms[i] = FBVHTransform(rotations[j], positions[j]);
+		}
+		else
+		{
+			// Slerp takes the shortest arc whatever the signs of the two quaternions
+			out_transforms[i] = FBVHTransform(FBVHQuat::Slerp(rotations[j], next_rotations[j], alpha), FBVHVector::Lerp(positions[j], next_positions[j], alpha));
+		}
+	}
+}
+
+void  FBVHFile::TransformToChannels(int n_joint, const FBVHTransform& transform, double* frame) const
+{
+	const Joint* j = hierarchy->joints[n_joint];
+	const FBVHVector Offset = transform.GetTranslation();
+
+	// GetTransform() builds Rz * Ry * Rx, the angles are read back from the rotated axes
+	const FBVHQuat Rotation = transform.GetRotation();
+	const FBVHVector AxisX = Rotation.RotateVector(FBVHVector(1.0, 0.0, 0.0));
+	const FBVHVector AxisY = Rotation.RotateVector(FBVHVector(0.0, 1.0, 0.0));
+	const FBVHVector AxisZ = Rotation.RotateVector(FBVHVector(0.0, 0.0, 1.0));
+
+	// atan2 keeps Y accurate near +-90 degrees, where asin of the sine loses half of the digits
+	const double SinY = -AxisX.Z;
+	const double CosY = std::sqrt(AxisX.X * AxisX.X + AxisX.Y * AxisX.Y);
+	double RadX = 0.0;
+	double RadY = std::atan2(SinY, CosY);
+	double RadZ = 0.0;
+	if (CosY > 1e-12)
+	{
+		RadX = std::atan2(AxisY.Z, AxisZ.Z);
+		RadZ = std::atan2(AxisX.Y, AxisX.X);
+	}
+	else
+	{
+		// Gimbal lock, X and Z turn about the same axis and Z takes all of it
+		RadZ = std::atan2(-AxisY.X, AxisY.Y);
+	}
+
+	for (int i = 0; i < j->channels.size(); ++i)
+	{
+		Channel* c = j->channels[i];
+		switch (c->type)
+		{
+		case ChannelEnum::X_POSITION:
+			frame[c->index] = Offset.X;  break;
+		case ChannelEnum::Y_POSITION:
+			frame[c->index] = -Offset.Y;  break;
+		case ChannelEnum::Z_POSITION:
+			frame[c->index] = Offset.Z;  break;
+		case ChannelEnum::Z_ROTATION:
+			frame[c->index] = -RadZ * radians_to_degrees;  break;
+		case ChannelEnum::Y_ROTATION:
+			frame[c->index] = RadY * radians_to_degrees;  break;
+		case ChannelEnum::X_ROTATION:
+			frame[c->index] = -RadX * radians_to_degrees;  break;
+		}
+	}
+}
+
+
+bool  FBVHFile::Save(int precision)
+{
+	FBVHOutputFile  file;
+
+	// Compressed when the name ends with .gz, frames are deflated as they are written
+	if (!file.Open(bvh_file_name.c_str()))
+	{
+		return  false;
+	}
+
+	bool  is_success = Save(file, precision);
+	return  file.Close() && is_success;
+}
+
+
+bool  FBVHFile::Save(FBVHOutputFile& file, int precision)
+{
+	BVH_TRACE_SCOPE(BVHFile_Save);
+
+	// Frames are formatted in blocks, a wave of blocks is formatted in parallel and written in order
+	const int  frames_per_block = 256;
+	const int  blocks_per_wave = 64;
+
+	std::vector< int >   channel_order;
+	FBVHTextBuffer       header;
+	bool                 is_success = true;
+
+	FormatHierarchy(header, channel_order, precision);
+
+	header.Append("MOTION\n");
+	header.Append("Frames: ");
+	header.AppendInt(num_frame);
+	header.Append('\n');
+	header.Append("Frame Time: ");
+	header.AppendFixed(interval, precision);
+	header.Append('\n');
+	is_success = file.Write(header.GetData(), header.GetSize());
+
+	const int  num_block = (num_frame + frames_per_block - 1) / frames_per_block;
+	std::vector< FBVHTextBuffer >  blocks(num_block < blocks_per_wave ? num_block : blocks_per_wave);
+
+	for (int wave_start = 0; wave_start < num_block && is_success; wave_start += blocks_per_wave)
+	{
+		const int  wave_size = (num_block - wave_start < blocks_per_wave) ? num_block - wave_start : blocks_per_wave;
+
+		FBVHCore::ParallelFor(wave_size, [&](int wave_index)
+		{
+			FBVHTextBuffer&  block = blocks[wave_index];
+			const int  first_frame = (wave_start + wave_index) * frames_per_block;
+			const int  last_frame = (first_frame + frames_per_block < num_frame) ? first_frame + frames_per_block : num_frame;
+
+			block.Clear();
+			FormatFrames(block, first_frame, last_frame, channel_order, precision);
+		});
+
+		for (int i = 0; i < wave_size && is_success; i++)
+		{
+			is_success = file.Write(blocks[i].GetData(), blocks[i].GetSize());
+		}
+	}
+	return  is_success;
+}
+
+
+void  FBVHFile::FormatHierarchy(FBVHTextBuffer& text, std::vector< int >& channel_order, int precision)
+{
+	text.Append("HIERARCHY\n");
+	OutputHierarchy(text, hierarchy->joints[0], 0, channel_order, precision);
+}
+
+
+void  FBVHFile::FormatFrames(FBVHTextBuffer& text, int first_frame, int last_frame, const std::vector< int >& channel_order, int precision) const
+{
+	for (int i = first_frame; i < last_frame; i++)
+	{
+		FormatFrame(text, &motion[i * num_channel], channel_order, precision);
+	}
+}
+
+
+void  FBVHFile::FormatFrame(FBVHTextBuffer& text, const double* frame, const std::vector< int >& channel_order, int precision)
+{
+	int  j;
+	const int  num_value = channel_order.size();
+
+	for (j = 0; j < num_value; j++)
+	{
+		text.AppendFixed(frame[channel_order[j]], precision);
+		if (j != num_value - 1)
+		{
+			text.Append("  ", 2);
+		}
+		else
+		{
+			text.Append('\n');
+		}
+	}
+}
+
+
+void  FBVHFile::OutputHierarchy(FBVHTextBuffer& text, const Joint* joint, int indent_level, std::vector< int >& channel_list, int precision)
+{
+	int  i;
+	Channel* channel;
+	const char  space[] = "  ";
+
+	text.AppendSpaces(indent_level * 4);
+	text.Append(joint->parent ? "JOINT" : "ROOT");
+	text.Append(space, 2);
+	text.Append(joint->name.c_str(), joint->name.size());
+	text.Append('\n');
+
+	text.AppendSpaces(indent_level * 4);
+	text.Append("{\n");
+	indent_level++;
+
+	text.AppendSpaces(indent_level * 4);
+	text.Append("OFFSET");
+	text.Append(space, 2);
+	text.AppendFixed(joint->offset[0], precision);
+	text.Append(space, 2);
+	text.AppendFixed(joint->offset[1], precision);
+	text.Append(space, 2);
+	text.AppendFixed(joint->offset[2], precision);
+	text.Append('\n');
+
+	text.AppendSpaces(indent_level * 4);
+	text.Append("CHANNELS");
+	text.Append(space, 2);
+	text.AppendInt(joint->channels.size());
+	text.Append(space, 2);
+	for (i = 0; i < joint->channels.size(); i++)
+	{
+		channel = joint->channels[i];
+		switch (channel->type)
+		{
+		case X_ROTATION:
+			text.Append("Xrotation");  break;
+		case Y_ROTATION:
+			text.Append("Yrotation");  break;
+		case Z_ROTATION:
+			text.Append("Zrotation");  break;
+		case X_POSITION:
+			text.Append("Xposition");  break;
+		case Y_POSITION:
+			text.Append("Yposition");  break;
+		case Z_POSITION:
+			text.Append("Zposition");  break;
+		}
+		if (i != joint->channels.size() - 1)
+		{
+			text.Append(space, 2);
+		}
+		else
+		{
+			text.Append('\n');
+		}
+
+		channel_list.push_back(channel->index);
+	}
+
+	if (joint->has_site)
+	{
+		text.AppendSpaces(indent_level * 4);
+		text.Append("End Site\n");
+		text.AppendSpaces(indent_level * 4);
+		text.Append("{\n");
+
+		text.AppendSpaces((indent_level + 1) * 4);
+		text.Append("OFFSET");
+		text.Append(space, 2);
+		text.AppendFixed(joint->site[0], precision);
+		text.Append(space, 2);
+		text.AppendFixed(joint->site[1], precision);
+		text.Append(space, 2);
+		text.AppendFixed(joint->site[2], precision);
+		text.Append('\n');
+
+		text.AppendSpaces(indent_level * 4);
+		text.Append("}\n");
+	}
+
+	for (i = 0; i < joint->children.size(); i++)
+	{
+		OutputHierarchy(text, joint->children[i], indent_level, channel_list, precision);
+	}
+
+	indent_level--;
+	text.AppendSpaces(indent_level * 4);
+	text.Append("}\n");
+}
+// End of FBVHFile.cpp
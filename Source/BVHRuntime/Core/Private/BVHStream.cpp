@@ -0,0 +1,374 @@
+#include "BVHStream.h"
+
+#ifdef  _MSC_VER
+#pragma warning( disable : 4996)
+#endif
+
+#include <cstring>
+
+// Engine builds take zlib from the engine third party libraries, native builds from the system
+#ifdef  THIRD_PARTY_INCLUDES_START
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+#else
+#include <zlib.h>
+#endif
+
+#define  BVH_STREAM_BLOCK_SIZE       (1024*1024)
+#define  BVH_STREAM_COMPRESSED_SIZE  (256*1024)
+
+
+FBVHLineReader::FBVHLineReader()
+{
+	file = NULL;
+	inflater = NULL;
+	block_pos = 0;
+	block_size = 0;
+	is_end_of_file = true;
+	is_member_end = false;
+	is_error = false;
+}
+
+FBVHLineReader::~FBVHLineReader()
+{
+	Close();
+}
+
+bool  FBVHLineReader::Open(const char* file_name)
+{
+	unsigned char  magic[2] = { 0, 0 };
+
+	Close();
+
+	file = fopen(file_name, "rb");
+	if (file == NULL)
+	{
+		return  false;
+	}
+
+	// gzip streams start with 0x1f 0x8b whatever the file is called
+	if (fread(magic, 1, 2, file) == 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+	{
+		z_stream*  stream = new z_stream();
+		memset(stream, 0, sizeof(z_stream));
+		if (inflateInit2(stream, 16 + MAX_WBITS) != Z_OK)
+		{
+			delete  stream;
+			Close();
+			return  false;
+		}
+		inflater = stream;
+		compressed.resize(BVH_STREAM_COMPRESSED_SIZE);
+	}
+	fseek(file, 0, SEEK_SET);
+
+	block.resize(BVH_STREAM_BLOCK_SIZE);
+	block_pos = 0;
+	block_size = 0;
+	is_end_of_file = false;
+	is_member_end = false;
+	is_error = false;
+	return  true;
+}
+
+bool  FBVHLineReader::Open(const char* text, size_t length)
+{
+	Close();
+
+	// The whole text is the only block
+	block.assign(text, text + length);
+	block_pos = 0;
+	block_size = length;
+	is_end_of_file = true;
+	return  true;
+}
+
+void  FBVHLineReader::Close()
+{
+	if (inflater != NULL)
+	{
+		inflateEnd((z_stream*)inflater);
+		delete  (z_stream*)inflater;
+		inflater = NULL;
+	}
+	if (file != NULL)
+	{
+		fclose(file);
+		file = NULL;
+	}
+	block_pos = 0;
+	block_size = 0;
+	line.clear();
+	is_end_of_file = true;
+	is_member_end = false;
+	is_error = false;
+}
+
+bool  FBVHLineReader::ReadBlock()
+{
+	// File reads and inflating, the I/O share of a parse
+	BVH_TRACE_SCOPE(BVHFile_ReadBlock);
+
+	block_pos = 0;
+	block_size = 0;
+
+	if (is_end_of_file)
+	{
+		return  false;
+	}
+
+	if (inflater == NULL)
+	{
+		block_size = fread(block.data(), 1, block.size(), file);
+		is_end_of_file = (block_size < block.size());
+		return  block_size > 0;
+	}
+
+	z_stream*  stream = (z_stream*)inflater;
+	stream->next_out = (Bytef*)block.data();
+	stream->avail_out = (uInt)block.size();
+
+	while (stream->avail_out > 0)
+	{
+		if (stream->avail_in == 0)
+		{
+			size_t  read_size = fread(compressed.data(), 1, compressed.size(), file);
+			if (read_size == 0)
+			{
+				// The file ends inside a member, before the check of its length and CRC
+				is_error = !is_member_end;
+				is_end_of_file = true;
+				break;
+			}
+			stream->next_in = (Bytef*)compressed.data();
+			stream->avail_in = (uInt)read_size;
+		}
+
+		int  result = inflate(stream, Z_NO_FLUSH);
+		if (result == Z_STREAM_END)
+		{
+			// Concatenated gzip members continue the same text
+			inflateReset(stream);
+			is_member_end = true;
+		}
+		else if (result == Z_OK)
+		{
+			is_member_end = false;
+		}
+		else if (result != Z_BUF_ERROR)
+		{
+			// Corrupt data, a wrong CRC or length included
+			is_error = true;
+			is_end_of_file = true;
+			break;
+		}
+	}
+
+	block_size = block.size() - stream->avail_out;
+	return  block_size > 0;
+}
+
+char*  FBVHLineReader::ReadLine()
+{
+	line.clear();
+
+	for (;;)
+	{
+		if (block_pos >= block_size && !ReadBlock())
+		{
+			// Last line without a line break
+			if (line.empty())
+			{
+				return  NULL;
+			}
+			break;
+		}
+
+		char*  first = block.data() + block_pos;
+		char*  end_of_line = (char*)memchr(first, '\n', block_size - block_pos);
+		if (end_of_line == NULL)
+		{
+			line.insert(line.end(), first, block.data() + block_size);
+			block_pos = block_size;
+			continue;
+		}
+
+		block_pos = (end_of_line - block.data()) + 1;
+
+		// Lines inside the block are handed out in place
+		if (line.empty())
+		{
+			if (end_of_line > first && end_of_line[-1] == '\r')
+			{
+				end_of_line--;
+			}
+			*end_of_line = '\0';
+			return  first;
+		}
+
+		line.insert(line.end(), first, end_of_line);
+		break;
+	}
+
+	if (!line.empty() && line.back() == '\r')
+	{
+		line.pop_back();
+	}
+	line.push_back('\0');
+	return  line.data();
+}
+
+
+FBVHOutputFile::FBVHOutputFile()
+{
+	file = NULL;
+	deflater = NULL;
+}
+
+FBVHOutputFile::~FBVHOutputFile()
+{
+	Close();
+}
+
+bool  FBVHOutputFile::IsCompressedName(const char* file_name)
+{
+	size_t  length = strlen(file_name);
+	return  (length > 3) && (strcmp(file_name + length - 3, ".gz") == 0);
+}
+
+bool  FBVHOutputFile::Open(const char* file_name)
+{
+	Close();
+
+	if (!IsCompressedName(file_name))
+	{
+		// Text mode, line breaks are the same as the previous std::ofstream writer
+		file = fopen(file_name, "w");
+		return  file != NULL;
+	}
+
+	file = fopen(file_name, "wb");
+	if (file == NULL)
+	{
+		return  false;
+	}
+
+	z_stream*  stream = new z_stream();
+	memset(stream, 0, sizeof(z_stream));
+	if (deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		delete  stream;
+		fclose(file);
+		file = NULL;
+		return  false;
+	}
+	deflater = stream;
+	compressed.resize(BVH_STREAM_COMPRESSED_SIZE);
+	return  true;
+}
+
+bool  FBVHOutputFile::Open(SinkFunction write_function)
+{
+	Close();
+
+	sink = write_function;
+	return  (bool)sink;
+}
+
+bool  FBVHOutputFile::Write(const char* data, size_t size)
+{
+	if (sink)
+	{
+		return  sink(data, size);
+	}
+	if (file == NULL)
+	{
+		return  false;
+	}
+
+	if (deflater == NULL)
+	{
+		return  fwrite(data, 1, size, file) == size;
+	}
+
+	z_stream*  stream = (z_stream*)deflater;
+	stream->next_in = (Bytef*)data;
+	stream->avail_in = (uInt)size;
+
+	while (stream->avail_in > 0)
+	{
+		stream->next_out = (Bytef*)compressed.data();
+		stream->avail_out = (uInt)compressed.size();
+		deflate(stream, Z_NO_FLUSH);
+
+		size_t  out_size = compressed.size() - stream->avail_out;
+		if (fwrite(compressed.data(), 1, out_size, file) != out_size)
+		{
+			return  false;
+		}
+	}
+	return  true;
+}
+
+long  FBVHOutputFile::Tell() const
+{
+	if (file == NULL || deflater != NULL)
+	{
+		return  -1;
+	}
+	return  ftell(file);
+}
+
+bool  FBVHOutputFile::Overwrite(long offset, const char* data, size_t size)
+{
+	if (file == NULL || deflater != NULL || offset < 0)
+	{
+		return  false;
+	}
+
+	long  end = ftell(file);
+	if (fseek(file, offset, SEEK_SET) != 0)
+	{
+		return  false;
+	}
+	bool  is_success = (fwrite(data, 1, size, file) == size);
+	return  (fseek(file, end, SEEK_SET) == 0) && is_success;
+}
+
+bool  FBVHOutputFile::Close()
+{
+	bool  is_success = true;
+
+	sink = nullptr;
+	if (deflater != NULL)
+	{
+		z_stream*  stream = (z_stream*)deflater;
+		int  result = Z_OK;
+		stream->next_in = NULL;
+		stream->avail_in = 0;
+		while (result == Z_OK)
+		{
+			stream->next_out = (Bytef*)compressed.data();
+			stream->avail_out = (uInt)compressed.size();
+			result = deflate(stream, Z_FINISH);
+
+			size_t  out_size = compressed.size() - stream->avail_out;
+			if (file != NULL && fwrite(compressed.data(), 1, out_size, file) != out_size)
+			{
+				is_success = false;
+				break;
+			}
+		}
+		deflateEnd(stream);
+		delete  stream;
+		deflater = NULL;
+	}
+
+	if (file != NULL)
+	{
+		is_success = (fclose(file) == 0) && is_success;
+		file = NULL;
+	}
+	return  is_success;
+}
@@ -0,0 +1,87 @@
+#include "BVHTextBuffer.h"
+
+#include <charconv>
+#include <cstring>
+
+
+FBVHTextBuffer::FBVHTextBuffer()
+{
+	size = 0;
+}
+
+void  FBVHTextBuffer::Reserve(size_t capacity)
+{
+	if (buffer.size() < capacity)
+	{
+		buffer.resize(capacity);
+	}
+}
+
+char*  FBVHTextBuffer::Grow(size_t length)
+{
+	if (size + length > buffer.size())
+	{
+		size_t  capacity = buffer.size() * 2;
+		if (capacity < size + length)
+		{
+			capacity = size + length;
+		}
+		if (capacity < 4096)
+		{
+			capacity = 4096;
+		}
+		buffer.resize(capacity);
+	}
+	return  buffer.data() + size;
+}
+
+void  FBVHTextBuffer::Append(const char* text, size_t length)
+{
+	memcpy(Grow(length), text, length);
+	size += length;
+}
+
+void  FBVHTextBuffer::Append(const char* text)
+{
+	Append(text, strlen(text));
+}
+
+void  FBVHTextBuffer::Append(char c)
+{
+	*Grow(1) = c;
+	size++;
+}
+
+void  FBVHTextBuffer::AppendSpaces(int count)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	memset(Grow(count), ' ', count);
+	size += count;
+}
+
+void  FBVHTextBuffer::AppendInt(long long value)
+{
+	// 20 digits and a sign
+	const size_t  max_length = 24;
+	char*  first = Grow(max_length);
+	std::to_chars_result  result = std::to_chars(first, first + max_length, value);
+	size += result.ptr - first;
+}
+
+void  FBVHTextBuffer::AppendFixed(double value, int precision)
+{
+	// Fixed notation of the largest doubles has 309 integer digits
+	const size_t  max_length = 320 + precision;
+	char*  first = Grow(max_length);
+	std::to_chars_result  result = std::to_chars(first, first + max_length, value, std::chars_format::fixed, precision);
+	size += result.ptr - first;
+
+	// std::ios::showpoint keeps the decimal point even without decimals
+	if (precision == 0)
+	{
+		Append('.');
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef  _BVH_CORE_H_
+#define  _BVH_CORE_H_
+
+#include <functional>
+
+//
+//  Parsing, storage, transforms and writing of BVH files, with no engine dependency.
+//  Compiled into the BVHRuntime module inside the engine, and as the BVHCore library by CMake.
+//
+
+// Exported from the engine module the core is compiled into, nothing to export in a native build
+#ifdef  BVHRUNTIME_API
+#define  BVHCORE_API  BVHRUNTIME_API
+#else
+#define  BVHCORE_API
+#endif
+
+// CPU event of a phase of the core in Unreal Insights, compiled out in a native build
+#ifndef  BVH_TRACE_SCOPE
+#ifdef  BVHRUNTIME_API
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#define  BVH_TRACE_SCOPE(name)  TRACE_CPUPROFILER_EVENT_SCOPE(name)
+#else
+#define  BVH_TRACE_SCOPE(name)
+#endif
+#endif
+
+class  BVHCORE_API FBVHCore
+{
+public:
+	typedef  void (*ParallelForFunction)(int num, const std::function< void(int) >& body, bool force_single_thread);
+
+	// Runs body(0) .. body(num - 1), in parallel unless force_single_thread is set.
+	// Uses the function installed by SetParallelFor(), or a pool of std::thread by default.
+	static void  ParallelFor(int num, const std::function< void(int) >& body, bool force_single_thread = false);
+
+	// Lets the host run the parallel loops of the core on its own task system, NULL restores the default
+	static void  SetParallelFor(ParallelForFunction function);
+};
+
+#endif // _BVH_CORE_H_
@@ -0,0 +1,210 @@
+#ifndef  _BVH_H_
+#define  _BVH_H_
+
+#include <vector>
+#include <map>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "BVHCore.h"
+#include "BVHMath.h"
+
+enum  ChannelEnum
+{
+	X_ROTATION, Y_ROTATION, Z_ROTATION,
+	X_POSITION, Y_POSITION, Z_POSITION
+};
+struct  Joint;
+class   FBVHTextBuffer;
+class   FBVHOutputFile;
+class   FBVHLineReader;
+
+struct  Channel
+{
+	Joint* joint;
+	ChannelEnum             type;
+	int                     index;
+};
+
+struct  Joint
+{
+	std::string              name;
+	int                      index;
+	Joint* parent;
+	std::vector< Joint* >    children;
+	double                   offset[3];
+	bool                     has_site;
+	double                   site[3];
+	std::vector< Channel* >  channels;
+};
+
+// Joints and channels of a HIERARCHY section, never modified once built so that files with the same hierarchy share one
+struct  BVHCORE_API FBVHHierarchy
+{
+	std::vector< Channel* >          channels;
+	std::vector< Joint* >            joints;
+	std::map< std::string, Joint* >  joint_index;
+	size_t                           hash;       // of the HIERARCHY text, 0 when not parsed from a file
+
+	FBVHHierarchy() : hash(0) {}
+	~FBVHHierarchy();
+
+	FBVHHierarchy(const FBVHHierarchy&) = delete;
+	FBVHHierarchy& operator=(const FBVHHierarchy&) = delete;
+};
+
+class  BVHCORE_API FBVHFile
+{
+private:
+	bool                             is_load_success;
+	std::string                      bvh_file_name;
+	std::string                      motion_name;
+	int                              num_channel;
+	std::shared_ptr< const FBVHHierarchy >  hierarchy;
+
+
+	int                      num_frame;
+	double                   interval;
+	double*                  motion;
+	size_t                   motion_capacity;  // in values, the buffer is kept by Clear() and reused by the next file
+
+	// Reader of Open(), ParseHeader() and OpenStreaming(), its blocks are kept between files
+	FBVHLineReader*          reader;
+
+	// Streaming read, the motion only holds a window of frames
+	FBVHLineReader*          stream_reader;
+	int                      window_capacity;
+	int                      window_first_frame;
+	int                      window_num_frame;
+
+	// Translation and rotation of every joint at every frame for Sample(), built on first use
+	mutable std::vector< FBVHVector >  sample_positions;
+	mutable std::vector< FBVHQuat >    sample_rotations;
+	mutable std::atomic< bool >     is_sample_ready;
+	mutable std::mutex              sample_mutex;
+
+
+public:
+	FBVHFile(const char* bvh_file_name);
+	~FBVHFile();
+
+	bool Open();
+	void Clear();
+
+	// Names the file read by the next Open() or OpenStreaming(). The motion buffer and the read blocks of the previous file
+	// are reused, a batch converting its files through one FBVHFile per thread allocates them only for its largest file.
+	void SetFileName(const char* file_name);
+
+	// Frees the motion buffer and the read blocks that Clear() keeps
+	void ReleaseMotion();
+
+	// Parses the HIERARCHY and the frame time from a text in memory, motion lines are not read
+	bool ParseHeader(const char* text, size_t length);
+
+	// Streaming read for files too large to hold: parses the header, then ReadWindow() decodes the frames window by window.
+	// GetNumFrame() is the frame count of the header, GetMotion() / GetTransform() / GetMotionFrame() index frames in the window.
+	bool OpenStreaming(int window_frames);
+
+	// Decodes the frames following the current window, returns their number, 0 at the end of the file or on a read error
+	int  ReadWindow();
+	void CloseStreaming();
+
+	bool IsStreaming() const { return  stream_reader != NULL; }
+	int  GetWindowFirstFrame() const { return  window_first_frame; }
+	int  GetWindowNumFrame() const { return  window_num_frame; }
+
+
+	void Init(const char* name,
+		int n_joi, const Joint** a_joi, int n_chan, const Channel** a_chan,
+		int n_frame, double interval, const double* mo);
+
+	void SetSkeleton(const char* name,
+		int n_joi, const Joint** a_joi, int n_chan, const Channel** a_chan);
+
+	void SetMotion(int n_frame, double interval, const double* mo = NULL);
+
+	// Writes the file back with numbers in fixed notation, formatting frame blocks in parallel
+	bool Save(int precision = 6);
+
+	// Same as Save(), writing to an already opened output
+	bool Save(FBVHOutputFile& file, int precision = 6);
+
+	// Local transform of a joint, engine axes: Y is flipped and the rotations are Rz * Ry * Rx
+	FBVHTransform GetTransform(int n_frame, int n_joint) const;
+
+	// Same as above for a frame of GetNumChannel() values held outside of the file
+	FBVHTransform GetTransform(const double* frame, int n_joint) const;
+
+	// Transforms at a time in seconds, translations and rotations interpolated between the two nearest frames.
+	// sample_joints lists the joints to sample, NULL for all of them; out_transforms receives one transform per sampled joint.
+	void  Sample(double time, const int* sample_joints, int num_sample_joints, FBVHTransform* out_transforms) const;
+
+	// Sample() at several times in one call, out_transforms receives num_times rows of num_sample_joints transforms
+	void  SampleMany(const double* times, int num_times, const int* sample_joints, int num_sample_joints, FBVHTransform* out_transforms) const;
+
+	// Drops the transforms built for Sample(), needed after the motion is changed through GetMotionFrame()
+	void  ResetSamples();
+
+	// Hierarchies of files read successfully are kept by their HIERARCHY text, the files of a batch recorded on the same rig
+	// share one and only the first one parses it. Bounded in count and text size, ClearHierarchyCache() releases them early.
+	static void  ClearHierarchyCache();
+	static int   GetHierarchyCacheHits();
+
+	// Inverse of GetTransform(), writes the channel values of a joint into a frame of GetNumChannel() values
+	void  TransformToChannels(int n_joint, const FBVHTransform& transform, double* frame) const;
+
+	// Appends the HIERARCHY section, channel_order receives the channel index of every written frame column
+	void  FormatHierarchy(FBVHTextBuffer& text, std::vector< int >& channel_order, int precision);
+
+	// Appends one line of frame values in the column order returned by FormatHierarchy()
+	static void  FormatFrame(FBVHTextBuffer& text, const double* frame, const std::vector< int >& channel_order, int precision);
+
+public:
+	bool  IsLoadSuccess() const { return is_load_success; }
+	const std::string& GetMotionName() const { return motion_name; }
+
+	const int       GetNumJoint() const { return  hierarchy->joints.size(); }
+	const Joint*    GetJoint(int no) const { return  hierarchy->joints[no]; }
+	const int       GetNumChannel() const { return  hierarchy->channels.size(); }
+	const Channel*  GetChannel(int no) const { return  hierarchy->channels[no]; }
+
+	const Joint* GetJoint(const std::string& j) const {
+		std::map< std::string, Joint* >::const_iterator  i = hierarchy->joint_index.find(j);
+		return  (i != hierarchy->joint_index.end()) ? (*i).second : NULL;
+	}
+
+	// Shared by the files with the same HIERARCHY text
+	const std::shared_ptr< const FBVHHierarchy >&  GetHierarchy() const { return  hierarchy; }
+
+	int     GetNumFrame() const { return  num_frame; }
+	double  GetInterval() const { return  interval; }
+	double  GetMotion(int f, int c) const { return  motion[f * num_channel + c]; }
+
+	void  SetMotion(int f, int c, double v) { motion[f * num_channel + c] = v; }
+
+	// The GetNumChannel() values of a frame, e.g. for TransformToChannels()
+	double*  GetMotionFrame(int f) { return  &motion[f * num_channel]; }
+	const double*  GetMotionFrame(int f) const { return  &motion[f * num_channel]; }
+
+	// Size of the motion buffer, at least the whole motion or one streaming window, more when kept from a larger file
+	size_t  GetMotionBytes() const { return  sizeof(double) * motion_capacity; }
+
+protected:
+	bool  Read(FBVHLineReader& file, bool is_header_only);
+	double*  ReserveMotion(size_t num_values);
+	FBVHLineReader&  GetReader();
+	// Reads the lines of file up to MOTION, then those of rest when given, e.g. the file a buffered text was cut from
+	static void  ParseHierarchy(FBVHLineReader& file, FBVHHierarchy& parsed, FBVHLineReader* rest = NULL);
+	bool  ParseFrame(char* line, double* frame) const;
+	void  SetMotionNameFromFile();
+	void  BuildSamples() const;
+	void  SampleFrame(double time, const int* sample_joints, int num_sample_joints, FBVHTransform* out_transforms) const;
+	void  OutputHierarchy(FBVHTextBuffer& text, const Joint* joint, int indent_level,
+		std::vector< int >& channel_list, int precision);
+	void  FormatFrames(FBVHTextBuffer& text, int first_frame, int last_frame,
+		const std::vector< int >& channel_order, int precision) const;
+};
+
+#endif // _BVH_H_
@@ -0,0 +1,105 @@
+#ifndef  _BVH_MATH_H_
+#define  _BVH_MATH_H_
+
+#include <cmath>
+
+//
+//  Minimal vector, quaternion and transform types of the core, in double precision.
+//  Same conventions as the engine types they are converted to: Hamilton product, q * p applies p first.
+//
+
+struct  FBVHVector
+{
+	double  X, Y, Z;
+
+	FBVHVector() : X(0.0), Y(0.0), Z(0.0) {}
+	FBVHVector(double x, double y, double z) : X(x), Y(y), Z(z) {}
+
+	static FBVHVector  Lerp(const FBVHVector& a, const FBVHVector& b, double alpha)
+	{
+		return  FBVHVector(a.X + (b.X - a.X) * alpha, a.Y + (b.Y - a.Y) * alpha, a.Z + (b.Z - a.Z) * alpha);
+	}
+};
+
+struct  FBVHQuat
+{
+	double  X, Y, Z, W;
+
+	FBVHQuat() : X(0.0), Y(0.0), Z(0.0), W(1.0) {}
+	FBVHQuat(double x, double y, double z, double w) : X(x), Y(y), Z(z), W(w) {}
+
+	// Rotation of angle radians about a unit axis
+	FBVHQuat(const FBVHVector& axis, double angle)
+	{
+		const double  s = std::sin(angle * 0.5);
+		X = axis.X * s;
+		Y = axis.Y * s;
+		Z = axis.Z * s;
+		W = std::cos(angle * 0.5);
+	}
+
+	FBVHQuat  operator*(const FBVHQuat& q) const
+	{
+		return  FBVHQuat(
+			W * q.X + X * q.W + Y * q.Z - Z * q.Y,
+			W * q.Y - X * q.Z + Y * q.W + Z * q.X,
+			W * q.Z + X * q.Y - Y * q.X + Z * q.W,
+			W * q.W - X * q.X - Y * q.Y - Z * q.Z);
+	}
+
+	// Unit quaternions only
+	FBVHVector  RotateVector(const FBVHVector& v) const
+	{
+		// v + 2w (q x v) + 2 q x (q x v)
+		const double  tx = 2.0 * (Y * v.Z - Z * v.Y);
+		const double  ty = 2.0 * (Z * v.X - X * v.Z);
+		const double  tz = 2.0 * (X * v.Y - Y * v.X);
+		return  FBVHVector(
+			v.X + W * tx + (Y * tz - Z * ty),
+			v.Y + W * ty + (Z * tx - X * tz),
+			v.Z + W * tz + (X * ty - Y * tx));
+	}
+
+	// Shortest arc interpolation, normalized
+	static FBVHQuat  Slerp(const FBVHQuat& a, const FBVHQuat& b, double alpha)
+	{
+		const double  raw_cos = a.X * b.X + a.Y * b.Y + a.Z * b.Z + a.W * b.W;
+		const double  cos_omega = (raw_cos >= 0.0) ? raw_cos : -raw_cos;
+
+		double  scale_a = 1.0 - alpha;
+		double  scale_b = alpha;
+		if (cos_omega < 0.9999)
+		{
+			const double  omega = std::acos(cos_omega);
+			const double  inv_sin = 1.0 / std::sin(omega);
+			scale_a = std::sin((1.0 - alpha) * omega) * inv_sin;
+			scale_b = std::sin(alpha * omega) * inv_sin;
+		}
+		if (raw_cos < 0.0)
+		{
+			scale_b = -scale_b;
+		}
+
+		FBVHQuat  r(scale_a * a.X + scale_b * b.X, scale_a * a.Y + scale_b * b.Y, scale_a * a.Z + scale_b * b.Z, scale_a * a.W + scale_b * b.W);
+		const double  length = std::sqrt(r.X * r.X + r.Y * r.Y + r.Z * r.Z + r.W * r.W);
+		if (length > 0.0)
+		{
+			r.X /= length;  r.Y /= length;  r.Z /= length;  r.W /= length;
+		}
+		return  r;
+	}
+};
+
+struct  FBVHTransform
+{
+	FBVHQuat    Rotation;
+	FBVHVector  Translation;
+
+	FBVHTransform() {}
+	FBVHTransform(const FBVHQuat& rotation, const FBVHVector& translation) : Rotation(rotation), Translation(translation) {}
+
+	const FBVHQuat&    GetRotation() const { return  Rotation; }
+	const FBVHVector&  GetTranslation() const { return  Translation; }
+};
+
+#endif // _BVH_MATH_H_
@@ -0,0 +1,87 @@
+#ifndef  _BVH_STREAM_H_
+#define  _BVH_STREAM_H_
+
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+#include "BVHCore.h"
+
+//
+//  Line reader feeding the BVH parser block by block.
+//  Plain and gzip compressed (.bvh.gz) files are both read directly, compressed input is
+//  detected from its magic bytes and inflated in blocks, so no temporary file is needed.
+//
+class  BVHCORE_API FBVHLineReader
+{
+private:
+	FILE*                file;
+	void*                inflater;         // z_stream, only for compressed input
+	std::vector< char >  compressed;       // input blocks of the inflater
+	std::vector< char >  block;            // text of the current block
+	size_t               block_pos;
+	size_t               block_size;
+	std::vector< char >  line;             // lines spanning two blocks
+	bool                 is_end_of_file;
+	bool                 is_member_end;    // the inflater finished a gzip member and may stop there
+	bool                 is_error;
+
+public:
+	FBVHLineReader();
+	~FBVHLineReader();
+
+	bool  Open(const char* file_name);
+	void  Close();
+
+	// Reads lines from a copy of a text in memory
+	bool  Open(const char* text, size_t length);
+
+	// Returns the next line without its line break, NULL at the end of the input.
+	// The text may be modified by the caller (strtok) and stays valid until the next call.
+	char*  ReadLine();
+
+	bool  IsCompressed() const { return  inflater != NULL; }
+
+	// Compressed input that is corrupt or cut short ends the lines early, and the lines already read may be wrong
+	bool  HasError() const { return  is_error; }
+
+private:
+	bool  ReadBlock();
+};
+
+//
+//  Output file for FBVHFile::Save(), deflating to gzip when the file name ends with ".gz".
+//  The output can also be a callback, e.g. to write into an engine archive.
+//
+class  BVHCORE_API FBVHOutputFile
+{
+public:
+	typedef  std::function< bool(const char* data, size_t size) >  SinkFunction;
+
+private:
+	FILE*                file;
+	void*                deflater;         // z_stream, only for compressed output
+	std::vector< char >  compressed;
+	SinkFunction         sink;
+
+public:
+	FBVHOutputFile();
+	~FBVHOutputFile();
+
+	bool  Open(const char* file_name);
+	bool  Open(SinkFunction write_function);
+	bool  Write(const char* data, size_t size);
+	bool  Close();
+
+	bool  IsOpen() const { return  file != NULL || sink; }
+	bool  IsCompressed() const { return  deflater != NULL; }
+
+	// Uncompressed output only: offset of the next write, and rewriting text that was already written
+	long  Tell() const;
+	bool  Overwrite(long offset, const char* data, size_t size);
+
+	static bool  IsCompressedName(const char* file_name);
+};
+
+#endif // _BVH_STREAM_H_
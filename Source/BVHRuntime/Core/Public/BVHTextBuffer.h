@@ -0,0 +1,44 @@
+#ifndef  _BVH_TEXT_BUFFER_H_
+#define  _BVH_TEXT_BUFFER_H_
+
+#include <vector>
+#include <cstddef>
+
+#include "BVHCore.h"
+
+//
+//  Growable output buffer used to build BVH text.
+//  Numbers are formatted with std::to_chars, which produces the same characters as
+//  an iostream in std::ios::fixed mode without going through locale and stream state.
+//
+class  BVHCORE_API FBVHTextBuffer
+{
+private:
+	std::vector< char >  buffer;
+	size_t               size;
+
+public:
+	FBVHTextBuffer();
+
+	void  Reserve(size_t capacity);
+	void  Clear() { size = 0; }
+
+	void  Append(const char* text, size_t length);
+	void  Append(const char* text);
+	void  Append(char c);
+	void  AppendSpaces(int count);
+
+	// Same output as `stream << value` for integers
+	void  AppendInt(long long value);
+
+	// Same output as `stream << value` with std::ios::fixed | std::ios::showpoint and the given precision
+	void  AppendFixed(double value, int precision);
+
+	const char*  GetData() const { return  buffer.data(); }
+	size_t       GetSize() const { return  size; }
+
+private:
+	char*  Grow(size_t length);
+};
+
+#endif // _BVH_TEXT_BUFFER_H_
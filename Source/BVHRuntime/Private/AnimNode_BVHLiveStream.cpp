@@ -0,0 +1,158 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimNode_BVHLiveStream.h"
+
+#include "Animation/AnimInstanceProxy.h"
+#include "HAL/PlatformTime.h"
+
+#include "BVHAnimConverter.h"
+#include "BVHCoreAdapter.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AnimNode_BVHLiveStream)
+
+void FAnimNode_BVHLiveStream::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_Base::Initialize_AnyThread(Context);
+	GetEvaluateGraphExposedInputs().Execute(Context);
+
+	Source = FBVHLiveSource::FindOrCreate(Protocol, Host, Port);
+	Stream.Reset();
+	StreamGeneration = 0;
+	bJointsMapped = false;
+}
+
+void FAnimNode_BVHLiveStream::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	bJointsMapped = false;
+}
+
+void FAnimNode_BVHLiveStream::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	GetEvaluateGraphExposedInputs().Execute(Context);
+
+	// A new hierarchy is the only time the node allocates
+	if (Source && Source->GetGeneration() != StreamGeneration)
+	{
+		StreamGeneration = Source->GetGeneration();
+		Stream = Source->GetStream();
+		bJointsMapped = false;
+		if (Stream)
+		{
+			FrameA.SetNumUninitialized(Stream->Frames.GetNumChannels());
+			FrameB.SetNumUninitialized(Stream->Frames.GetNumChannels());
+		}
+	}
+}
+
+void FAnimNode_BVHLiveStream::Evaluate_AnyThread(FPoseContext& Output)
+{
+	Output.ResetToRefPose();
+	if (!Stream)
+	{
+		return;
+	}
+
+	const FBoneContainer& RequiredBones = Output.Pose.GetBoneContainer();
+	if (!bJointsMapped || MappedBonesSerial != RequiredBones.GetSerialNumber())
+	{
+		MapJoints(RequiredBones);
+	}
+
+	float Alpha = 0.f;
+	if (!ReadFrames(FPlatformTime::Seconds(), Alpha))
+	{
+		return;
+	}
+
+	const FBVHFile& Hierarchy = *Stream->Hierarchy;
+	for (int32 JointIdx = 0; JointIdx < JointBones.Num(); ++JointIdx)
+	{
+		const FCompactPoseBoneIndex BoneIdx = JointBones[JointIdx];
+		if (!BoneIdx.IsValid())
+		{
+			continue;
+		}
+
+		if (Alpha > 0.f)
+		{
+			Output.Pose[BoneIdx].Blend(BVHCoreAdapter::GetTransform(Hierarchy, FrameA.GetData(), JointIdx), BVHCoreAdapter::GetTransform(Hierarchy, FrameB.GetData(), JointIdx), Alpha);
+		}
+		else
+		{
+			Output.Pose[BoneIdx] = BVHCoreAdapter::GetTransform(Hierarchy, FrameA.GetData(), JointIdx);
+		}
+	}
+}
+
+void FAnimNode_BVHLiveStream::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("(%s:%d, %s, Frames: %lld)"), *Host, Port,
+		(Source && Source->IsConnected()) ? TEXT("Connected") : TEXT("Waiting"),
+		Stream ? Stream->Frames.GetNumWritten() : (int64)0);
+	DebugData.AddDebugItem(DebugLine, true);
+}
+
+void FAnimNode_BVHLiveStream::MapJoints(const FBoneContainer& RequiredBones)
+{
+	TArray<FName> BoneNames;
+	FBVHAnimConverter::MapJointsToBones(*Stream->Hierarchy, RequiredBones.GetReferenceSkeleton(), BoneNames);
+
+	JointBones.Reset(BoneNames.Num());
+	for (const FName& BoneName : BoneNames)
+	{
+		const int32 MeshBoneIdx = (BoneName != NAME_None) ? RequiredBones.GetReferenceSkeleton().FindBoneIndex(BoneName) : INDEX_NONE;
+		JointBones.Add(MeshBoneIdx != INDEX_NONE ? RequiredBones.MakeCompactPoseIndex(FMeshPoseBoneIndex(MeshBoneIdx)) : FCompactPoseBoneIndex(INDEX_NONE));
+	}
+
+	MappedBonesSerial = RequiredBones.GetSerialNumber();
+	bJointsMapped = true;
+}
+
+bool FAnimNode_BVHLiveStream::ReadFrames(double Time, float& OutAlpha)
+{
+	const FBVHFrameRing& Frames = Stream->Frames;
+	const int64 Newest = Frames.GetNumWritten() - 1;
+	double TimeA = 0.0;
+	double TimeB = 0.0;
+
+	OutAlpha = 0.f;
+	if (Newest < 0)
+	{
+		return false;
+	}
+	if (Sampling == EBVHLiveSampling::Newest)
+	{
+		return Frames.Read(Newest, FrameA.GetData(), TimeA);
+	}
+
+	// Newest frame received before the sample time, blended towards the one after it
+	const double SampleTime = Time - InterpolationDelay * Stream->FrameTime;
+	const int64 Oldest = FMath::Max<int64>(Newest - Frames.GetCapacity() + 2, 0);
+	for (int64 FrameIdx = Newest; FrameIdx >= Oldest; --FrameIdx)
+	{
+		if (!Frames.ReadTime(FrameIdx, TimeA))
+		{
+			break;
+		}
+		if (TimeA > SampleTime)
+		{
+			continue;
+		}
+
+		if (FrameIdx == Newest)
+		{
+			// Nothing received after the sample time, hold the newest pose
+			return Frames.Read(FrameIdx, FrameA.GetData(), TimeA);
+		}
+		if (!Frames.Read(FrameIdx, FrameA.GetData(), TimeA) || !Frames.Read(FrameIdx + 1, FrameB.GetData(), TimeB))
+		{
+			return false;
+		}
+		OutAlpha = (TimeB > TimeA) ? (float)FMath::Clamp((SampleTime - TimeA) / (TimeB - TimeA), 0.0, 1.0) : 1.f;
+		return true;
+	}
+
+	// Sample time older than every frame kept
+	return Frames.Read(Oldest, FrameA.GetData(), TimeA);
+}
@@ -0,0 +1,135 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AnimNode_BVHMotionPlayer.h"
+
+#include "Animation/AnimInstanceProxy.h"
+
+#include "BVHAnimConverter.h"
+#include "BVHFile.h"
+#include "BVHMotionAsset.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AnimNode_BVHMotionPlayer)
+
+void FAnimNode_BVHMotionPlayer::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_Base::Initialize_AnyThread(Context);
+	GetEvaluateGraphExposedInputs().Execute(Context);
+
+	CurrentTime = StartPosition;
+	BvhFile.Reset();
+	bJointsMapped = false;
+	UpdateFile();
+}
+
+void FAnimNode_BVHMotionPlayer::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	bJointsMapped = false;
+}
+
+void FAnimNode_BVHMotionPlayer::UpdateFile()
+{
+	TSharedPtr<const FBVHFile> MotionFile;
+	if (Motion)
+	{
+		MotionFile = Motion->GetFile();
+	}
+	if (MotionFile != BvhFile)
+	{
+		BvhFile = MotionFile;
+		bJointsMapped = false;
+		if (BvhFile)
+		{
+			PoseCache.Reset(BvhFile->GetNumJoint(), CachedPoses);
+		}
+	}
+}
+
+void FAnimNode_BVHMotionPlayer::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	GetEvaluateGraphExposedInputs().Execute(Context);
+	UpdateFile();
+
+	if (!BvhFile)
+	{
+		return;
+	}
+
+	const float PlayLength = FMath::Max(BvhFile->GetNumFrame() - 1, 0) * BvhFile->GetInterval();
+	float Time = bUseExplicitTime ? ExplicitTime : CurrentTime + Context.GetDeltaTime() * PlayRate;
+	if (bLoop && PlayLength > 0.f)
+	{
+		Time = FMath::Fmod(Time, PlayLength);
+		if (Time < 0.f)
+		{
+			Time += PlayLength;
+		}
+	}
+	CurrentTime = FMath::Clamp(Time, 0.f, PlayLength);
+}
+
+void FAnimNode_BVHMotionPlayer::Evaluate_AnyThread(FPoseContext& Output)
+{
+	Output.ResetToRefPose();
+	if (!BvhFile || BvhFile->GetNumFrame() == 0 || BvhFile->GetInterval() <= 0.0)
+	{
+		return;
+	}
+
+	const FBoneContainer& RequiredBones = Output.Pose.GetBoneContainer();
+	if (!bJointsMapped || MappedBonesSerial != RequiredBones.GetSerialNumber())
+	{
+		MapJoints(RequiredBones);
+	}
+
+	// The two frames around the play time, both usually cached from the previous update
+	const double FramePosition = CurrentTime / BvhFile->GetInterval();
+	const int32 FrameA = FMath::Clamp((int32)FMath::FloorToDouble(FramePosition), 0, BvhFile->GetNumFrame() - 1);
+	const int32 FrameB = FMath::Min(FrameA + 1, BvhFile->GetNumFrame() - 1);
+	const float Alpha = (float)FMath::Clamp(FramePosition - FrameA, 0.0, 1.0);
+
+	const TArray<FTransform>& PoseA = PoseCache.GetPose(*BvhFile, FrameA, JointMask);
+	if (FrameB == FrameA || Alpha <= UE_KINDA_SMALL_NUMBER)
+	{
+		for (TConstSetBitIterator<> It(JointMask); It; ++It)
+		{
+			Output.Pose[JointBones[It.GetIndex()]] = PoseA[It.GetIndex()];
+		}
+		return;
+	}
+
+	// Both poses stay valid, the cache holds at least two entries
+	const TArray<FTransform>& PoseB = PoseCache.GetPose(*BvhFile, FrameB, JointMask);
+	for (TConstSetBitIterator<> It(JointMask); It; ++It)
+	{
+		Output.Pose[JointBones[It.GetIndex()]].Blend(PoseA[It.GetIndex()], PoseB[It.GetIndex()], Alpha);
+	}
+}
+
+void FAnimNode_BVHMotionPlayer::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+	DebugLine += FString::Printf(TEXT("('%s' Time: %.3f, Cache hits: %d, misses: %d)"), Motion ? *Motion->GetName() : TEXT("None"),
+		CurrentTime, PoseCache.GetNumHits(), PoseCache.GetNumMisses());
+	DebugData.AddDebugItem(DebugLine, true);
+}
+
+void FAnimNode_BVHMotionPlayer::MapJoints(const FBoneContainer& RequiredBones)
+{
+	TArray<FName> BoneNames;
+	FBVHAnimConverter::MapJointsToBones(*BvhFile, RequiredBones.GetReferenceSkeleton(), BoneNames);
+
+	JointBones.Reset(BoneNames.Num());
+	JointMask.Init(false, BoneNames.Num());
+	for (int32 JointIdx = 0; JointIdx < BoneNames.Num(); ++JointIdx)
+	{
+		const int32 MeshBoneIdx = (BoneNames[JointIdx] != NAME_None) ? RequiredBones.GetReferenceSkeleton().FindBoneIndex(BoneNames[JointIdx]) : INDEX_NONE;
+		const FCompactPoseBoneIndex BoneIdx = (MeshBoneIdx != INDEX_NONE) ? RequiredBones.MakeCompactPoseIndex(FMeshPoseBoneIndex(MeshBoneIdx)) : FCompactPoseBoneIndex(INDEX_NONE);
+		JointBones.Add(BoneIdx);
+		JointMask[JointIdx] = BoneIdx.IsValid();
+	}
+
+	// Cached poses may miss joints of the new mask
+	PoseCache.Reset(BvhFile->GetNumJoint(), CachedPoses);
+	MappedBonesSerial = RequiredBones.GetSerialNumber();
+	bJointsMapped = true;
+}
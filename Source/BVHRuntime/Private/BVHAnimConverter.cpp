@@ -0,0 +1,584 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHAnimConverter.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeExit.h"
+#include "ReferenceSkeleton.h"
+
+#include "BVHCoreAdapter.h"
+#include "BVHImportContext.h"
+#include "BVHStats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHAnimConverter, Verbose, All);
+
+namespace BVHAnimConverter
+{
+	/** Bone of every joint of a hierarchy shared by several files, for one skeleton */
+	struct FBoneMap
+	{
+		std::shared_ptr<const FBVHHierarchy> Hierarchy;
+		uint32 SkeletonHash = 0;
+		TArray<FName> BoneNames;
+	};
+
+	/** Bone maps kept, the oldest is dropped first */
+	static const int32 MaxBoneMaps = 64;
+
+	static FCriticalSection BoneMapLock;
+	static TArray<FBoneMap> BoneMaps;
+
+	static uint32 HashBoneNames(const FReferenceSkeleton& RefSkeleton)
+	{
+		uint32 Hash = 0;
+		for (const FMeshBoneInfo& BoneInfo : RefSkeleton.GetRefBoneInfo())
+		{
+			Hash = HashCombine(Hash, GetTypeHash(BoneInfo.Name));
+		}
+		return Hash;
+	}
+
+	/** Mirror bone of a bone, from the pairs of the settings or by swapping Left and Right in its name */
+	static FName GetMirrorBone(FName BoneName, const TMap<FName, FName>& MirrorBonePairs)
+	{
+		if (const FName* Pair = MirrorBonePairs.Find(BoneName))
+		{
+			return *Pair;
+		}
+		if (const FName* Pair = MirrorBonePairs.FindKey(BoneName))
+		{
+			return *Pair;
+		}
+
+		const FString Name = BoneName.ToString();
+		if (Name.Contains(TEXT("Left"), ESearchCase::CaseSensitive))
+		{
+			return FName(*Name.Replace(TEXT("Left"), TEXT("Right"), ESearchCase::CaseSensitive));
+		}
+		if (Name.Contains(TEXT("Right"), ESearchCase::CaseSensitive))
+		{
+			return FName(*Name.Replace(TEXT("Right"), TEXT("Left"), ESearchCase::CaseSensitive));
+		}
+		return BoneName;
+	}
+
+	/** Track TrackIdx of an animation being converted, its key arrays are emptied but keep their memory when they can hold NumKeys keys */
+	static FBVHConvertedTrack& RecycleTrack(TArray<FBVHConvertedTrack>& Tracks, int32 TrackIdx, FName BoneName, int32 NumKeys)
+	{
+		if (TrackIdx == Tracks.Num())
+		{
+			Tracks.AddDefaulted();
+		}
+
+		FBVHConvertedTrack& Track = Tracks[TrackIdx];
+		Track.BoneName = BoneName;
+		Track.RawTrack.PosKeys.Reset(NumKeys);
+		Track.RawTrack.RotKeys.Reset(NumKeys);
+		Track.RawTrack.ScaleKeys.Reset(NumKeys);
+		return Track;
+	}
+
+	/**
+	* Multiplies NumFloats floats by a sign pattern repeating every 12 floats, 3 position keys or 4 rotation keys.
+	* Three vector registers cover one period of the pattern, the tail is done one float at a time.
+	*/
+	static void MirrorKeys(const float* Source, float* Dest, int32 NumFloats, const float (&Signs)[12])
+	{
+		const VectorRegister4Float Signs0 = VectorLoad(&Signs[0]);
+		const VectorRegister4Float Signs1 = VectorLoad(&Signs[4]);
+		const VectorRegister4Float Signs2 = VectorLoad(&Signs[8]);
+
+		int32 Idx = 0;
+		for (; Idx + 12 <= NumFloats; Idx += 12)
+		{
+			VectorStore(VectorMultiply(VectorLoad(&Source[Idx]), Signs0), &Dest[Idx]);
+			VectorStore(VectorMultiply(VectorLoad(&Source[Idx + 4]), Signs1), &Dest[Idx + 4]);
+			VectorStore(VectorMultiply(VectorLoad(&Source[Idx + 8]), Signs2), &Dest[Idx + 8]);
+		}
+		for (; Idx < NumFloats; ++Idx)
+		{
+			Dest[Idx] = Source[Idx] * Signs[Idx % 12];
+		}
+	}
+}
+
+uint32 FBVHAnimConverter::HashJointTrack(const FBVHFile& BvhFile, int32 JointIdx, int32 FirstFrame, int32 LastFrame)
+{
+	const Joint* joint = BvhFile.GetJoint(JointIdx);
+	const int32 NumChannel = joint->channels.size();
+	const int32 NumFrame = LastFrame - FirstFrame + 1;
+
+	uint32 Hash = FCrc::MemCrc32(joint->offset, sizeof(joint->offset));
+	Hash = FCrc::MemCrc32(&NumFrame, sizeof(NumFrame), Hash);
+	for (const Channel* channel : joint->channels)
+	{
+		Hash = FCrc::MemCrc32(&channel->type, sizeof(channel->type), Hash);
+	}
+
+	// Channels of a joint are not contiguous across frames, gather them per frame
+	TArray<double, TInlineAllocator<8>> Values;
+	Values.SetNumUninitialized(NumChannel);
+	for (int32 FrameIdx = FirstFrame; FrameIdx <= LastFrame; ++FrameIdx)
+	{
+		for (int32 ChannelIdx = 0; ChannelIdx < NumChannel; ++ChannelIdx)
+		{
+			Values[ChannelIdx] = BvhFile.GetMotion(FrameIdx, joint->channels[ChannelIdx]->index);
+		}
+		Hash = FCrc::MemCrc32(Values.GetData(), NumChannel * sizeof(double), Hash);
+	}
+
+	return Hash;
+}
+
+void FBVHAnimConverter::MapJointsToBones(const FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, TArray<FName>& OutBoneNames)
+{
+	using namespace BVHAnimConverter;
+
+	// Files with the same hierarchy text share it, their joints were already resolved for this skeleton
+	const std::shared_ptr<const FBVHHierarchy>& Hierarchy = BvhFile.GetHierarchy();
+	const bool bIsShared = Hierarchy->hash != 0;
+	const uint32 SkeletonHash = bIsShared ? HashBoneNames(RefSkeleton) : 0;
+	if (bIsShared)
+	{
+		FScopeLock Lock(&BoneMapLock);
+		const FBoneMap* BoneMap = BoneMaps.FindByPredicate([&](const FBoneMap& Map)
+		{
+			return Map.Hierarchy == Hierarchy && Map.SkeletonHash == SkeletonHash;
+		});
+		if (BoneMap)
+		{
+			OutBoneNames = BoneMap->BoneNames;
+			return;
+		}
+	}
+
+	OutBoneNames.SetNum(BvhFile.GetNumJoint());
+	for (int32 j = 0; j < BvhFile.GetNumJoint(); ++j)
+	{
+		// see if it's found in Skeleton
+		const Joint* joint = BvhFile.GetJoint(j);
+		const FName BoneName(ANSI_TO_TCHAR(joint->name.c_str()));
+		OutBoneNames[joint->index] = (RefSkeleton.FindBoneIndex(BoneName) != INDEX_NONE) ? BoneName : NAME_None;
+	}
+
+	if (bIsShared)
+	{
+		FScopeLock Lock(&BoneMapLock);
+		if (BoneMaps.Num() >= MaxBoneMaps)
+		{
+			BoneMaps.RemoveAt(0);
+		}
+		BoneMaps.Add({ Hierarchy, SkeletonHash, OutBoneNames });
+	}
+}
+
+bool FBVHAnimConverter::Convert(const FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation, const TMap<FName, uint32>* UnchangedHashes)
+{
+	TArray<FName> BoneNames;
+	MapJointsToBones(BvhFile, RefSkeleton, BoneNames);
+	return ConvertMapped(BvhFile, BoneNames, Settings, OutAnimation, UnchangedHashes);
+}
+
+bool FBVHAnimConverter::ConvertMapped(const FBVHFile& BvhFile, const TArray<FName>& BoneNames, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation, const TMap<FName, uint32>* UnchangedHashes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BVHConvertTracks);
+	const double StartTime = FPlatformTime::Seconds();
+
+	OutAnimation.Settings = Settings;
+	OutAnimation.TrackHashes.Reset();
+	OutAnimation.bFromCache = false;
+
+	int32 FirstFrame = 0;
+	int32 LastFrame = 0;
+	Settings.GetFrameRange(BvhFile.GetNumFrame(), FirstFrame, LastFrame);
+	OutAnimation.NumKeys = FMath::Max(LastFrame - FirstFrame + 1, 0);
+
+	// Tracks of a previous conversion are rewritten in place
+	int32 NumTracks = 0;
+	for (int32 JointIdx = 0; JointIdx < BvhFile.GetNumJoint(); ++JointIdx)
+	{
+		const FName BoneName = BoneNames[JointIdx];
+		if (BoneName == NAME_None)
+		{
+			continue;
+		}
+
+		const uint32 TrackHash = HashJointTrack(BvhFile, JointIdx, FirstFrame, LastFrame);
+		OutAnimation.TrackHashes.Add(BoneName, TrackHash);
+
+		const uint32* PreviousHash = UnchangedHashes ? UnchangedHashes->Find(BoneName) : nullptr;
+		if (PreviousHash && *PreviousHash == TrackHash)
+		{
+			continue;
+		}
+
+		FRawAnimSequenceTrack& RawTrack = BVHAnimConverter::RecycleTrack(OutAnimation.Tracks, NumTracks, BoneName, OutAnimation.NumKeys).RawTrack;
+
+		bool bSuccess = true;
+		for (int32 FrameIdx = FirstFrame; FrameIdx <= LastFrame; ++FrameIdx)
+		{
+			FTransform LocalTransform = BVHCoreAdapter::GetTransform(BvhFile, FrameIdx, JointIdx);
+			if (LocalTransform.ContainsNaN())
+			{
+				bSuccess = false;
+				UE_LOG(LogBVHAnimConverter, Error, TEXT("Bvh contain NaN."));
+				break;
+			}
+
+			RawTrack.ScaleKeys.Add(FVector3f(LocalTransform.GetScale3D()));
+			RawTrack.PosKeys.Add(FVector3f(LocalTransform.GetTranslation()));
+			RawTrack.RotKeys.Add(FQuat4f(LocalTransform.GetRotation()));
+		}
+
+		if (bSuccess)
+		{
+			++NumTracks;
+		}
+	}
+	OutAnimation.Tracks.SetNum(NumTracks, false);
+
+	// Mirror bones need each other's keys, an incremental conversion does not have them all
+	if (Settings.bCreateMirrored && UnchangedHashes == nullptr)
+	{
+		MirrorTracks(OutAnimation);
+	}
+	else
+	{
+		OutAnimation.MirroredTracks.Reset();
+	}
+
+	OutAnimation.ConvertSeconds = FPlatformTime::Seconds() - StartTime;
+	return true;
+}
+
+bool FBVHAnimConverter::ConvertClips(const FBVHFile& BvhFile, const FString& SourceFilename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, const TArray<FBVHClipRange>& Clips, TArray<FBVHConvertedAnimation>& OutAnimations)
+{
+	// One mapping for all clips, they all read the same motion buffer
+	TArray<FName> BoneNames;
+	MapJointsToBones(BvhFile, RefSkeleton, BoneNames);
+
+	OutAnimations.SetNum(Clips.Num());
+
+	TArray<bool> Converted;
+	Converted.SetNumZeroed(Clips.Num());
+
+	// A streaming file holds no motion, each clip reads its frames from the source, one clip at a time to bound the memory
+	const bool bStreaming = BvhFile.IsStreaming();
+	ParallelFor(Clips.Num(), [&](int32 ClipIdx)
+	{
+		const FBVHClipRange& Clip = Clips[ClipIdx];
+
+		FBVHImportSnapshot ClipSettings = Settings;
+		ClipSettings.MotionName = Clip.Name.IsEmpty() ? FString::Printf(TEXT("%s_%d"), *Settings.MotionName, ClipIdx) : Clip.Name;
+		ClipSettings.FrameStart = Clip.FrameStart;
+		ClipSettings.FrameEnd = Clip.FrameEnd;
+
+		OutAnimations[ClipIdx].SourceFilename = SourceFilename;
+		OutAnimations[ClipIdx].bIsClip = true;
+		Converted[ClipIdx] = bStreaming
+			? ConvertStreaming(SourceFilename, RefSkeleton, ClipSettings, OutAnimations[ClipIdx])
+			: ConvertMapped(BvhFile, BoneNames, ClipSettings, OutAnimations[ClipIdx], nullptr);
+	}, bStreaming);
+
+	return !Converted.Contains(false);
+}
+
+void FBVHAnimConverter::RemoveUnchangedTracks(FBVHConvertedAnimation& Animation, const TMap<FName, uint32>& PreviousHashes)
+{
+	Animation.Tracks.RemoveAll([&Animation, &PreviousHashes](const FBVHConvertedTrack& Track)
+	{
+		const uint32* PreviousHash = PreviousHashes.Find(Track.BoneName);
+		return PreviousHash && *PreviousHash == Animation.TrackHashes.FindRef(Track.BoneName);
+	});
+}
+
+SIZE_T FBVHConvertedAnimation::GetTrackBytes() const
+{
+	SIZE_T Bytes = 0;
+	for (const TArray<FBVHConvertedTrack>* TrackList : { &Tracks, &MirroredTracks })
+	{
+		for (const FBVHConvertedTrack& Track : *TrackList)
+		{
+			Bytes += Track.RawTrack.PosKeys.GetAllocatedSize() + Track.RawTrack.RotKeys.GetAllocatedSize() + Track.RawTrack.ScaleKeys.GetAllocatedSize();
+		}
+	}
+	return Bytes;
+}
+
+const TCHAR* FBVHAnimConverter::MirroredSuffix = TEXT("_Mirrored");
+
+void FBVHAnimConverter::MirrorTracks(FBVHConvertedAnimation& Animation)
+{
+	static_assert(sizeof(FVector3f) == 3 * sizeof(float) && sizeof(FQuat4f) == 4 * sizeof(float), "Keys are mirrored as packed floats");
+	SCOPE_CYCLE_COUNTER(STAT_BVHMirrorTracks);
+
+	const FBVHImportSnapshot& Settings = Animation.Settings;
+	const int32 AxisIdx = (Settings.MirrorAxis == EAxis::Y) ? 1 : (Settings.MirrorAxis == EAxis::Z) ? 2 : 0;
+
+	// A reflection negates the axis component of positions, and the two other imaginary components of rotations
+	float PositionSigns[12];
+	float RotationSigns[12];
+	for (int32 Idx = 0; Idx < 12; ++Idx)
+	{
+		PositionSigns[Idx] = (Idx % 3 == AxisIdx) ? -1.f : 1.f;
+		RotationSigns[Idx] = (Idx % 4 == 3 || Idx % 4 == AxisIdx) ? 1.f : -1.f;
+	}
+
+	TMap<FName, int32> TrackIndices;
+	TrackIndices.Reserve(Animation.Tracks.Num());
+	for (int32 TrackIdx = 0; TrackIdx < Animation.Tracks.Num(); ++TrackIdx)
+	{
+		TrackIndices.Add(Animation.Tracks[TrackIdx].BoneName, TrackIdx);
+	}
+
+	Animation.MirroredTracks.SetNum(Animation.Tracks.Num());
+	ParallelFor(Animation.Tracks.Num(), [&](int32 TrackIdx)
+	{
+		// A bone whose mirror bone has no track mirrors its own keys
+		const FName BoneName = Animation.Tracks[TrackIdx].BoneName;
+		const int32* MirrorTrackIdx = TrackIndices.Find(BVHAnimConverter::GetMirrorBone(BoneName, Settings.MirrorBonePairs));
+		const FRawAnimSequenceTrack& Source = Animation.Tracks[MirrorTrackIdx ? *MirrorTrackIdx : TrackIdx].RawTrack;
+
+		FBVHConvertedTrack& Mirrored = Animation.MirroredTracks[TrackIdx];
+		Mirrored.BoneName = BoneName;
+		Mirrored.RawTrack.ScaleKeys = Source.ScaleKeys;
+		Mirrored.RawTrack.PosKeys.SetNumUninitialized(Source.PosKeys.Num());
+		Mirrored.RawTrack.RotKeys.SetNumUninitialized(Source.RotKeys.Num());
+		BVHAnimConverter::MirrorKeys((const float*)Source.PosKeys.GetData(), (float*)Mirrored.RawTrack.PosKeys.GetData(), Source.PosKeys.Num() * 3, PositionSigns);
+		BVHAnimConverter::MirrorKeys((const float*)Source.RotKeys.GetData(), (float*)Mirrored.RawTrack.RotKeys.GetData(), Source.RotKeys.Num() * 4, RotationSigns);
+	});
+}
+
+void FBVHAnimConverter::MakeMirroredAnimation(const FBVHConvertedAnimation& Animation, FBVHConvertedAnimation& OutMirrored)
+{
+	OutMirrored.Settings = Animation.Settings;
+	OutMirrored.Settings.MotionName += MirroredSuffix;
+	OutMirrored.SourceFilename = Animation.SourceFilename;
+	OutMirrored.SourceSize = Animation.SourceSize;
+	OutMirrored.Tracks = Animation.MirroredTracks;
+	OutMirrored.NumKeys = Animation.NumKeys;
+	OutMirrored.bIsClip = Animation.bIsClip;
+	OutMirrored.bIsMirrored = true;
+}
+
+bool FBVHAnimConverter::ConvertWindows(FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_BVHConvertTracks);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The reader and its window are released on every return, the file is reused by the next import
+	ON_SCOPE_EXIT
+	{
+		BvhFile.CloseStreaming();
+	};
+
+	OutAnimation.Settings = Settings;
+	OutAnimation.TrackHashes.Reset();
+	OutAnimation.bFromCache = false;
+
+	int32 FirstFrame = 0;
+	int32 LastFrame = 0;
+	Settings.GetFrameRange(BvhFile.GetNumFrame(), FirstFrame, LastFrame);
+	OutAnimation.NumKeys = FMath::Max(LastFrame - FirstFrame + 1, 0);
+
+	TArray<FName> BoneNames;
+	MapJointsToBones(BvhFile, RefSkeleton, BoneNames);
+
+	// Tracks are allocated at their final size up front, and running hashes replace HashJointTrack()
+	TArray<int32> TrackJoints;
+	TArray<uint32> Hashes;
+	for (int32 JointIdx = 0; JointIdx < BvhFile.GetNumJoint(); ++JointIdx)
+	{
+		if (BoneNames[JointIdx] == NAME_None)
+		{
+			continue;
+		}
+
+		BVHAnimConverter::RecycleTrack(OutAnimation.Tracks, TrackJoints.Num(), BoneNames[JointIdx], OutAnimation.NumKeys);
+		TrackJoints.Add(JointIdx);
+
+		const Joint* joint = BvhFile.GetJoint(JointIdx);
+		uint32 Hash = FCrc::MemCrc32(joint->offset, sizeof(joint->offset));
+		Hash = FCrc::MemCrc32(&OutAnimation.NumKeys, sizeof(OutAnimation.NumKeys), Hash);
+		for (const Channel* channel : joint->channels)
+		{
+			Hash = FCrc::MemCrc32(&channel->type, sizeof(channel->type), Hash);
+		}
+		Hashes.Add(Hash);
+	}
+	OutAnimation.Tracks.SetNum(TrackJoints.Num(), false);
+
+	// A track with a NaN key is dropped like in ConvertMapped(), the other tracks are still converted
+	TBitArray<> InvalidTracks(false, TrackJoints.Num());
+
+	TArray<double, TInlineAllocator<8>> Values;
+	int32 NumWindowFrames = 0;
+	while (BvhFile.GetWindowFirstFrame() + BvhFile.GetWindowNumFrame() <= LastFrame && (NumWindowFrames = BvhFile.ReadWindow()) > 0)
+	{
+		const int32 WindowFirstFrame = BvhFile.GetWindowFirstFrame();
+		const int32 First = FMath::Max(FirstFrame - WindowFirstFrame, 0);
+		const int32 Last = FMath::Min(LastFrame - WindowFirstFrame, NumWindowFrames - 1);
+
+		for (int32 TrackIdx = 0; TrackIdx < TrackJoints.Num(); ++TrackIdx)
+		{
+			const int32 JointIdx = TrackJoints[TrackIdx];
+			const Joint* joint = BvhFile.GetJoint(JointIdx);
+			FRawAnimSequenceTrack& RawTrack = OutAnimation.Tracks[TrackIdx].RawTrack;
+
+			Values.SetNumUninitialized(joint->channels.size(), false);
+			for (int32 FrameIdx = First; FrameIdx <= Last; ++FrameIdx)
+			{
+				for (int32 ChannelIdx = 0; ChannelIdx < Values.Num(); ++ChannelIdx)
+				{
+					Values[ChannelIdx] = BvhFile.GetMotion(FrameIdx, joint->channels[ChannelIdx]->index);
+				}
+				Hashes[TrackIdx] = FCrc::MemCrc32(Values.GetData(), Values.Num() * sizeof(double), Hashes[TrackIdx]);
+
+				if (InvalidTracks[TrackIdx])
+				{
+					continue;
+				}
+
+				const FTransform LocalTransform = BVHCoreAdapter::GetTransform(BvhFile, FrameIdx, JointIdx);
+				if (LocalTransform.ContainsNaN())
+				{
+					UE_LOG(LogBVHAnimConverter, Error, TEXT("Bvh contain NaN."));
+					InvalidTracks[TrackIdx] = true;
+					continue;
+				}
+
+				RawTrack.ScaleKeys.Add(FVector3f(LocalTransform.GetScale3D()));
+				RawTrack.PosKeys.Add(FVector3f(LocalTransform.GetTranslation()));
+				RawTrack.RotKeys.Add(FQuat4f(LocalTransform.GetRotation()));
+			}
+		}
+	}
+
+	// Frames past the converted range are never read
+	if (!BvhFile.IsLoadSuccess())
+	{
+		UE_LOG(LogBVHAnimConverter, Error, TEXT("Bvh ends before its last frame."));
+		return false;
+	}
+
+	int32 NumTracks = 0;
+	for (int32 TrackIdx = 0; TrackIdx < TrackJoints.Num(); ++TrackIdx)
+	{
+		OutAnimation.TrackHashes.Add(OutAnimation.Tracks[TrackIdx].BoneName, Hashes[TrackIdx]);
+		if (!InvalidTracks[TrackIdx])
+		{
+			if (NumTracks != TrackIdx)
+			{
+				Swap(OutAnimation.Tracks[NumTracks], OutAnimation.Tracks[TrackIdx]);
+			}
+			++NumTracks;
+		}
+	}
+	OutAnimation.Tracks.SetNum(NumTracks, false);
+
+	if (Settings.bCreateMirrored)
+	{
+		MirrorTracks(OutAnimation);
+	}
+	else
+	{
+		OutAnimation.MirroredTracks.Reset();
+	}
+
+	OutAnimation.ConvertSeconds = FPlatformTime::Seconds() - StartTime;
+	return true;
+}
+
+bool FBVHAnimConverter::ConvertStreaming(const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation)
+{
+	OutAnimation.SourceFilename = Filename;
+	OutAnimation.SourceSize = IFileManager::Get().FileSize(*Filename);
+
+	FBVHFile BvhFile(TCHAR_TO_ANSI(*Filename));
+	ON_SCOPE_EXIT
+	{
+		DEC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile.GetMotionBytes());
+	};
+
+	bool bOpened = false;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BVHOpenFile);
+		bOpened = BvhFile.OpenStreaming(StreamingWindowFrames);
+	}
+	INC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile.GetMotionBytes());
+	if (!bOpened)
+	{
+		UE_LOG(LogBVHAnimConverter, Error, TEXT("Failed to open %s."), *Filename);
+		return false;
+	}
+
+	return ConvertWindows(BvhFile, RefSkeleton, Settings, OutAnimation);
+}
+
+bool FBVHAnimConverter::ConvertFile(const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation)
+{
+	// The motion buffer lives as long as this context
+	FBVHImportContext Context;
+	return ConvertFile(Context, Filename, RefSkeleton, InSettings, OutAnimation);
+}
+
+bool FBVHAnimConverter::ConvertFile(FBVHImportContext& Context, const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation)
+{
+	OutAnimation.SourceFilename = Filename;
+	OutAnimation.SourceSize = IFileManager::Get().FileSize(*Filename);
+	OutAnimation.ParseSeconds = 0.0;
+	OutAnimation.ConvertSeconds = 0.0;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The open reuses the motion buffer of the previous file of the context, it only grows for a larger file
+	FBVHFile& BvhFile = Context.GetBvhFile();
+	BvhFile.SetFileName(TCHAR_TO_ANSI(*Filename));
+	DEC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile.GetMotionBytes());
+
+	if (InSettings.ShouldStream(OutAnimation.SourceSize))
+	{
+		// Only the header is parsed here, the frames are read while converting
+		bool bOpened = false;
+		{
+			SCOPE_CYCLE_COUNTER(STAT_BVHOpenFile);
+			bOpened = BvhFile.OpenStreaming(StreamingWindowFrames);
+		}
+		INC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile.GetMotionBytes());
+		if (!bOpened)
+		{
+			UE_LOG(LogBVHAnimConverter, Error, TEXT("Failed to open %s."), *Filename);
+			return false;
+		}
+
+		OutAnimation.ParseSeconds = FPlatformTime::Seconds() - StartTime;
+
+		FBVHImportSnapshot Settings = InSettings;
+		Settings.ApplyFile(BvhFile);
+		return ConvertWindows(BvhFile, RefSkeleton, Settings, OutAnimation);
+	}
+
+	bool bOpened = false;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_BVHOpenFile);
+		bOpened = BvhFile.Open();
+	}
+	INC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile.GetMotionBytes());
+	if (!bOpened)
+	{
+		UE_LOG(LogBVHAnimConverter, Error, TEXT("Failed to open %s."), *Filename);
+		return false;
+	}
+
+	OutAnimation.ParseSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FBVHImportSnapshot Settings = InSettings;
+	Settings.ApplyFile(BvhFile);
+
+	TArray<FName>& BoneNames = Context.GetBoneNames();
+	MapJointsToBones(BvhFile, RefSkeleton, BoneNames);
+	return ConvertMapped(BvhFile, BoneNames, Settings, OutAnimation);
+}
@@ -0,0 +1,211 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHAnimExporter.h"
+
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Async/ParallelFor.h"
+#include "ReferenceSkeleton.h"
+
+#if WITH_EDITOR
+#include "Animation/AnimData/AnimDataModel.h"
+#endif
+
+#include "BVHCoreAdapter.h"
+#include "BVHStream.h"
+
+void FBVHAnimExporter::BuildHierarchy(const FReferenceSkeleton& RefSkeleton, const FString& MotionName, FBVHFile& OutFile, const TBitArray<>* TranslatedBones)
+{
+	const int32 NumBones = RefSkeleton.GetNum();
+	const TArray<FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+
+	auto HasPosition = [TranslatedBones](int32 BoneIdx)
+	{
+		return BoneIdx == 0 || (TranslatedBones && TranslatedBones->IsValidIndex(BoneIdx) && (*TranslatedBones)[BoneIdx]);
+	};
+
+	int32 NumChannels = 0;
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		NumChannels += HasPosition(BoneIdx) ? 6 : 3;
+	}
+
+	std::vector<Joint> JointData(NumBones);
+	std::vector<Channel> ChannelData(NumChannels);
+	std::vector<const Joint*> JointPtrs(NumBones);
+	std::vector<const Channel*> ChannelPtrs(NumChannels);
+
+	static const ChannelEnum PositionChannels[] = { X_POSITION, Y_POSITION, Z_POSITION, Z_ROTATION, Y_ROTATION, X_ROTATION };
+	static const ChannelEnum RotationChannels[] = { Z_ROTATION, Y_ROTATION, X_ROTATION };
+
+	int32 ChannelIdx = 0;
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		Joint& BoneJoint = JointData[BoneIdx];
+		const int32 ParentIdx = RefSkeleton.GetParentIndex(BoneIdx);
+		const FVector Offset = RefPose[BoneIdx].GetTranslation();
+
+		// Same axes as FBVHFile::GetTransform(), Y is flipped
+		BoneJoint.name = TCHAR_TO_ANSI(*RefSkeleton.GetBoneName(BoneIdx).ToString());
+		BoneJoint.index = BoneIdx;
+		BoneJoint.parent = (ParentIdx != INDEX_NONE) ? &JointData[ParentIdx] : nullptr;
+		BoneJoint.offset[0] = Offset.X;
+		BoneJoint.offset[1] = -Offset.Y;
+		BoneJoint.offset[2] = Offset.Z;
+		BoneJoint.has_site = false;
+		BoneJoint.site[0] = BoneJoint.site[1] = BoneJoint.site[2] = 0.0;
+		if (BoneJoint.parent)
+		{
+			BoneJoint.parent->children.push_back(&BoneJoint);
+		}
+
+		const bool bHasPosition = HasPosition(BoneIdx);
+		const ChannelEnum* Types = bHasPosition ? PositionChannels : RotationChannels;
+		const int32 NumJointChannels = bHasPosition ? 6 : 3;
+		for (int32 Idx = 0; Idx < NumJointChannels; ++Idx, ++ChannelIdx)
+		{
+			Channel& JointChannel = ChannelData[ChannelIdx];
+			JointChannel.joint = &BoneJoint;
+			JointChannel.type = Types[Idx];
+			JointChannel.index = ChannelIdx;
+			BoneJoint.channels.push_back(&JointChannel);
+			ChannelPtrs[ChannelIdx] = &JointChannel;
+		}
+		JointPtrs[BoneIdx] = &BoneJoint;
+	}
+
+	OutFile.SetSkeleton(TCHAR_TO_ANSI(*MotionName), NumBones, JointPtrs.data(), NumChannels, ChannelPtrs.data());
+}
+
+#if WITH_EDITOR
+namespace BVHAnimExporter
+{
+	/** Frames sampled by one task */
+	static const int32 FramesPerBlock = 256;
+
+	/** Key of a raw track, tracks with a single key hold it for the whole sequence */
+	static FTransform GetKeyTransform(const FRawAnimSequenceTrack* Track, const FTransform& RefPose, int32 Key)
+	{
+		if (Track == nullptr)
+		{
+			return RefPose;
+		}
+
+		const FVector Translation = Track->PosKeys.Num() > 0 ? FVector(Track->PosKeys[FMath::Min(Key, Track->PosKeys.Num() - 1)]) : RefPose.GetTranslation();
+		const FQuat Rotation = Track->RotKeys.Num() > 0 ? FQuat(Track->RotKeys[FMath::Min(Key, Track->RotKeys.Num() - 1)]) : RefPose.GetRotation();
+		return FTransform(Rotation, Translation);
+	}
+
+	/** Raw track of every bone of the reference skeleton, null for bones the sequence does not animate */
+	static void GetBoneTracks(const UAnimSequence* Sequence, const FReferenceSkeleton& RefSkeleton, TArray<const FRawAnimSequenceTrack*>& OutTracks)
+	{
+		OutTracks.Init(nullptr, RefSkeleton.GetNum());
+		for (const FBoneAnimationTrack& Track : Sequence->GetDataModel()->GetBoneAnimationTracks())
+		{
+			const int32 BoneIdx = RefSkeleton.FindBoneIndex(Track.Name);
+			if (BoneIdx != INDEX_NONE)
+			{
+				OutTracks[BoneIdx] = &Track.InternalTrackData;
+			}
+		}
+	}
+}
+
+TBitArray<> FBVHAnimExporter::FindTranslatedBones(const UAnimSequence* Sequence, const FReferenceSkeleton& RefSkeleton)
+{
+	TArray<const FRawAnimSequenceTrack*> BoneTracks;
+	BVHAnimExporter::GetBoneTracks(Sequence, RefSkeleton, BoneTracks);
+
+	TBitArray<> TranslatedBones(false, RefSkeleton.GetNum());
+	for (int32 BoneIdx = 0; BoneIdx < BoneTracks.Num(); ++BoneIdx)
+	{
+		if (BoneTracks[BoneIdx] == nullptr)
+		{
+			continue;
+		}
+
+		const FVector3f RefTranslation(RefSkeleton.GetRefBonePose()[BoneIdx].GetTranslation());
+		for (const FVector3f& Key : BoneTracks[BoneIdx]->PosKeys)
+		{
+			if (!Key.Equals(RefTranslation, KINDA_SMALL_NUMBER))
+			{
+				TranslatedBones[BoneIdx] = true;
+				break;
+			}
+		}
+	}
+	return TranslatedBones;
+}
+
+bool FBVHAnimExporter::SampleSequence(const UAnimSequence* Sequence, const FReferenceSkeleton& RefSkeleton, FBVHFile& OutFile)
+{
+	const UAnimDataModel* DataModel = Sequence->GetDataModel();
+	const int32 NumKeys = DataModel->GetNumberOfKeys();
+	const int32 NumBones = RefSkeleton.GetNum();
+	if (NumKeys <= 0 || OutFile.GetNumJoint() != NumBones)
+	{
+		return false;
+	}
+
+	TArray<const FRawAnimSequenceTrack*> BoneTracks;
+	BVHAnimExporter::GetBoneTracks(Sequence, RefSkeleton, BoneTracks);
+	const TArray<FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+
+	OutFile.SetMotion(NumKeys, DataModel->GetFrameRate().AsInterval());
+
+	const int32 NumBlocks = FMath::DivideAndRoundUp(NumKeys, BVHAnimExporter::FramesPerBlock);
+	ParallelFor(NumBlocks, [&](int32 BlockIdx)
+	{
+		const int32 FirstFrame = BlockIdx * BVHAnimExporter::FramesPerBlock;
+		const int32 LastFrame = FMath::Min(FirstFrame + BVHAnimExporter::FramesPerBlock, NumKeys);
+
+		for (int32 Frame = FirstFrame; Frame < LastFrame; ++Frame)
+		{
+			double* Values = OutFile.GetMotionFrame(Frame);
+			for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+			{
+				BVHCoreAdapter::TransformToChannels(OutFile, BoneIdx, BVHAnimExporter::GetKeyTransform(BoneTracks[BoneIdx], RefPose[BoneIdx], Frame), Values);
+			}
+		}
+	});
+	return true;
+}
+
+bool FBVHAnimExporter::MakeFile(const UAnimSequence* Sequence, FBVHFile& OutFile)
+{
+	const USkeleton* Skeleton = Sequence ? Sequence->GetSkeleton() : nullptr;
+	if (Skeleton == nullptr)
+	{
+		return false;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+	const TBitArray<> TranslatedBones = FindTranslatedBones(Sequence, RefSkeleton);
+	BuildHierarchy(RefSkeleton, Sequence->GetName(), OutFile, &TranslatedBones);
+	return SampleSequence(Sequence, RefSkeleton, OutFile);
+}
+
+bool FBVHAnimExporter::ExportToFile(const UAnimSequence* Sequence, const FString& Filename, int32 Precision)
+{
+	FBVHFile BvhFile(TCHAR_TO_ANSI(*Filename));
+	return MakeFile(Sequence, BvhFile) && BvhFile.Save(Precision);
+}
+
+bool FBVHAnimExporter::ExportToArchive(const UAnimSequence* Sequence, FArchive& Ar, int32 Precision)
+{
+	FBVHFile BvhFile("");
+	if (!MakeFile(Sequence, BvhFile))
+	{
+		return false;
+	}
+
+	FBVHOutputFile Output;
+	Output.Open([&Ar](const char* Data, size_t Size)
+	{
+		Ar.Serialize(const_cast<char*>(Data), Size);
+		return !Ar.IsError();
+	});
+	const bool bSaved = BvhFile.Save(Output, Precision);
+	return Output.Close() && bSaved;
+}
+#endif // WITH_EDITOR
@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHConversionSettings.h"
+
+#include "BVHFile.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHConversionSettings)
+
+void FBVHImportSnapshot::ApplyFile(const FBVHFile& BvhFile)
+{
+	MotionName = FString(BvhFile.GetMotionName().c_str());
+	FrameNum = BvhFile.GetNumFrame();
+	FrameStart = 0;
+	FrameEnd = BvhFile.GetNumFrame() - 1;
+	TimeStep = BvhFile.GetInterval();
+	ResampleRate = 1 / TimeStep;
+}
+
+uint32 FBVHImportSnapshot::GetSamplingHash() const
+{
+	uint32 Hash = GetTypeHash(FrameNum);
+	Hash = HashCombine(Hash, GetTypeHash(FrameStart));
+	Hash = HashCombine(Hash, GetTypeHash(FrameEnd));
+	Hash = HashCombine(Hash, GetTypeHash(TimeStep));
+	Hash = HashCombine(Hash, GetTypeHash(ResampleRate));
+	return Hash;
+}
+
+void FBVHImportSnapshot::GetFrameRange(int32 NumFrames, int32& OutFirstFrame, int32& OutLastFrame) const
+{
+	OutFirstFrame = FMath::Clamp(FrameStart, 0, FMath::Max(NumFrames - 1, 0));
+	OutLastFrame = (FrameEnd < OutFirstFrame) ? NumFrames - 1 : FMath::Min(FrameEnd, NumFrames - 1);
+}
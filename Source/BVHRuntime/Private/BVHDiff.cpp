@@ -0,0 +1,359 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHDiff.h"
+
+#include "Async/ParallelFor.h"
+
+#include "BVHFile.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHDiff, Log, All);
+
+namespace BVHDiff
+{
+	static const TCHAR* ChannelTypeNames[] = { TEXT("Xrotation"), TEXT("Yrotation"), TEXT("Zrotation"), TEXT("Xposition"), TEXT("Yposition"), TEXT("Zposition") };
+
+	/** Running maximum of every channel over the frames of a block, frames and counts are kept as doubles so that they update in the same registers */
+	struct FBlockStats
+	{
+		TArray<double> MaxError;
+		TArray<double> WorstFrame;
+		TArray<double> NumOver;
+		TArray<double> NumNaN;
+	};
+
+	/** A NaN difference compares as an infinite error, so that it is over any tolerance and scores as the worst */
+	static const double NaNError = std::numeric_limits<double>::infinity();
+
+	static bool IsNear(const double* A, const double* B, double Tolerance)
+	{
+		return FMath::Abs(A[0] - B[0]) <= Tolerance && FMath::Abs(A[1] - B[1]) <= Tolerance && FMath::Abs(A[2] - B[2]) <= Tolerance;
+	}
+
+	static FString GetJointName(const Joint* BvhJoint)
+	{
+		return BvhJoint ? FString(BvhJoint->name.c_str()) : FString(TEXT("<none>"));
+	}
+
+	/**
+	* Compares one frame, RowA and RowB hold NumChannels values in the channel order of A.
+	* Four channels are compared per iteration, the stats of a channel only ever live in its own lane.
+	*/
+	static double CompareFrame(const double* RowA, const double* RowB, int32 NumChannels, double Frame, const double* Tolerance, const double* InvTolerance, FBlockStats& Stats)
+	{
+		double* MaxError = Stats.MaxError.GetData();
+		double* WorstFrame = Stats.WorstFrame.GetData();
+		double* NumOver = Stats.NumOver.GetData();
+		double* NumNaN = Stats.NumNaN.GetData();
+
+		const double Frames[4] = { Frame, Frame, Frame, Frame };
+		const double Ones[4] = { 1.0, 1.0, 1.0, 1.0 };
+		const double Zeros[4] = { 0.0, 0.0, 0.0, 0.0 };
+		const double Errors[4] = { NaNError, NaNError, NaNError, NaNError };
+		const VectorRegister4Double FrameVec = VectorLoad(Frames);
+		const VectorRegister4Double OneVec = VectorLoad(Ones);
+		const VectorRegister4Double NaNErrorVec = VectorLoad(Errors);
+		VectorRegister4Double ScoreVec = VectorLoad(Zeros);
+
+		int32 Channel = 0;
+		for (; Channel + 4 <= NumChannels; Channel += 4)
+		{
+			// Every ordered compare is false on a NaN lane, it is selected out before the compares below
+			const VectorRegister4Double RawDiff = VectorAbs(VectorSubtract(VectorLoad(RowA + Channel), VectorLoad(RowB + Channel)));
+			const VectorRegister4Double IsNaN = VectorCompareNE(RawDiff, RawDiff);
+			const VectorRegister4Double Diff = VectorSelect(IsNaN, NaNErrorVec, RawDiff);
+			VectorStore(VectorAdd(VectorLoad(NumNaN + Channel), VectorBitwiseAnd(IsNaN, OneVec)), NumNaN + Channel);
+
+			const VectorRegister4Double Max = VectorLoad(MaxError + Channel);
+			const VectorRegister4Double NewMax = VectorCompareGT(Diff, Max);
+			VectorStore(VectorSelect(NewMax, Diff, Max), MaxError + Channel);
+			VectorStore(VectorSelect(NewMax, FrameVec, VectorLoad(WorstFrame + Channel)), WorstFrame + Channel);
+
+			const VectorRegister4Double Over = VectorCompareGT(Diff, VectorLoad(Tolerance + Channel));
+			VectorStore(VectorAdd(VectorLoad(NumOver + Channel), VectorBitwiseAnd(Over, OneVec)), NumOver + Channel);
+
+			ScoreVec = VectorMax(ScoreVec, VectorMultiply(Diff, VectorLoad(InvTolerance + Channel)));
+		}
+
+		double Scores[4];
+		VectorStore(ScoreVec, Scores);
+		double Score = FMath::Max(FMath::Max(Scores[0], Scores[1]), FMath::Max(Scores[2], Scores[3]));
+
+		for (; Channel < NumChannels; ++Channel)
+		{
+			double Diff = FMath::Abs(RowA[Channel] - RowB[Channel]);
+			if (FMath::IsNaN(Diff))
+			{
+				Diff = NaNError;
+				NumNaN[Channel] += 1.0;
+			}
+			if (Diff > MaxError[Channel])
+			{
+				MaxError[Channel] = Diff;
+				WorstFrame[Channel] = Frame;
+			}
+			NumOver[Channel] += Diff > Tolerance[Channel] ? 1.0 : 0.0;
+			Score = FMath::Max(Score, Diff * InvTolerance[Channel]);
+		}
+		return Score;
+	}
+}
+
+FString FBVHDiff::GetChannelName(const FBVHFile& File, int32 ChannelIdx)
+{
+	const Channel* BvhChannel = File.GetChannel(ChannelIdx);
+	return FString::Printf(TEXT("%s.%s"), *BVHDiff::GetJointName(BvhChannel->joint), BVHDiff::ChannelTypeNames[BvhChannel->type]);
+}
+
+void FBVHDiff::CompareHierarchies(const FBVHFile& A, const FBVHFile& B, const FBVHDiffSettings& Settings, TArray<int32>& OutChannelMap, FBVHDiffResult& OutResult)
+{
+	using namespace BVHDiff;
+
+	OutChannelMap.Init(INDEX_NONE, A.GetNumChannel());
+	TArray<FString>& Differences = OutResult.StructuralDifferences;
+
+	// Files sharing the parsed hierarchy have the same HIERARCHY text
+	if (A.GetHierarchy() == B.GetHierarchy())
+	{
+		for (int32 ChannelIdx = 0; ChannelIdx < A.GetNumChannel(); ++ChannelIdx)
+		{
+			OutChannelMap[ChannelIdx] = ChannelIdx;
+		}
+		return;
+	}
+
+	bool bJointOrderDiffers = false;
+	for (int32 JointIdx = 0; JointIdx < A.GetNumJoint(); ++JointIdx)
+	{
+		const Joint* JointA = A.GetJoint(JointIdx);
+		const Joint* JointB = B.GetJoint(JointA->name);
+		const FString Name = GetJointName(JointA);
+		if (JointB == nullptr)
+		{
+			Differences.Add(FString::Printf(TEXT("Joint %s is missing from B."), *Name));
+			continue;
+		}
+
+		bJointOrderDiffers |= JointA->index != JointB->index;
+		if ((JointA->parent ? JointA->parent->name : std::string()) != (JointB->parent ? JointB->parent->name : std::string()))
+		{
+			Differences.Add(FString::Printf(TEXT("Parent of %s: %s vs %s."), *Name, *GetJointName(JointA->parent), *GetJointName(JointB->parent)));
+		}
+		if (!IsNear(JointA->offset, JointB->offset, Settings.OffsetTolerance))
+		{
+			Differences.Add(FString::Printf(TEXT("Offset of %s: (%g %g %g) vs (%g %g %g)."), *Name,
+				JointA->offset[0], JointA->offset[1], JointA->offset[2], JointB->offset[0], JointB->offset[1], JointB->offset[2]));
+		}
+		if (JointA->has_site != JointB->has_site || (JointA->has_site && !IsNear(JointA->site, JointB->site, Settings.OffsetTolerance)))
+		{
+			Differences.Add(FString::Printf(TEXT("End site of %s differs."), *Name));
+		}
+
+		// Channels are matched by type, only their order within the joint can differ
+		bool bChannelOrderDiffers = JointA->channels.size() != JointB->channels.size();
+		for (int32 ChannelIdx = 0; ChannelIdx < (int32)JointA->channels.size(); ++ChannelIdx)
+		{
+			const Channel* ChannelA = JointA->channels[ChannelIdx];
+			for (int32 OtherIdx = 0; OtherIdx < (int32)JointB->channels.size(); ++OtherIdx)
+			{
+				if (JointB->channels[OtherIdx]->type == ChannelA->type)
+				{
+					OutChannelMap[ChannelA->index] = JointB->channels[OtherIdx]->index;
+					bChannelOrderDiffers |= OtherIdx != ChannelIdx;
+					break;
+				}
+			}
+			if (OutChannelMap[ChannelA->index] == INDEX_NONE)
+			{
+				Differences.Add(FString::Printf(TEXT("Channel %s is missing from B."), *GetChannelName(A, ChannelA->index)));
+			}
+		}
+		if (bChannelOrderDiffers)
+		{
+			Differences.Add(FString::Printf(TEXT("Channels of %s differ in number or order."), *Name));
+		}
+	}
+
+	for (int32 JointIdx = 0; JointIdx < B.GetNumJoint(); ++JointIdx)
+	{
+		if (A.GetJoint(B.GetJoint(JointIdx)->name) == nullptr)
+		{
+			Differences.Add(FString::Printf(TEXT("Joint %s is missing from A."), *GetJointName(B.GetJoint(JointIdx))));
+		}
+	}
+
+	if (bJointOrderDiffers)
+	{
+		Differences.Add(TEXT("Joints are in a different order."));
+	}
+}
+
+bool FBVHDiff::Compare(const FBVHFile& A, const FBVHFile& B, const FBVHDiffSettings& Settings, FBVHDiffResult& OutResult)
+{
+	using namespace BVHDiff;
+
+	const double StartTime = FPlatformTime::Seconds();
+	OutResult = FBVHDiffResult();
+
+	TArray<int32> ChannelMap;
+	CompareHierarchies(A, B, Settings, ChannelMap, OutResult);
+
+	if (A.GetNumFrame() != B.GetNumFrame())
+	{
+		OutResult.StructuralDifferences.Add(FString::Printf(TEXT("Frames: %d vs %d, the first %d are compared."), A.GetNumFrame(), B.GetNumFrame(), FMath::Min(A.GetNumFrame(), B.GetNumFrame())));
+	}
+	if (!FMath::IsNearlyEqual(A.GetInterval(), B.GetInterval(), 1e-9))
+	{
+		OutResult.StructuralDifferences.Add(FString::Printf(TEXT("Frame Time: %g vs %g."), A.GetInterval(), B.GetInterval()));
+	}
+
+	const int32 NumChannels = A.GetNumChannel();
+	const int32 NumFrames = FMath::Min(A.GetNumFrame(), B.GetNumFrame());
+	OutResult.NumChannelsCompared = NumChannels;
+	OutResult.NumFramesCompared = NumFrames;
+	if (NumChannels == 0 || NumFrames == 0)
+	{
+		return OutResult.IsEqual();
+	}
+
+	TArray<double> Tolerance;
+	TArray<double> InvTolerance;
+	Tolerance.SetNumUninitialized(NumChannels);
+	InvTolerance.SetNumUninitialized(NumChannels);
+	for (int32 ChannelIdx = 0; ChannelIdx < NumChannels; ++ChannelIdx)
+	{
+		const double* Override = Settings.ChannelTolerances.Find(GetChannelName(A, ChannelIdx));
+		Tolerance[ChannelIdx] = Override ? *Override : (A.GetChannel(ChannelIdx)->type >= X_POSITION ? Settings.PositionTolerance : Settings.RotationTolerance);
+		InvTolerance[ChannelIdx] = 1.0 / FMath::Max(Tolerance[ChannelIdx], UE_DOUBLE_SMALL_NUMBER);
+	}
+
+	// Rows of B are compared in place when its channels are in the order of A, otherwise gathered into that order first
+	bool bSameLayout = B.GetNumChannel() == NumChannels;
+	for (int32 ChannelIdx = 0; bSameLayout && ChannelIdx < NumChannels; ++ChannelIdx)
+	{
+		bSameLayout = ChannelMap[ChannelIdx] == ChannelIdx;
+	}
+
+	TArray<double> FrameScores;
+	FrameScores.SetNumUninitialized(NumFrames);
+
+	const int32 NumBlocks = FMath::DivideAndRoundUp(NumFrames, FramesPerBlock);
+	TArray<FBlockStats> BlockStats;
+	BlockStats.SetNum(NumBlocks);
+
+	ParallelFor(NumBlocks, [&](int32 BlockIdx)
+	{
+		FBlockStats& Stats = BlockStats[BlockIdx];
+		Stats.MaxError.SetNumZeroed(NumChannels);
+		Stats.WorstFrame.SetNumZeroed(NumChannels);
+		Stats.NumOver.SetNumZeroed(NumChannels);
+		Stats.NumNaN.SetNumZeroed(NumChannels);
+
+		TArray<double> GatheredRow;
+		if (!bSameLayout)
+		{
+			GatheredRow.SetNumUninitialized(NumChannels);
+		}
+
+		const int32 FirstFrame = BlockIdx * FramesPerBlock;
+		const int32 LastFrame = FMath::Min(FirstFrame + FramesPerBlock, NumFrames);
+		for (int32 Frame = FirstFrame; Frame < LastFrame; ++Frame)
+		{
+			const double* RowA = A.GetMotionFrame(Frame);
+			const double* RowB = B.GetMotionFrame(Frame);
+			if (!bSameLayout)
+			{
+				// A channel missing from B compares with itself, it is already reported as a structural difference
+				for (int32 ChannelIdx = 0; ChannelIdx < NumChannels; ++ChannelIdx)
+				{
+					GatheredRow[ChannelIdx] = ChannelMap[ChannelIdx] != INDEX_NONE ? RowB[ChannelMap[ChannelIdx]] : RowA[ChannelIdx];
+				}
+				RowB = GatheredRow.GetData();
+			}
+			FrameScores[Frame] = CompareFrame(RowA, RowB, NumChannels, (double)Frame, Tolerance.GetData(), InvTolerance.GetData(), Stats);
+		}
+	});
+
+	// Blocks are merged in frame order, so the earliest frame wins a tie
+	TArray<FBVHChannelDiff> Channels;
+	Channels.SetNum(NumChannels);
+	for (int32 ChannelIdx = 0; ChannelIdx < NumChannels; ++ChannelIdx)
+	{
+		FBVHChannelDiff& ChannelDiff = Channels[ChannelIdx];
+		ChannelDiff.Channel = ChannelIdx;
+		for (const FBlockStats& Stats : BlockStats)
+		{
+			if (Stats.MaxError[ChannelIdx] > ChannelDiff.MaxError || ChannelDiff.WorstFrame == INDEX_NONE)
+			{
+				ChannelDiff.MaxError = Stats.MaxError[ChannelIdx];
+				ChannelDiff.WorstFrame = (int32)Stats.WorstFrame[ChannelIdx];
+			}
+			ChannelDiff.NumFramesOver += (int32)Stats.NumOver[ChannelIdx];
+			ChannelDiff.NumFramesNaN += (int32)Stats.NumNaN[ChannelIdx];
+		}
+		ChannelDiff.Score = ChannelDiff.MaxError * InvTolerance[ChannelIdx];
+		OutResult.NumChannelsOver += ChannelDiff.NumFramesOver > 0 ? 1 : 0;
+		OutResult.NumChannelsNaN += ChannelDiff.NumFramesNaN > 0 ? 1 : 0;
+	}
+
+	const int32 NumWorst = FMath::Max(Settings.NumWorst, 0);
+	Channels.Sort([](const FBVHChannelDiff& Lhs, const FBVHChannelDiff& Rhs) { return Lhs.Score > Rhs.Score; });
+	for (int32 Idx = 0; Idx < FMath::Min(NumWorst, Channels.Num()) && Channels[Idx].NumFramesOver > 0; ++Idx)
+	{
+		Channels[Idx].Name = GetChannelName(A, Channels[Idx].Channel);
+		OutResult.WorstChannels.Add(Channels[Idx]);
+	}
+
+	TArray<int32> Frames;
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		if (FrameScores[Frame] > 1.0)
+		{
+			Frames.Add(Frame);
+		}
+	}
+	Frames.Sort([&FrameScores](int32 Lhs, int32 Rhs) { return FrameScores[Lhs] > FrameScores[Rhs]; });
+	for (int32 Idx = 0; Idx < FMath::Min(NumWorst, Frames.Num()); ++Idx)
+	{
+		FBVHFrameDiff& FrameDiff = OutResult.WorstFrames.AddDefaulted_GetRef();
+		FrameDiff.Frame = Frames[Idx];
+		FrameDiff.Score = FrameScores[FrameDiff.Frame];
+
+		// Only the reported frames are scanned again for the channel that scored
+		const double* RowA = A.GetMotionFrame(FrameDiff.Frame);
+		const double* RowB = B.GetMotionFrame(FrameDiff.Frame);
+		double BestScore = -1.0;
+		for (int32 ChannelIdx = 0; ChannelIdx < NumChannels; ++ChannelIdx)
+		{
+			const double ValueB = ChannelMap[ChannelIdx] != INDEX_NONE ? RowB[ChannelMap[ChannelIdx]] : RowA[ChannelIdx];
+			const double Error = FMath::Abs(RowA[ChannelIdx] - ValueB);
+			const double Score = (FMath::IsNaN(Error) ? NaNError : Error) * InvTolerance[ChannelIdx];
+			if (Score > BestScore)
+			{
+				BestScore = Score;
+				FrameDiff.WorstChannel = GetChannelName(A, ChannelIdx);
+			}
+		}
+	}
+
+	UE_LOG(LogBVHDiff, Verbose, TEXT("Compared %d frames of %d channels in %.2f ms"), NumFrames, NumChannels, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	return OutResult.IsEqual();
+}
+
+bool FBVHDiff::CompareFiles(const FString& FilenameA, const FString& FilenameB, const FBVHDiffSettings& Settings, FBVHDiffResult& OutResult)
+{
+	FBVHFile A(TCHAR_TO_ANSI(*FilenameA));
+	FBVHFile B(TCHAR_TO_ANSI(*FilenameB));
+	if (!A.Open())
+	{
+		UE_LOG(LogBVHDiff, Error, TEXT("Failed to open %s."), *FilenameA);
+		return false;
+	}
+	if (!B.Open())
+	{
+		UE_LOG(LogBVHDiff, Error, TEXT("Failed to open %s."), *FilenameB);
+		return false;
+	}
+
+	Compare(A, B, Settings, OutResult);
+	return true;
+}
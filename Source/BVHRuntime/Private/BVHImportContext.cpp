@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHImportContext.h"
+
+#include "Misc/ScopeLock.h"
+
+#include "BVHFile.h"
+#include "BVHStats.h"
+
+namespace BVHImportContext
+{
+	/** Contexts kept in the pool, more than the worker threads only happens when imports overlap */
+	static const int32 MaxPooledContexts = 32;
+
+	static FCriticalSection PoolLock;
+	static TArray<TUniquePtr<FBVHImportContext>> Pool;
+}
+
+FBVHImportContext::FBVHImportContext()
+	: BvhFile(MakeUnique<FBVHFile>(""))
+{
+}
+
+FBVHImportContext::~FBVHImportContext()
+{
+	DEC_MEMORY_STAT_BY(STAT_BVHMotionMemory, BvhFile->GetMotionBytes());
+}
+
+SIZE_T FBVHImportContext::GetMotionBytes() const
+{
+	return BvhFile->GetMotionBytes();
+}
+
+TUniquePtr<FBVHImportContext> FBVHImportContext::Acquire()
+{
+	{
+		FScopeLock Lock(&BVHImportContext::PoolLock);
+		if (BVHImportContext::Pool.Num() > 0)
+		{
+			return BVHImportContext::Pool.Pop(false);
+		}
+	}
+	return MakeUnique<FBVHImportContext>();
+}
+
+void FBVHImportContext::Release(TUniquePtr<FBVHImportContext> Context)
+{
+	if (!Context.IsValid())
+	{
+		return;
+	}
+
+	// The file is closed, the buffers it keeps are the scratch the next file reuses
+	Context->BvhFile->Clear();
+
+	FScopeLock Lock(&BVHImportContext::PoolLock);
+	if (BVHImportContext::Pool.Num() < BVHImportContext::MaxPooledContexts)
+	{
+		BVHImportContext::Pool.Add(MoveTemp(Context));
+	}
+}
+
+void FBVHImportContext::Trim()
+{
+	// Freed outside of the lock
+	TArray<TUniquePtr<FBVHImportContext>> Released;
+	{
+		FScopeLock Lock(&BVHImportContext::PoolLock);
+		Released = MoveTemp(BVHImportContext::Pool);
+	}
+}
@@ -0,0 +1,289 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHLiveSender.h"
+
+#include "Common/TcpSocketBuilder.h"
+#include "Common/UdpSocketBuilder.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+#include "BVHFile.h"
+#include "BVHTextBuffer.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHLiveSender, Log, All);
+
+namespace BVHLiveSender
+{
+	/** Decimals of the sent channel values */
+	static const int32 Precision = 6;
+
+	/** Largest datagram sent, UDP text is split on line breaks below this size */
+	static const int32 MaxDatagramSize = 8 * 1024;
+
+	/** Seconds between two headers over UDP, so receivers started late pick the stream up */
+	static const double HeaderInterval = 1.0;
+
+	static TUniquePtr<FBVHLiveSender> ConsoleSender;
+
+	static void SendCommand(const TArray<FString>& Args)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(LogBVHLiveSender, Display, TEXT("Usage: BVH.LiveSend <File> [Port] [Udp] [Host]"));
+			return;
+		}
+
+		const int32 Port = Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 7001;
+		const EBVHLiveProtocol Protocol = (Args.IsValidIndex(2) && Args[2].Equals(TEXT("Udp"), ESearchCase::IgnoreCase)) ? EBVHLiveProtocol::Udp : EBVHLiveProtocol::Tcp;
+		const FString Host = Args.IsValidIndex(3) ? Args[3] : TEXT("127.0.0.1");
+
+		ConsoleSender = MakeUnique<FBVHLiveSender>();
+		if (!ConsoleSender->StartSending(Args[0], Protocol, Port, Host))
+		{
+			ConsoleSender.Reset();
+		}
+	}
+
+	static FAutoConsoleCommand LiveSendCommand(
+		TEXT("BVH.LiveSend"),
+		TEXT("Plays a BVH file to a live stream in a loop: BVH.LiveSend <File> [Port] [Udp] [Host]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&SendCommand));
+
+	static FAutoConsoleCommand LiveStopCommand(
+		TEXT("BVH.LiveStop"),
+		TEXT("Stops the file played by BVH.LiveSend"),
+		FConsoleCommandDelegate::CreateStatic(&FBVHLiveSender::StopConsoleSender));
+}
+
+FBVHLiveSender::FBVHLiveSender()
+	: bStopRequested(false)
+{
+}
+
+FBVHLiveSender::~FBVHLiveSender()
+{
+	StopSending();
+}
+
+void FBVHLiveSender::StopConsoleSender()
+{
+	BVHLiveSender::ConsoleSender.Reset();
+}
+
+bool FBVHLiveSender::StartSending(const FString& Filename, EBVHLiveProtocol InProtocol, int32 InPort, const FString& InHost)
+{
+	StopSending();
+
+	BvhFile = MakeUnique<FBVHFile>(TCHAR_TO_ANSI(*Filename));
+	if (!BvhFile->Open() || BvhFile->GetNumFrame() == 0 || BvhFile->GetInterval() <= 0.0)
+	{
+		UE_LOG(LogBVHLiveSender, Error, TEXT("Failed to open %s."), *Filename);
+		BvhFile.Reset();
+		return false;
+	}
+
+	Protocol = InProtocol;
+	Port = InPort;
+	Host = InHost;
+
+	// A stream has no frame count, receivers only read the frame time
+	FBVHTextBuffer Text;
+	ChannelOrder.clear();
+	BvhFile->FormatHierarchy(Text, ChannelOrder, BVHLiveSender::Precision);
+	Text.Append("MOTION\n");
+	Text.Append("Frames: 0\n");
+	Text.Append("Frame Time: ");
+	Text.AppendFixed(BvhFile->GetInterval(), 6);
+	Text.Append('\n');
+	Header = TArray<char>(Text.GetData(), Text.GetSize());
+
+	if (!OpenSocket())
+	{
+		UE_LOG(LogBVHLiveSender, Error, TEXT("Failed to open a socket on port %d."), Port);
+		BvhFile.Reset();
+		return false;
+	}
+
+	bStopRequested = false;
+	Thread = FRunnableThread::Create(this, TEXT("BVHLiveSender"), 0, TPri_AboveNormal);
+	if (Thread == nullptr)
+	{
+		CloseSockets();
+		BvhFile.Reset();
+		return false;
+	}
+
+	UE_LOG(LogBVHLiveSender, Log, TEXT("Sending %s over %s on port %d"), *Filename, Protocol == EBVHLiveProtocol::Tcp ? TEXT("TCP") : TEXT("UDP"), Port);
+	return true;
+}
+
+void FBVHLiveSender::StopSending()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	CloseSockets();
+	BvhFile.Reset();
+}
+
+bool FBVHLiveSender::OpenSocket()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem == nullptr)
+	{
+		return false;
+	}
+
+	if (Protocol == EBVHLiveProtocol::Tcp)
+	{
+		Listener = FTcpSocketBuilder(TEXT("BVHLiveSender"))
+			.AsReusable()
+			.BoundToPort(Port)
+			.Listening(1)
+			.Build();
+		return Listener != nullptr;
+	}
+
+	FAddressInfoResult AddressInfo = SocketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None);
+	if (AddressInfo.ReturnCode != SE_NO_ERROR || AddressInfo.Results.Num() == 0)
+	{
+		return false;
+	}
+	Address = AddressInfo.Results[0].Address;
+	Address->SetPort(Port);
+
+	Socket = FUdpSocketBuilder(TEXT("BVHLiveSender"))
+		.WithSendBufferSize(1024 * 1024)
+		.Build();
+	return Socket != nullptr;
+}
+
+void FBVHLiveSender::CloseConnection()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+void FBVHLiveSender::CloseSockets()
+{
+	CloseConnection();
+	if (Listener)
+	{
+		Listener->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Listener);
+		Listener = nullptr;
+	}
+	Address.Reset();
+}
+
+uint32 FBVHLiveSender::Run()
+{
+	FBVHTextBuffer Line;
+	const double FrameTime = BvhFile->GetInterval();
+	const int32 NumFrames = BvhFile->GetNumFrame();
+
+	double StartTime = FPlatformTime::Seconds();
+	double HeaderTime = -BVHLiveSender::HeaderInterval;
+	int64 NumSent = 0;
+
+	while (!bStopRequested)
+	{
+		if (Protocol == EBVHLiveProtocol::Tcp && Socket == nullptr)
+		{
+			// One receiver at a time, each one gets the header first
+			bool bHasConnection = false;
+			if (!Listener->WaitForPendingConnection(bHasConnection, FTimespan::FromMilliseconds(100)) || !bHasConnection)
+			{
+				continue;
+			}
+			Socket = Listener->Accept(TEXT("BVHLiveReceiver"));
+			if (Socket == nullptr)
+			{
+				continue;
+			}
+			Socket->SetNoDelay(true);
+			if (!SendText(Header.GetData(), Header.Num()))
+			{
+				CloseConnection();
+				continue;
+			}
+			StartTime = FPlatformTime::Seconds();
+			NumSent = 0;
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		if (Protocol == EBVHLiveProtocol::Udp && Now - HeaderTime >= BVHLiveSender::HeaderInterval)
+		{
+			SendText(Header.GetData(), Header.Num());
+			HeaderTime = Now;
+		}
+
+		const double DueTime = StartTime + NumSent * FrameTime;
+		if (DueTime > Now)
+		{
+			FPlatformProcess::Sleep((float)FMath::Min(DueTime - Now, 0.01));
+			continue;
+		}
+
+		Line.Clear();
+		FBVHFile::FormatFrame(Line, BvhFile->GetMotionFrame((int32)(NumSent % NumFrames)), ChannelOrder, BVHLiveSender::Precision);
+		if (!SendText(Line.GetData(), Line.GetSize()) && Protocol == EBVHLiveProtocol::Tcp)
+		{
+			UE_LOG(LogBVHLiveSender, Log, TEXT("Receiver disconnected"));
+			CloseConnection();
+			continue;
+		}
+		++NumSent;
+	}
+	return 0;
+}
+
+void FBVHLiveSender::Stop()
+{
+	bStopRequested = true;
+}
+
+bool FBVHLiveSender::SendText(const char* Data, int32 Size)
+{
+	while (Size > 0)
+	{
+		int32 ChunkSize = Size;
+		if (Protocol == EBVHLiveProtocol::Udp && ChunkSize > BVHLiveSender::MaxDatagramSize)
+		{
+			// Receivers end a line with each datagram
+			ChunkSize = BVHLiveSender::MaxDatagramSize;
+			while (ChunkSize > 0 && Data[ChunkSize - 1] != '\n')
+			{
+				--ChunkSize;
+			}
+			if (ChunkSize == 0)
+			{
+				return false;
+			}
+		}
+
+		int32 BytesSent = 0;
+		const bool bSent = (Protocol == EBVHLiveProtocol::Udp)
+			? Socket->SendTo((const uint8*)Data, ChunkSize, BytesSent, *Address)
+			: Socket->Send((const uint8*)Data, ChunkSize, BytesSent);
+		if (!bSent || BytesSent <= 0)
+		{
+			return false;
+		}
+		Data += BytesSent;
+		Size -= BytesSent;
+	}
+	return true;
+}
@@ -0,0 +1,377 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHLiveSource.h"
+
+#include "Async/Async.h"
+#include "Common/UdpSocketBuilder.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+#include "BVHFile.h"
+
+#include <cstdlib>
+#include <cstring>
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHLiveSource, Log, All);
+
+namespace BVHLiveSource
+{
+	/** Bytes read from the socket at once, larger than any datagram */
+	static const int32 ReceiveSize = 64 * 1024;
+
+	/** A line growing past this size is not BVH text, it is dropped */
+	static const int32 MaxLineLength = 1024 * 1024;
+
+	/** Seconds between two connection attempts */
+	static const float ReconnectDelay = 0.5f;
+
+	/** Share of the difference between the arrival and the expected time of a frame that moves its timestamp */
+	static const double JitterSmoothing = 0.1;
+
+	static bool StartsWith(const char* Line, const char* Prefix)
+	{
+		return FCStringAnsi::Strncmp(Line, Prefix, FCStringAnsi::Strlen(Prefix)) == 0;
+	}
+
+	static FCriticalSection& GetRegistryLock()
+	{
+		static FCriticalSection RegistryLock;
+		return RegistryLock;
+	}
+
+	static TMap<FString, TWeakPtr<FBVHLiveSource>>& GetRegistry()
+	{
+		static TMap<FString, TWeakPtr<FBVHLiveSource>> Registry;
+		return Registry;
+	}
+}
+
+FBVHLiveSource::FBVHLiveSource(EBVHLiveProtocol InProtocol, const FString& InHost, int32 InPort, int32 InCapacity)
+	: Protocol(InProtocol)
+	, Host(InHost)
+	, Port(InPort)
+	, Capacity(InCapacity)
+	, bStopRequested(false)
+	, bConnected(false)
+	, Generation(0)
+{
+}
+
+FBVHLiveSource::~FBVHLiveSource()
+{
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+TSharedPtr<FBVHLiveSource> FBVHLiveSource::FindOrCreate(EBVHLiveProtocol Protocol, const FString& Host, int32 Port)
+{
+	const FString Key = FString::Printf(TEXT("%s:%s:%d"), Protocol == EBVHLiveProtocol::Tcp ? TEXT("tcp") : TEXT("udp"), Protocol == EBVHLiveProtocol::Tcp ? *Host : TEXT(""), Port);
+
+	FScopeLock Lock(&BVHLiveSource::GetRegistryLock());
+	TMap<FString, TWeakPtr<FBVHLiveSource>>& Registry = BVHLiveSource::GetRegistry();
+
+	TSharedPtr<FBVHLiveSource> Source = Registry.FindRef(Key).Pin();
+	if (!Source)
+	{
+		// The last reader is usually on the game thread, the receive thread may be inside a connect or a wait:
+		// it is asked to stop right away and joined on a thread of its own
+		Source = MakeShareable(new FBVHLiveSource(Protocol, Host, Port), [](FBVHLiveSource* Released)
+		{
+			Released->Stop();
+			Async(EAsyncExecution::Thread, [Released]()
+			{
+				delete Released;
+			});
+		});
+		if (!Source->Start())
+		{
+			return nullptr;
+		}
+		Registry.Add(Key, Source);
+	}
+	return Source;
+}
+
+bool FBVHLiveSource::Start()
+{
+	if (Thread)
+	{
+		return true;
+	}
+
+	bStopRequested = false;
+	Thread = FRunnableThread::Create(this, TEXT("BVHLiveSource"), 0, TPri_AboveNormal);
+	return Thread != nullptr;
+}
+
+TSharedPtr<const FBVHLiveStream> FBVHLiveSource::GetStream() const
+{
+	FScopeLock Lock(&StreamLock);
+	return Stream;
+}
+
+uint32 FBVHLiveSource::Run()
+{
+	// The only buffer of the receive loop
+	TArray<uint8> Buffer;
+	Buffer.SetNumUninitialized(BVHLiveSource::ReceiveSize);
+
+	while (!bStopRequested)
+	{
+		if (Socket == nullptr && !OpenSocket())
+		{
+			FPlatformProcess::Sleep(BVHLiveSource::ReconnectDelay);
+			continue;
+		}
+
+		if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)))
+		{
+			continue;
+		}
+
+		int32 BytesRead = 0;
+		if (Protocol == EBVHLiveProtocol::Udp)
+		{
+			while (Socket->Recv(Buffer.GetData(), Buffer.Num(), BytesRead) && BytesRead > 0)
+			{
+				ReceiveData(Buffer.GetData(), BytesRead, true);
+			}
+		}
+		else if (Socket->Recv(Buffer.GetData(), Buffer.Num(), BytesRead) && BytesRead > 0)
+		{
+			ReceiveData(Buffer.GetData(), BytesRead, false);
+		}
+		else
+		{
+			UE_LOG(LogBVHLiveSource, Log, TEXT("Disconnected from %s:%d"), *Host, Port);
+			CloseSocket();
+		}
+	}
+
+	CloseSocket();
+	return 0;
+}
+
+void FBVHLiveSource::Stop()
+{
+	bStopRequested = true;
+}
+
+bool FBVHLiveSource::OpenSocket()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem == nullptr)
+	{
+		return false;
+	}
+
+	if (Protocol == EBVHLiveProtocol::Udp)
+	{
+		Socket = FUdpSocketBuilder(TEXT("BVHLiveSource"))
+			.AsNonBlocking()
+			.AsReusable()
+			.BoundToPort(Port)
+			.WithReceiveBufferSize(1024 * 1024)
+			.Build();
+	}
+	else
+	{
+		FAddressInfoResult AddressInfo = SocketSubsystem->GetAddressInfo(*Host, nullptr, EAddressInfoFlags::Default, NAME_None);
+		if (AddressInfo.ReturnCode != SE_NO_ERROR || AddressInfo.Results.Num() == 0)
+		{
+			return false;
+		}
+
+		TSharedRef<FInternetAddr> Address = AddressInfo.Results[0].Address;
+		Address->SetPort(Port);
+
+		Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("BVHLiveSource"), Address->GetProtocolType());
+		if (Socket && !Socket->Connect(*Address))
+		{
+			SocketSubsystem->DestroySocket(Socket);
+			Socket = nullptr;
+		}
+	}
+
+	if (Socket == nullptr)
+	{
+		return false;
+	}
+
+	// A new connection starts with a header, nothing received before belongs to it
+	PendingLine.Reset();
+	bInHeader = false;
+	bConnected = true;
+	UE_LOG(LogBVHLiveSource, Log, TEXT("Receiving BVH frames on %s:%d"), *Host, Port);
+	return true;
+}
+
+void FBVHLiveSource::CloseSocket()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+	bConnected = false;
+}
+
+void FBVHLiveSource::ReceiveData(const uint8* Data, int32 Size, bool bEndsLine)
+{
+	const char* First = (const char*)Data;
+	const char* Last = First + Size;
+
+	while (First < Last)
+	{
+		const char* EndOfLine = (const char*)memchr(First, '\n', Last - First);
+		if (EndOfLine == nullptr)
+		{
+			EndOfLine = Last;
+			if (!bEndsLine)
+			{
+				// Rest of the line comes with the next read
+				if (PendingLine.Num() + (Last - First) > BVHLiveSource::MaxLineLength)
+				{
+					UE_LOG(LogBVHLiveSource, Warning, TEXT("Dropped a line of more than %d bytes"), BVHLiveSource::MaxLineLength);
+					PendingLine.Reset();
+					return;
+				}
+				PendingLine.Append(First, Last - First);
+				return;
+			}
+		}
+
+		// Line copied to the pending buffer, which keeps its allocation from line to line
+		PendingLine.Append(First, EndOfLine - First);
+		if (PendingLine.Num() > 0 && PendingLine.Last() == '\r')
+		{
+			PendingLine.Pop(false);
+		}
+		const int32 Length = PendingLine.Num();
+		PendingLine.Add('\0');
+		ReceiveLine(PendingLine.GetData(), Length);
+		PendingLine.Reset();
+
+		First = EndOfLine + 1;
+	}
+}
+
+void FBVHLiveSource::ReceiveLine(char* Line, int32 Length)
+{
+	while (*Line == ' ' || *Line == '\t')
+	{
+		++Line;
+		--Length;
+	}
+	if (Length <= 0)
+	{
+		return;
+	}
+
+	if (BVHLiveSource::StartsWith(Line, "HIERARCHY"))
+	{
+		HeaderText.Reset();
+		HierarchyLength = 0;
+		bInHeader = true;
+	}
+
+	if (bInHeader)
+	{
+		if (BVHLiveSource::StartsWith(Line, "MOTION"))
+		{
+			HierarchyLength = HeaderText.Num();
+		}
+		HeaderText.Append(Line, Length);
+		HeaderText.Add('\n');
+
+		if (BVHLiveSource::StartsWith(Line, "Frame Time"))
+		{
+			EndHeader();
+		}
+	}
+	else if (Stream)
+	{
+		DecodeFrame(Line);
+	}
+}
+
+void FBVHLiveSource::EndHeader()
+{
+	bInHeader = false;
+
+	// Senders repeat their header, e.g. on every connection, which keeps the stream and its readers' bone mapping
+	if (Stream && HierarchyLength == StreamHierarchy.Num() && FMemory::Memcmp(HeaderText.GetData(), StreamHierarchy.GetData(), HierarchyLength) == 0)
+	{
+		return;
+	}
+
+	TSharedPtr<FBVHFile> Hierarchy = MakeShared<FBVHFile>("");
+	if (!Hierarchy->ParseHeader(HeaderText.GetData(), HeaderText.Num()) || Hierarchy->GetNumChannel() == 0)
+	{
+		UE_LOG(LogBVHLiveSource, Warning, TEXT("Received an invalid BVH header on %s:%d"), *Host, Port);
+		return;
+	}
+
+	TSharedPtr<FBVHLiveStream> NewStream = MakeShared<FBVHLiveStream>();
+	NewStream->Hierarchy = Hierarchy;
+	NewStream->FrameTime = Hierarchy->GetInterval();
+	NewStream->Frames.Init(Hierarchy->GetNumChannel(), Capacity);
+	LastFrameTime = 0.0;
+
+	{
+		FScopeLock Lock(&StreamLock);
+		Stream = NewStream;
+		StreamHierarchy = TArray<char>(HeaderText.GetData(), HierarchyLength);
+	}
+	Generation.fetch_add(1, std::memory_order_release);
+
+	UE_LOG(LogBVHLiveSource, Log, TEXT("Receiving %d joints at %.1f frames per second on %s:%d"),
+		Hierarchy->GetNumJoint(), NewStream->FrameTime > 0.0 ? 1.0 / NewStream->FrameTime : 0.0, *Host, Port);
+}
+
+void FBVHLiveSource::DecodeFrame(const char* Line)
+{
+	FBVHFrameRing& Frames = Stream->Frames;
+	double* Values = Frames.BeginWrite();
+
+	const char* Token = Line;
+	for (int32 ChannelIdx = 0; ChannelIdx < Frames.GetNumChannels(); ++ChannelIdx)
+	{
+		while (*Token == ' ' || *Token == '\t' || *Token == ',')
+		{
+			++Token;
+		}
+
+		char* End = nullptr;
+		Values[ChannelIdx] = strtod(Token, &End);
+		if (End == Token)
+		{
+			// Short or malformed line, the slot is not published
+			return;
+		}
+		Token = End;
+	}
+
+	// Frames arriving close to their expected time are spaced by the frame time, so the network jitter does not show
+	const double Now = FPlatformTime::Seconds();
+	const double FrameTime = Stream->FrameTime;
+	const double Expected = LastFrameTime + FrameTime;
+	double Time = Now;
+	if (FrameTime > 0.0 && FMath::Abs(Now - Expected) < FrameTime)
+	{
+		Time = Expected + (Now - Expected) * BVHLiveSource::JitterSmoothing;
+	}
+	LastFrameTime = Time;
+
+	Frames.EndWrite(Time);
+}
@@ -0,0 +1,40 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHLoader.h"
+
+#include "Async/Async.h"
+
+#include "BVHFile.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHLoader, Log, All);
+
+TSharedPtr<FBVHFile> FBVHLoader::Load(const FString& Filename)
+{
+	TSharedPtr<FBVHFile> BvhFile = MakeShared<FBVHFile>(TCHAR_TO_ANSI(*Filename));
+	if (!BvhFile->Open())
+	{
+		UE_LOG(LogBVHLoader, Error, TEXT("Failed to open %s."), *Filename);
+		return nullptr;
+	}
+	return BvhFile;
+}
+
+TFuture<TSharedPtr<FBVHFile>> FBVHLoader::LoadAsync(const FString& Filename)
+{
+	return Async(EAsyncExecution::ThreadPool, [Filename]()
+	{
+		return Load(Filename);
+	});
+}
+
+void FBVHLoader::LoadAsync(const FString& Filename, FOnBVHFileLoaded OnLoaded)
+{
+	Async(EAsyncExecution::ThreadPool, [Filename, OnLoaded = MoveTemp(OnLoaded)]()
+	{
+		TSharedPtr<FBVHFile> BvhFile = Load(Filename);
+		AsyncTask(ENamedThreads::GameThread, [BvhFile, OnLoaded]()
+		{
+			OnLoaded.ExecuteIfBound(BvhFile);
+		});
+	});
+}
@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHMotionAsset.h"
+
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#include "BVHFile.h"
+#include "BVHLoader.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHMotionAsset)
+
+TSharedPtr<const FBVHFile> UBVHMotionAsset::GetFile() const
+{
+	FScopeLock Lock(&FileLock);
+	return File;
+}
+
+void UBVHMotionAsset::SetFile(TSharedPtr<FBVHFile> InFile)
+{
+	FScopeLock Lock(&FileLock);
+	File = InFile;
+}
+
+FString UBVHMotionAsset::GetSourceFilename() const
+{
+	if (SourceFile.FilePath.IsEmpty() || !FPaths::IsRelative(SourceFile.FilePath))
+	{
+		return SourceFile.FilePath;
+	}
+	return FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), SourceFile.FilePath);
+}
+
+void UBVHMotionAsset::Reload()
+{
+	const FString Filename = GetSourceFilename();
+	if (Filename.IsEmpty())
+	{
+		SetFile(nullptr);
+		return;
+	}
+
+	TWeakObjectPtr<UBVHMotionAsset> WeakThis(this);
+	FBVHLoader::LoadAsync(Filename, FOnBVHFileLoaded::CreateLambda([WeakThis, Filename](TSharedPtr<FBVHFile> LoadedFile)
+	{
+		// Ignore a load finishing after the source file changed again
+		UBVHMotionAsset* This = WeakThis.Get();
+		if (This && This->GetSourceFilename() == Filename)
+		{
+			This->SetFile(LoadedFile);
+		}
+	}));
+}
+
+bool UBVHMotionAsset::LoadNow()
+{
+	const FString Filename = GetSourceFilename();
+	TSharedPtr<FBVHFile> LoadedFile;
+	if (!Filename.IsEmpty())
+	{
+		LoadedFile = FBVHLoader::Load(Filename);
+	}
+	SetFile(LoadedFile);
+	return LoadedFile.IsValid();
+}
+
+float UBVHMotionAsset::GetPlayLength() const
+{
+	TSharedPtr<const FBVHFile> LoadedFile = GetFile();
+	// Same length as an imported sequence, the last frame ends it
+	return LoadedFile ? FMath::Max(LoadedFile->GetNumFrame() - 1, 0) * LoadedFile->GetInterval() : 0.f;
+}
+
+int32 UBVHMotionAsset::GetNumFrames() const
+{
+	TSharedPtr<const FBVHFile> LoadedFile = GetFile();
+	return LoadedFile ? LoadedFile->GetNumFrame() : 0;
+}
+
+void UBVHMotionAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	// Nothing plays while cooking
+	if (!IsRunningCommandlet())
+	{
+		Reload();
+	}
+}
+
+#if WITH_EDITOR
+void UBVHMotionAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(UBVHMotionAsset, SourceFile))
+	{
+		Reload();
+	}
+}
+#endif
@@ -0,0 +1,427 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHMotionLibrary.h"
+
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+
+#include "BVHTextBuffer.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHMotionLibrary, Log, All);
+
+namespace BVHMotionLibrary
+{
+	static const uint32 Magic = 0x4C485642; // "BVHL"
+	static const uint32 Version = 1;
+
+	/** Magic, version and directory offset */
+	static const int64 HeaderSize = sizeof(uint32) * 2 + sizeof(int64);
+
+	/** Decimals of the hierarchy offsets, as written by FBVHFile::Save() */
+	static const int32 Precision = 6;
+
+	/** A take parsed by a builder worker, written to the library in file order */
+	struct FTakeData
+	{
+		bool bValid = false;
+		FString Header;
+		FBVHLibraryTake Take;
+		TArray<TArray<uint8>> Blocks;
+	};
+
+	/**
+	* Consecutive values of a smooth channel share their sign, exponent and top mantissa bits: each value is xor-ed
+	* with the previous one and the bytes are regrouped by significance, so zlib sees long runs of zeros.
+	*/
+	static void EncodeBlock(const double* Values, int32 NumValues, TArray<uint8>& Shuffled, TArray<uint8>& OutBlock)
+	{
+		const int32 RawSize = NumValues * sizeof(double);
+		Shuffled.SetNumUninitialized(RawSize, false);
+
+		uint64 Previous = 0;
+		for (int32 ValueIdx = 0; ValueIdx < NumValues; ++ValueIdx)
+		{
+			uint64 Bits;
+			FMemory::Memcpy(&Bits, &Values[ValueIdx], sizeof(Bits));
+			const uint64 Delta = Bits ^ Previous;
+			Previous = Bits;
+			for (int32 ByteIdx = 0; ByteIdx < (int32)sizeof(double); ++ByteIdx)
+			{
+				Shuffled[ByteIdx * NumValues + ValueIdx] = (uint8)(Delta >> (ByteIdx * 8));
+			}
+		}
+
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, RawSize);
+		OutBlock.SetNumUninitialized(CompressedSize);
+		if (!FCompression::CompressMemory(NAME_Zlib, OutBlock.GetData(), CompressedSize, Shuffled.GetData(), RawSize) || CompressedSize >= RawSize)
+		{
+			// Stored as is, a block of RawSize bytes is never compressed
+			OutBlock = Shuffled;
+			return;
+		}
+		OutBlock.SetNum(CompressedSize, false);
+	}
+
+	static void ParseTake(const FString& Filename, FTakeData& OutTake)
+	{
+		OutTake.Take.SourceFilename = Filename;
+
+		FBVHFile BvhFile(TCHAR_TO_ANSI(*Filename));
+		if (!BvhFile.Open() || BvhFile.GetNumJoint() == 0)
+		{
+			return;
+		}
+
+		// The written column order is the channel order of the hierarchy parsed back from the header
+		FBVHTextBuffer Text;
+		std::vector<int> ChannelOrder;
+		BvhFile.FormatHierarchy(Text, ChannelOrder, Precision);
+		Text.Append("MOTION\nFrames: 0\nFrame Time: 0\n");
+		OutTake.Header = FString((int32)Text.GetSize(), Text.GetData());
+
+		FBVHLibraryTake& Take = OutTake.Take;
+		Take.MotionName = FString(BvhFile.GetMotionName().c_str());
+		Take.NumFrames = BvhFile.GetNumFrame();
+		Take.FrameTime = BvhFile.GetInterval();
+
+		const int32 NumBlocks = Take.GetNumBlocks();
+		OutTake.Blocks.SetNum((int32)ChannelOrder.size() * NumBlocks);
+
+		TArray<double> Values;
+		TArray<uint8> Shuffled;
+		Values.SetNumUninitialized(FBVHMotionLibrary::BlockFrames);
+		for (int32 ColumnIdx = 0; ColumnIdx < (int32)ChannelOrder.size(); ++ColumnIdx)
+		{
+			for (int32 BlockIdx = 0; BlockIdx < NumBlocks; ++BlockIdx)
+			{
+				const int32 FirstFrame = BlockIdx * FBVHMotionLibrary::BlockFrames;
+				const int32 NumValues = FMath::Min(FBVHMotionLibrary::BlockFrames, Take.NumFrames - FirstFrame);
+				for (int32 ValueIdx = 0; ValueIdx < NumValues; ++ValueIdx)
+				{
+					Values[ValueIdx] = BvhFile.GetMotion(FirstFrame + ValueIdx, ChannelOrder[ColumnIdx]);
+				}
+				EncodeBlock(Values.GetData(), NumValues, Shuffled, OutTake.Blocks[ColumnIdx * NumBlocks + BlockIdx]);
+			}
+		}
+		OutTake.bValid = true;
+	}
+}
+
+int32 FBVHLibraryTake::GetNumBlocks() const
+{
+	return (NumFrames + FBVHMotionLibrary::BlockFrames - 1) / FBVHMotionLibrary::BlockFrames;
+}
+
+FArchive& operator<<(FArchive& Ar, FBVHLibraryTake& Take)
+{
+	return Ar << Take.SourceFilename << Take.MotionName << Take.Hierarchy << Take.NumFrames << Take.FrameTime << Take.FirstBlock;
+}
+
+bool FBVHMotionLibrary::Build(const TArray<FString>& Filenames, const FString& LibraryFilename, int32 BatchSize)
+{
+	using namespace BVHMotionLibrary;
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*LibraryFilename));
+	if (!Writer)
+	{
+		UE_LOG(LogBVHMotionLibrary, Error, TEXT("Failed to create %s."), *LibraryFilename);
+		return false;
+	}
+
+	// The directory offset is patched once the blocks are written
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	int64 DirectoryOffset = 0;
+	*Writer << FileMagic << FileVersion << DirectoryOffset;
+
+	TArray<FString> HierarchyHeaders;
+	TMap<FString, int32> HierarchyIndices;
+	TArray<FBVHLibraryTake> Takes;
+	TArray<FBlock> Blocks;
+
+	BatchSize = FMath::Max(BatchSize, 1);
+	for (int32 BatchStart = 0; BatchStart < Filenames.Num(); BatchStart += BatchSize)
+	{
+		const int32 BatchNum = FMath::Min(BatchSize, Filenames.Num() - BatchStart);
+
+		TArray<FTakeData> Batch;
+		Batch.SetNum(BatchNum);
+		ParallelFor(BatchNum, [&](int32 Index)
+		{
+			ParseTake(Filenames[BatchStart + Index], Batch[Index]);
+		});
+
+		for (FTakeData& TakeData : Batch)
+		{
+			if (!TakeData.bValid)
+			{
+				UE_LOG(LogBVHMotionLibrary, Error, TEXT("Failed to open %s, skipped."), *TakeData.Take.SourceFilename);
+				continue;
+			}
+
+			FBVHLibraryTake& Take = Takes.Add_GetRef(MoveTemp(TakeData.Take));
+			Take.Hierarchy = HierarchyIndices.FindOrAdd(TakeData.Header, HierarchyHeaders.Num());
+			if (Take.Hierarchy == HierarchyHeaders.Num())
+			{
+				HierarchyHeaders.Add(MoveTemp(TakeData.Header));
+			}
+
+			Take.FirstBlock = Blocks.Num();
+			for (TArray<uint8>& Data : TakeData.Blocks)
+			{
+				FBlock& Block = Blocks.AddDefaulted_GetRef();
+				Block.Offset = Writer->Tell();
+				Block.CompressedSize = Data.Num();
+				Writer->Serialize(Data.GetData(), Data.Num());
+			}
+		}
+
+		UE_LOG(LogBVHMotionLibrary, Display, TEXT("Added %d/%d"), BatchStart + BatchNum, Filenames.Num());
+	}
+
+	DirectoryOffset = Writer->Tell();
+	*Writer << HierarchyHeaders << Takes << Blocks;
+
+	Writer->Seek(0);
+	*Writer << FileMagic << FileVersion << DirectoryOffset;
+
+	const bool bWritten = Writer->Close();
+	UE_LOG(LogBVHMotionLibrary, Display, TEXT("Wrote %d takes with %d hierarchies to %s, %.1f MB"),
+		Takes.Num(), HierarchyHeaders.Num(), *LibraryFilename, DirectoryOffset / (1024.0 * 1024.0));
+	return bWritten;
+}
+
+FBVHMotionLibrary::FBVHMotionLibrary()
+	: MappedFile(nullptr)
+	, MappedRegion(nullptr)
+{
+}
+
+FBVHMotionLibrary::~FBVHMotionLibrary()
+{
+	Close();
+}
+
+bool FBVHMotionLibrary::Open(const FString& LibraryFilename)
+{
+	using namespace BVHMotionLibrary;
+
+	Close();
+
+	MappedFile = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*LibraryFilename);
+	if (MappedFile == nullptr || MappedFile->GetFileSize() < HeaderSize)
+	{
+		UE_LOG(LogBVHMotionLibrary, Error, TEXT("Failed to map %s."), *LibraryFilename);
+		Close();
+		return false;
+	}
+	MappedRegion = MappedFile->MapRegion(0, MappedFile->GetFileSize());
+	if (MappedRegion == nullptr)
+	{
+		UE_LOG(LogBVHMotionLibrary, Error, TEXT("Failed to map %s."), *LibraryFilename);
+		Close();
+		return false;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	const int64 Size = MappedRegion->GetMappedSize();
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	int64 DirectoryOffset = 0;
+	FMemoryReaderView HeaderReader(TArrayView<const uint8>(Data, HeaderSize));
+	HeaderReader << FileMagic << FileVersion << DirectoryOffset;
+	if (FileMagic != Magic || FileVersion != Version || DirectoryOffset < HeaderSize || DirectoryOffset > Size)
+	{
+		UE_LOG(LogBVHMotionLibrary, Error, TEXT("%s is not a motion library of version %u."), *LibraryFilename, Version);
+		Close();
+		return false;
+	}
+
+	// Only the directory is read here, the blocks stay on disk until queried
+	TArray<FString> HierarchyHeaders;
+	FMemoryReaderView DirectoryReader(TArrayView<const uint8>(Data + DirectoryOffset, (int32)(Size - DirectoryOffset)));
+	DirectoryReader << HierarchyHeaders << Takes << Blocks;
+	if (DirectoryReader.IsError())
+	{
+		UE_LOG(LogBVHMotionLibrary, Error, TEXT("The directory of %s is corrupt."), *LibraryFilename);
+		Close();
+		return false;
+	}
+
+	for (const FString& Header : HierarchyHeaders)
+	{
+		const auto HeaderText = StringCast<ANSICHAR>(*Header);
+		TUniquePtr<FBVHFile>& Hierarchy = Hierarchies.Add_GetRef(MakeUnique<FBVHFile>(""));
+		if (!Hierarchy->ParseHeader(HeaderText.Get(), HeaderText.Length()))
+		{
+			UE_LOG(LogBVHMotionLibrary, Error, TEXT("A hierarchy of %s is corrupt."), *LibraryFilename);
+			Close();
+			return false;
+		}
+	}
+
+	for (const FBVHLibraryTake& Take : Takes)
+	{
+		const int32 NumBlocks = Hierarchies.IsValidIndex(Take.Hierarchy) ? Hierarchies[Take.Hierarchy]->GetNumChannel() * Take.GetNumBlocks() : INDEX_NONE;
+		if (NumBlocks < 0 || Take.FirstBlock < 0 || Take.FirstBlock + NumBlocks > Blocks.Num())
+		{
+			UE_LOG(LogBVHMotionLibrary, Error, TEXT("The take %s of %s is corrupt."), *Take.MotionName, *LibraryFilename);
+			Close();
+			return false;
+		}
+	}
+	for (const FBlock& Block : Blocks)
+	{
+		if (Block.Offset < (uint64)HeaderSize || Block.Offset + Block.CompressedSize > (uint64)DirectoryOffset)
+		{
+			UE_LOG(LogBVHMotionLibrary, Error, TEXT("The blocks of %s are corrupt."), *LibraryFilename);
+			Close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void FBVHMotionLibrary::Close()
+{
+	delete MappedRegion;
+	MappedRegion = nullptr;
+	delete MappedFile;
+	MappedFile = nullptr;
+
+	Hierarchies.Reset();
+	Takes.Reset();
+	Blocks.Reset();
+}
+
+int32 FBVHMotionLibrary::FindChannel(int32 TakeIdx, const FString& JointName, ChannelEnum Type) const
+{
+	const Joint* joint = GetHierarchy(Takes[TakeIdx].Hierarchy).GetJoint(std::string(TCHAR_TO_ANSI(*JointName)));
+	if (joint == NULL)
+	{
+		return INDEX_NONE;
+	}
+	for (const Channel* channel : joint->channels)
+	{
+		if (channel->type == Type)
+		{
+			return channel->index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool FBVHMotionLibrary::ReadBlock(const FBlock& Block, int32 NumValues, TArray<uint8>& Scratch, double* OutValues) const
+{
+	const int32 RawSize = NumValues * sizeof(double);
+	const uint8* Shuffled = MappedRegion->GetMappedPtr() + Block.Offset;
+	if ((int32)Block.CompressedSize != RawSize)
+	{
+		Scratch.SetNumUninitialized(RawSize, false);
+		if (!FCompression::UncompressMemory(NAME_Zlib, Scratch.GetData(), RawSize, Shuffled, Block.CompressedSize))
+		{
+			return false;
+		}
+		Shuffled = Scratch.GetData();
+	}
+
+	uint64 Previous = 0;
+	for (int32 ValueIdx = 0; ValueIdx < NumValues; ++ValueIdx)
+	{
+		uint64 Delta = 0;
+		for (int32 ByteIdx = 0; ByteIdx < (int32)sizeof(double); ++ByteIdx)
+		{
+			Delta |= (uint64)Shuffled[ByteIdx * NumValues + ValueIdx] << (ByteIdx * 8);
+		}
+		Previous ^= Delta;
+		FMemory::Memcpy(&OutValues[ValueIdx], &Previous, sizeof(double));
+	}
+	return true;
+}
+
+bool FBVHMotionLibrary::ReadChannel(int32 TakeIdx, int32 ChannelIdx, int32 FirstFrame, int32 NumFrames, double* OutValues) const
+{
+	if (!Takes.IsValidIndex(TakeIdx))
+	{
+		return false;
+	}
+	const FBVHLibraryTake& Take = Takes[TakeIdx];
+	if (ChannelIdx < 0 || ChannelIdx >= GetHierarchy(Take.Hierarchy).GetNumChannel() || FirstFrame < 0 || NumFrames < 0 || FirstFrame + NumFrames > Take.NumFrames)
+	{
+		return false;
+	}
+
+	TArray<uint8> Scratch;
+	TArray<double> BlockValues;
+	const int32 NumBlocks = Take.GetNumBlocks();
+	int32 Frame = FirstFrame;
+	while (Frame < FirstFrame + NumFrames)
+	{
+		const int32 BlockIdx = Frame / BlockFrames;
+		const int32 BlockFirstFrame = BlockIdx * BlockFrames;
+		const int32 NumBlockValues = FMath::Min(BlockFrames, Take.NumFrames - BlockFirstFrame);
+
+		BlockValues.SetNumUninitialized(NumBlockValues, false);
+		if (!ReadBlock(Blocks[Take.FirstBlock + ChannelIdx * NumBlocks + BlockIdx], NumBlockValues, Scratch, BlockValues.GetData()))
+		{
+			UE_LOG(LogBVHMotionLibrary, Error, TEXT("Failed to decode a block of %s."), *Take.MotionName);
+			return false;
+		}
+
+		const int32 NumCopied = FMath::Min(BlockFirstFrame + NumBlockValues, FirstFrame + NumFrames) - Frame;
+		FMemory::Memcpy(&OutValues[Frame - FirstFrame], &BlockValues[Frame - BlockFirstFrame], NumCopied * sizeof(double));
+		Frame += NumCopied;
+	}
+	return true;
+}
+
+void FBVHMotionLibrary::FindFrames(const FString& JointName, ChannelEnum Type, TFunctionRef<bool(double)> Predicate, TArray<FBVHLibraryRange>& OutRanges) const
+{
+	TArray<TArray<FBVHLibraryRange>> TakeRanges;
+	TakeRanges.SetNum(Takes.Num());
+
+	ParallelFor(Takes.Num(), [&](int32 TakeIdx)
+	{
+		const int32 ChannelIdx = FindChannel(TakeIdx, JointName, Type);
+		if (ChannelIdx == INDEX_NONE)
+		{
+			return;
+		}
+
+		TArray<double> Values;
+		Values.SetNumUninitialized(Takes[TakeIdx].NumFrames);
+		if (!ReadChannel(TakeIdx, ChannelIdx, 0, Values.Num(), Values.GetData()))
+		{
+			return;
+		}
+
+		FBVHLibraryRange* Range = nullptr;
+		for (int32 Frame = 0; Frame < Values.Num(); ++Frame)
+		{
+			if (!Predicate(Values[Frame]))
+			{
+				Range = nullptr;
+			}
+			else if (Range)
+			{
+				Range->LastFrame = Frame;
+			}
+			else
+			{
+				Range = &TakeRanges[TakeIdx].Add_GetRef({ TakeIdx, Frame, Frame });
+			}
+		}
+	});
+
+	// Ranges in take order, whatever order the takes were searched in
+	OutRanges.Reset();
+	for (const TArray<FBVHLibraryRange>& Ranges : TakeRanges)
+	{
+		OutRanges.Append(Ranges);
+	}
+}
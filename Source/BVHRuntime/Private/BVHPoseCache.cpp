@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHPoseCache.h"
+
+#include "BVHCoreAdapter.h"
+
+void FBVHPoseCache::Reset(int32 InNumJoints, int32 NumEntries)
+{
+	NumJoints = InNumJoints;
+	Entries.SetNum(FMath::Max(NumEntries, 2));
+	for (FEntry& Entry : Entries)
+	{
+		Entry.Frame = INDEX_NONE;
+		Entry.LastUse = 0;
+		Entry.Pose.Init(FTransform::Identity, NumJoints);
+	}
+	UseCounter = 0;
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+const TArray<FTransform>& FBVHPoseCache::GetPose(const FBVHFile& BvhFile, int32 Frame, const TBitArray<>& JointMask)
+{
+	check(Entries.Num() > 0 && BvhFile.GetNumJoint() == NumJoints);
+
+	// Few entries, a linear search beats any map
+	FEntry* Oldest = &Entries[0];
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.Frame == Frame)
+		{
+			Entry.LastUse = ++UseCounter;
+			++NumHits;
+			return Entry.Pose;
+		}
+		if (Entry.LastUse < Oldest->LastUse)
+		{
+			Oldest = &Entry;
+		}
+	}
+
+	++NumMisses;
+	for (TConstSetBitIterator<> It(JointMask); It; ++It)
+	{
+		Oldest->Pose[It.GetIndex()] = BVHCoreAdapter::GetTransform(BvhFile, Frame, It.GetIndex());
+	}
+	Oldest->Frame = Frame;
+	Oldest->LastUse = ++UseCounter;
+	return Oldest->Pose;
+}
@@ -0,0 +1,489 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHPoseIndex.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+
+#include "BVHCoreAdapter.h"
+
+#include <algorithm>
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHPoseIndex, Log, All);
+
+namespace BVHPoseIndex
+{
+	static const uint32 Magic = 0x49505642; // "BVPI"
+	static const uint32 Version = 1;
+
+	/** Entries of a leaf, scanned linearly */
+	static const int32 LeafSize = 16;
+
+	/** Frames extracted by a task while building */
+	static const int32 ExtractBlockSize = 256;
+
+	/** Keeps the farthest match on top of the heap */
+	static bool FartherFirst(const FBVHPoseMatch& A, const FBVHPoseMatch& B)
+	{
+		return A.Distance > B.Distance;
+	}
+}
+
+uint32 FBVHPoseIndex::HashSource(const TArray<const FBVHFile*>& Clips, const FBVHPoseFeatureSettings& InSettings)
+{
+	uint32 Hash = FCrc::MemCrc32(&BVHPoseIndex::Version, sizeof(BVHPoseIndex::Version));
+	for (const FString& JointName : InSettings.JointNames)
+	{
+		Hash = FCrc::StrCrc32(*JointName, Hash);
+	}
+	const uint8 Flags = (InSettings.bPositions ? 1 : 0) | (InSettings.bVelocities ? 2 : 0);
+	Hash = FCrc::MemCrc32(&Flags, sizeof(Flags), Hash);
+
+	for (const FBVHFile* Clip : Clips)
+	{
+		for (int32 JointIdx = 0; JointIdx < Clip->GetNumJoint(); ++JointIdx)
+		{
+			const Joint* joint = Clip->GetJoint(JointIdx);
+			Hash = FCrc::MemCrc32(joint->name.c_str(), joint->name.size(), Hash);
+			Hash = FCrc::MemCrc32(joint->offset, sizeof(joint->offset), Hash);
+		}
+
+		const int32 NumFrame = Clip->GetNumFrame();
+		const double Interval = Clip->GetInterval();
+		Hash = FCrc::MemCrc32(&NumFrame, sizeof(NumFrame), Hash);
+		Hash = FCrc::MemCrc32(&Interval, sizeof(Interval), Hash);
+		if (NumFrame > 0)
+		{
+			Hash = FCrc::MemCrc32(Clip->GetMotionFrame(0), NumFrame * Clip->GetNumChannel() * sizeof(double), Hash);
+		}
+	}
+	return Hash;
+}
+
+/**
+* Component space root and feature joint positions of the last three frames, so that consecutive frames run forward kinematics once each.
+* A frame lives in slot Frame % 3, the previous, current and next frame of a feature never share a slot.
+*/
+struct FBVHPoseIndex::FPoseCache
+{
+	FIntPoint Keys[3] = { FIntPoint(INDEX_NONE), FIntPoint(INDEX_NONE), FIntPoint(INDEX_NONE) };
+	FTransform Roots[3];
+	TArray<FVector> Positions[3];
+	TArray<FTransform> Scratch;
+
+	/** Slot holding the pose of a frame of a clip, computed on a miss */
+	int32 Get(const FBVHFile& Clip, int32 ClipIdx, const TArray<int32>& JointIndices, int32 Frame)
+	{
+		const int32 Slot = Frame % 3;
+		if (Keys[Slot] == FIntPoint(ClipIdx, Frame))
+		{
+			return Slot;
+		}
+
+		// Parents come before their children
+		const int32 NumJoints = Clip.GetNumJoint();
+		Scratch.SetNum(NumJoints, false);
+		for (int32 JointIdx = 0; JointIdx < NumJoints; ++JointIdx)
+		{
+			const Joint* joint = Clip.GetJoint(JointIdx);
+			Scratch[JointIdx] = BVHCoreAdapter::GetTransform(Clip, Frame, JointIdx);
+			if (joint->parent)
+			{
+				Scratch[JointIdx] *= Scratch[joint->parent->index];
+			}
+		}
+
+		Keys[Slot] = FIntPoint(ClipIdx, Frame);
+		Roots[Slot] = Scratch[0];
+		Positions[Slot].SetNum(JointIndices.Num(), false);
+		for (int32 Idx = 0; Idx < JointIndices.Num(); ++Idx)
+		{
+			Positions[Slot][Idx] = Scratch[JointIndices[Idx]].GetTranslation();
+		}
+		return Slot;
+	}
+};
+
+bool FBVHPoseIndex::FindJoints(const FBVHFile& Clip, TArray<int32>& OutJointIndices) const
+{
+	OutJointIndices.Reset(Settings.JointNames.Num());
+	for (const FString& JointName : Settings.JointNames)
+	{
+		const Joint* joint = Clip.GetJoint(std::string(TCHAR_TO_ANSI(*JointName)));
+		if (joint == NULL)
+		{
+			UE_LOG(LogBVHPoseIndex, Error, TEXT("%s has no joint %s."), ANSI_TO_TCHAR(Clip.GetMotionName().c_str()), *JointName);
+			return false;
+		}
+		OutJointIndices.Add(joint->index);
+	}
+	return true;
+}
+
+void FBVHPoseIndex::ExtractRawFeatures(const FBVHFile& Clip, int32 ClipIdx, const TArray<int32>& JointIndices, int32 Frame, FPoseCache& Cache, float* OutFeatures) const
+{
+	// Previous, current and next frame, the first two are usually cached by the extraction of the frame before
+	const int32 Frames[3] = { FMath::Max(Frame - 1, 0), Frame, FMath::Min(Frame + 1, Clip.GetNumFrame() - 1) };
+	const int32 Slots[3] = { Cache.Get(Clip, ClipIdx, JointIndices, Frames[0]), Cache.Get(Clip, ClipIdx, JointIndices, Frames[1]), Cache.Get(Clip, ClipIdx, JointIndices, Frames[2]) };
+	const TArray<FVector>& Previous = Cache.Positions[Slots[0]];
+	const TArray<FVector>& Current = Cache.Positions[Slots[1]];
+	const TArray<FVector>& Next = Cache.Positions[Slots[2]];
+
+	// Everything is expressed in the space of the root of the current frame
+	const FTransform& Root = Cache.Roots[Slots[1]];
+	const double VelocityTime = FMath::Max((Frames[2] - Frames[0]) * Clip.GetInterval(), UE_SMALL_NUMBER);
+
+	float* Feature = OutFeatures;
+	if (Settings.bPositions)
+	{
+		for (int32 Idx = 0; Idx < JointIndices.Num(); ++Idx)
+		{
+			const FVector Position = Root.InverseTransformPosition(Current[Idx]);
+			*Feature++ = (float)Position.X;
+			*Feature++ = (float)Position.Y;
+			*Feature++ = (float)Position.Z;
+		}
+	}
+	if (Settings.bVelocities)
+	{
+		for (int32 Idx = 0; Idx < JointIndices.Num(); ++Idx)
+		{
+			const FVector Velocity = (Root.InverseTransformPosition(Next[Idx]) - Root.InverseTransformPosition(Previous[Idx])) / VelocityTime;
+			*Feature++ = (float)Velocity.X;
+			*Feature++ = (float)Velocity.Y;
+			*Feature++ = (float)Velocity.Z;
+		}
+	}
+}
+
+bool FBVHPoseIndex::ExtractFeatures(const FBVHFile& Clip, int32 Frame, float* OutFeatures) const
+{
+	TArray<int32> JointIndices;
+	if (Frame < 0 || Frame >= Clip.GetNumFrame() || Mean.Num() != GetNumFeatures() || !FindJoints(Clip, JointIndices))
+	{
+		return false;
+	}
+
+	FPoseCache Cache;
+	ExtractRawFeatures(Clip, 0, JointIndices, Frame, Cache, OutFeatures);
+	for (int32 Dim = 0; Dim < Mean.Num(); ++Dim)
+	{
+		OutFeatures[Dim] = (OutFeatures[Dim] - Mean[Dim]) * InvDeviation[Dim];
+	}
+	return true;
+}
+
+bool FBVHPoseIndex::Build(const TArray<const FBVHFile*>& Clips, const FBVHPoseFeatureSettings& InSettings)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	Settings = InSettings;
+	SourceHash = HashSource(Clips, InSettings);
+	Entries.Reset();
+	Features.Reset();
+	Nodes.Reset();
+
+	const int32 NumFeatures = GetNumFeatures();
+	TArray<TArray<int32>> ClipJoints;
+	ClipJoints.SetNum(Clips.Num());
+	for (int32 ClipIdx = 0; ClipIdx < Clips.Num(); ++ClipIdx)
+	{
+		if (!FindJoints(*Clips[ClipIdx], ClipJoints[ClipIdx]))
+		{
+			return false;
+		}
+		for (int32 Frame = 0; Frame < Clips[ClipIdx]->GetNumFrame(); ++Frame)
+		{
+			Entries.Add(FIntPoint(ClipIdx, Frame));
+		}
+	}
+	if (NumFeatures == 0 || Entries.Num() == 0)
+	{
+		UE_LOG(LogBVHPoseIndex, Error, TEXT("Nothing to index, %d features of %d frames."), NumFeatures, Entries.Num());
+		return false;
+	}
+
+	TArray<float> RawFeatures;
+	RawFeatures.SetNumUninitialized(Entries.Num() * NumFeatures);
+	const int32 NumBlocks = FMath::DivideAndRoundUp(Entries.Num(), BVHPoseIndex::ExtractBlockSize);
+	ParallelFor(NumBlocks, [&](int32 BlockIdx)
+	{
+		// Entries of a block are consecutive frames, forward kinematics runs once per frame
+		FPoseCache Cache;
+		const int32 End = FMath::Min((BlockIdx + 1) * BVHPoseIndex::ExtractBlockSize, Entries.Num());
+		for (int32 EntryIdx = BlockIdx * BVHPoseIndex::ExtractBlockSize; EntryIdx < End; ++EntryIdx)
+		{
+			const int32 ClipIdx = Entries[EntryIdx].X;
+			ExtractRawFeatures(*Clips[ClipIdx], ClipIdx, ClipJoints[ClipIdx], Entries[EntryIdx].Y, Cache, &RawFeatures[EntryIdx * NumFeatures]);
+		}
+	});
+
+	// Positions and velocities have different ranges, each dimension is scaled to unit deviation
+	Mean.SetNumUninitialized(NumFeatures);
+	InvDeviation.SetNumUninitialized(NumFeatures);
+	ParallelFor(NumFeatures, [&](int32 Dim)
+	{
+		double Sum = 0.0;
+		double SquaredSum = 0.0;
+		for (int32 EntryIdx = 0; EntryIdx < Entries.Num(); ++EntryIdx)
+		{
+			const double Value = RawFeatures[EntryIdx * NumFeatures + Dim];
+			Sum += Value;
+			SquaredSum += Value * Value;
+		}
+		const double DimMean = Sum / Entries.Num();
+		const double Deviation = FMath::Sqrt(FMath::Max(SquaredSum / Entries.Num() - DimMean * DimMean, 0.0));
+		Mean[Dim] = (float)DimMean;
+		InvDeviation[Dim] = Deviation > UE_KINDA_SMALL_NUMBER ? (float)(1.0 / Deviation) : 1.f;
+	});
+	ParallelFor(Entries.Num(), [&](int32 EntryIdx)
+	{
+		float* Feature = &RawFeatures[EntryIdx * NumFeatures];
+		for (int32 Dim = 0; Dim < NumFeatures; ++Dim)
+		{
+			Feature[Dim] = (Feature[Dim] - Mean[Dim]) * InvDeviation[Dim];
+		}
+	});
+
+	TArray<int32> Order;
+	Order.SetNumUninitialized(Entries.Num());
+	for (int32 EntryIdx = 0; EntryIdx < Order.Num(); ++EntryIdx)
+	{
+		Order[EntryIdx] = EntryIdx;
+	}
+	BuildNode(0, Order.Num(), Order, RawFeatures);
+
+	// Leaves index contiguous entries, in the order the tree left them
+	const TArray<FIntPoint> UnorderedEntries = MoveTemp(Entries);
+	Entries.SetNumUninitialized(Order.Num());
+	Features.SetNumUninitialized(RawFeatures.Num());
+	for (int32 EntryIdx = 0; EntryIdx < Order.Num(); ++EntryIdx)
+	{
+		Entries[EntryIdx] = UnorderedEntries[Order[EntryIdx]];
+		FMemory::Memcpy(&Features[EntryIdx * NumFeatures], &RawFeatures[Order[EntryIdx] * NumFeatures], NumFeatures * sizeof(float));
+	}
+
+	BuildSeconds = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogBVHPoseIndex, Log, TEXT("Indexed %d frames of %d clips, %d features, %d nodes in %.2f ms"),
+		Entries.Num(), Clips.Num(), NumFeatures, Nodes.Num(), BuildSeconds * 1000.0);
+	return true;
+}
+
+int32 FBVHPoseIndex::BuildNode(int32 Begin, int32 End, TArray<int32>& Order, const TArray<float>& RawFeatures)
+{
+	const int32 NumFeatures = GetNumFeatures();
+	const int32 NodeIdx = Nodes.AddDefaulted();
+	Nodes[NodeIdx].Begin = Begin;
+	Nodes[NodeIdx].End = End;
+	if (End - Begin <= BVHPoseIndex::LeafSize)
+	{
+		return NodeIdx;
+	}
+
+	// Split the dimension with the widest spread at its median
+	int32 SplitDim = 0;
+	float WidestSpread = 0.f;
+	for (int32 Dim = 0; Dim < NumFeatures; ++Dim)
+	{
+		float Min = MAX_flt;
+		float Max = -MAX_flt;
+		for (int32 Idx = Begin; Idx < End; ++Idx)
+		{
+			const float Value = RawFeatures[Order[Idx] * NumFeatures + Dim];
+			Min = FMath::Min(Min, Value);
+			Max = FMath::Max(Max, Value);
+		}
+		if (Max - Min > WidestSpread)
+		{
+			WidestSpread = Max - Min;
+			SplitDim = Dim;
+		}
+	}
+	if (WidestSpread <= 0.f)
+	{
+		// Identical poses, nothing to split
+		return NodeIdx;
+	}
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	std::nth_element(Order.GetData() + Begin, Order.GetData() + Mid, Order.GetData() + End, [&](int32 A, int32 B)
+	{
+		return RawFeatures[A * NumFeatures + SplitDim] < RawFeatures[B * NumFeatures + SplitDim];
+	});
+
+	const float SplitValue = RawFeatures[Order[Mid] * NumFeatures + SplitDim];
+	const int32 Left = BuildNode(Begin, Mid, Order, RawFeatures);
+	const int32 Right = BuildNode(Mid, End, Order, RawFeatures);
+
+	FNode& Node = Nodes[NodeIdx];
+	Node.Left = Left;
+	Node.Right = Right;
+	Node.SplitDim = SplitDim;
+	Node.SplitValue = SplitValue;
+	return NodeIdx;
+}
+
+bool FBVHPoseIndex::IsValidNode(const FNode& Node) const
+{
+	// Children come after their parent, a corrupt file can neither index out of Nodes nor make SearchNode() loop
+	const int32 NodeIdx = UE_PTRDIFF_TO_INT32(&Node - Nodes.GetData());
+	const bool bIsLeaf = Node.Left == INDEX_NONE && Node.Right == INDEX_NONE;
+	const bool bHasChildren = Node.Left > NodeIdx && Node.Left < Nodes.Num() && Node.Right > NodeIdx && Node.Right < Nodes.Num();
+	return Node.Begin >= 0 && Node.Begin <= Node.End && Node.End <= Entries.Num() && Node.SplitDim >= 0 && Node.SplitDim < GetNumFeatures()
+		&& (bIsLeaf || bHasChildren);
+}
+
+void FBVHPoseIndex::SearchNode(int32 NodeIdx, const float* Query, int32 K, TArray<FBVHPoseMatch>& Heap) const
+{
+	const FNode& Node = Nodes[NodeIdx];
+	if (Node.Left == INDEX_NONE)
+	{
+		const int32 NumFeatures = GetNumFeatures();
+		for (int32 EntryIdx = Node.Begin; EntryIdx < Node.End; ++EntryIdx)
+		{
+			// Squared distances while searching, the sum stops as soon as it cannot beat the farthest match
+			const float Worst = (Heap.Num() < K) ? MAX_flt : Heap.HeapTop().Distance;
+			const float* Feature = &Features[EntryIdx * NumFeatures];
+			float Distance = 0.f;
+			for (int32 Dim = 0; Dim < NumFeatures && Distance < Worst; ++Dim)
+			{
+				const float Diff = Query[Dim] - Feature[Dim];
+				Distance += Diff * Diff;
+			}
+			if (Distance >= Worst)
+			{
+				continue;
+			}
+
+			if (Heap.Num() == K)
+			{
+				Heap.HeapPopDiscard(BVHPoseIndex::FartherFirst, false);
+			}
+			Heap.HeapPush(FBVHPoseMatch{ Entries[EntryIdx].X, Entries[EntryIdx].Y, Distance }, BVHPoseIndex::FartherFirst);
+		}
+		return;
+	}
+
+	const float Diff = Query[Node.SplitDim] - Node.SplitValue;
+	SearchNode(Diff < 0.f ? Node.Left : Node.Right, Query, K, Heap);
+	if (Heap.Num() < K || Diff * Diff < Heap.HeapTop().Distance)
+	{
+		SearchNode(Diff < 0.f ? Node.Right : Node.Left, Query, K, Heap);
+	}
+}
+
+void FBVHPoseIndex::FindNearest(const float* Query, int32 K, TArray<FBVHPoseMatch>& OutMatches) const
+{
+	OutMatches.Reset(K);
+	if (Nodes.Num() == 0 || K <= 0)
+	{
+		return;
+	}
+
+	SearchNode(0, Query, K, OutMatches);
+	OutMatches.Sort([](const FBVHPoseMatch& A, const FBVHPoseMatch& B) { return A.Distance < B.Distance; });
+	for (FBVHPoseMatch& Match : OutMatches)
+	{
+		Match.Distance = FMath::Sqrt(Match.Distance);
+	}
+}
+
+void FBVHPoseIndex::FindNearestMany(const float* Queries, int32 NumQueries, int32 K, TArray<FBVHPoseMatch>& OutMatches) const
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Queries matching fewer than K frames keep invalid matches at the end of their row
+	OutMatches.Reset();
+	if (K <= 0)
+	{
+		return;
+	}
+	OutMatches.SetNum(NumQueries * K);
+	ParallelFor(NumQueries, [&](int32 QueryIdx)
+	{
+		TArray<FBVHPoseMatch> Matches;
+		FindNearest(&Queries[QueryIdx * GetNumFeatures()], K, Matches);
+		FMemory::Memcpy(&OutMatches[QueryIdx * K], Matches.GetData(), Matches.Num() * sizeof(FBVHPoseMatch));
+	});
+
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogBVHPoseIndex, Verbose, TEXT("%d queries of %d neighbours in %.3f ms, %.1f us per query"),
+		NumQueries, K, Seconds * 1000.0, NumQueries > 0 ? Seconds * 1000000.0 / NumQueries : 0.0);
+}
+
+void FBVHPoseIndex::Serialize(FArchive& Ar)
+{
+	Ar << Settings << SourceHash << Mean << InvDeviation;
+	Entries.BulkSerialize(Ar);
+	Features.BulkSerialize(Ar);
+	Ar << Nodes;
+}
+
+bool FBVHPoseIndex::Save(const FString& IndexFilename)
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*IndexFilename));
+	if (!Writer)
+	{
+		UE_LOG(LogBVHPoseIndex, Error, TEXT("Failed to create %s."), *IndexFilename);
+		return false;
+	}
+
+	uint32 FileMagic = BVHPoseIndex::Magic;
+	uint32 FileVersion = BVHPoseIndex::Version;
+	*Writer << FileMagic << FileVersion;
+	Serialize(*Writer);
+	return Writer->Close();
+}
+
+bool FBVHPoseIndex::Load(const FString& IndexFilename)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*IndexFilename));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	*Reader << FileMagic << FileVersion;
+	if (FileMagic != BVHPoseIndex::Magic || FileVersion != BVHPoseIndex::Version)
+	{
+		UE_LOG(LogBVHPoseIndex, Warning, TEXT("%s is not a pose index of version %u."), *IndexFilename, BVHPoseIndex::Version);
+		return false;
+	}
+
+	Serialize(*Reader);
+	const int32 NumFeatures = GetNumFeatures();
+	if (Reader->IsError() || Mean.Num() != NumFeatures || InvDeviation.Num() != NumFeatures || Features.Num() != Entries.Num() * NumFeatures
+		|| Nodes.ContainsByPredicate([this](const FNode& Node) { return !IsValidNode(Node); }))
+	{
+		UE_LOG(LogBVHPoseIndex, Warning, TEXT("%s is corrupt."), *IndexFilename);
+		Entries.Reset();
+		Features.Reset();
+		Nodes.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FBVHPoseIndex::LoadOrBuild(const FString& IndexFilename, const TArray<const FBVHFile*>& Clips, const FBVHPoseFeatureSettings& InSettings)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	if (Load(IndexFilename) && SourceHash == HashSource(Clips, InSettings))
+	{
+		UE_LOG(LogBVHPoseIndex, Log, TEXT("Loaded the pose index of %d frames from %s in %.2f ms"), Entries.Num(), *IndexFilename, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+		return true;
+	}
+
+	if (!Build(Clips, InSettings))
+	{
+		return false;
+	}
+	if (!Save(IndexFilename))
+	{
+		UE_LOG(LogBVHPoseIndex, Warning, TEXT("Failed to save the pose index to %s, it is rebuilt next time."), *IndexFilename);
+	}
+	return true;
+}
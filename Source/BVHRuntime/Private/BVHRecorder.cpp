@@ -0,0 +1,233 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHRecorder.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "ReferenceSkeleton.h"
+
+#include "BVHAnimExporter.h"
+#include "BVHCoreAdapter.h"
+#include "BVHStream.h"
+#include "BVHTextBuffer.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogBVHRecorder, Log, All);
+
+namespace BVHRecorder
+{
+	/** Characters reserved for the frame count, patched when the recording stops */
+	static const int32 FrameCountWidth = 10;
+
+	/** Frame text is handed to the file in chunks of about this size */
+	static const size_t FlushSize = 64 * 1024;
+}
+
+FBVHRecorder::FBVHRecorder()
+	: bStopRequested(false)
+{
+}
+
+FBVHRecorder::~FBVHRecorder()
+{
+	StopRecording();
+}
+
+bool FBVHRecorder::StartRecording(const FString& Filename, const FReferenceSkeleton& RefSkeleton, float FrameTime, int32 MaxQueuedFrames, int32 InPrecision, const TBitArray<>* TranslatedBones)
+{
+	StopRecording();
+
+	NumBones = RefSkeleton.GetNum();
+	if (NumBones == 0 || FrameTime <= 0.f || MaxQueuedFrames < 1)
+	{
+		return false;
+	}
+
+	// The frame count is patched in place, which a deflate stream cannot do
+	if (FBVHOutputFile::IsCompressedName(TCHAR_TO_ANSI(*Filename)))
+	{
+		UE_LOG(LogBVHRecorder, Error, TEXT("Cannot record to compressed file %s, record to a .bvh file instead"), *Filename);
+		return false;
+	}
+
+	Precision = InPrecision;
+	Hierarchy = MakeUnique<FBVHFile>(TCHAR_TO_ANSI(*Filename));
+	FBVHAnimExporter::BuildHierarchy(RefSkeleton, FPaths::GetBaseFilename(Filename), *Hierarchy, TranslatedBones);
+
+	File = MakeUnique<FBVHOutputFile>();
+	if (!File->Open(TCHAR_TO_ANSI(*Filename)))
+	{
+		UE_LOG(LogBVHRecorder, Error, TEXT("Failed to open %s for recording"), *Filename);
+		Reset();
+		return false;
+	}
+
+	Text = MakeUnique<FBVHTextBuffer>();
+	Text->Reserve(BVHRecorder::FlushSize * 2);
+	ChannelOrder.clear();
+	Hierarchy->FormatHierarchy(*Text, ChannelOrder, Precision);
+	Text->Append("MOTION\n");
+	Text->Append("Frames: ");
+	File->Write(Text->GetData(), Text->GetSize());
+	Text->Clear();
+
+	FrameCountOffset = File->Tell();
+	Text->Append('0');
+	Text->AppendSpaces(BVHRecorder::FrameCountWidth - 1);
+	Text->Append('\n');
+	Text->Append("Frame Time: ");
+	Text->AppendFixed(FrameTime, Precision);
+	Text->Append('\n');
+	FlushText();
+
+	FrameValues.SetNumZeroed(Hierarchy->GetNumChannel());
+	NumWrittenFrames = 0;
+	bWriteFailed = false;
+	NumFrames = 0;
+	NumDroppedFrames = 0;
+
+	// All the memory of the recording is allocated here
+	Slots.SetNum(MaxQueuedFrames);
+	FreeSlots = MakeUnique<TCircularQueue<int32>>(MaxQueuedFrames + 1);
+	QueuedSlots = MakeUnique<TCircularQueue<int32>>(MaxQueuedFrames + 1);
+	for (int32 SlotIdx = 0; SlotIdx < MaxQueuedFrames; ++SlotIdx)
+	{
+		Slots[SlotIdx].SetNumUninitialized(NumBones);
+		FreeSlots->Enqueue(SlotIdx);
+	}
+
+	bStopRequested = false;
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("BVHRecorder"), 0, TPri_BelowNormal);
+	if (Thread == nullptr)
+	{
+		File->Close();
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FBVHRecorder::AddFrame(const TArray<FTransform>& BoneSpaceTransforms)
+{
+	if (Thread == nullptr || BoneSpaceTransforms.Num() != NumBones)
+	{
+		return false;
+	}
+
+	int32 SlotIdx;
+	if (!FreeSlots->Dequeue(SlotIdx))
+	{
+		++NumDroppedFrames;
+		return false;
+	}
+
+	FMemory::Memcpy(Slots[SlotIdx].GetData(), BoneSpaceTransforms.GetData(), NumBones * sizeof(FTransform));
+	QueuedSlots->Enqueue(SlotIdx);
+	WorkEvent->Trigger();
+
+	++NumFrames;
+	return true;
+}
+
+bool FBVHRecorder::StopRecording()
+{
+	if (Thread == nullptr)
+	{
+		return false;
+	}
+
+	Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	// Same layout as the placeholder, the count is left aligned and padded with spaces
+	FBVHTextBuffer FrameCount;
+	FrameCount.AppendInt(NumWrittenFrames);
+	FrameCount.AppendSpaces(BVHRecorder::FrameCountWidth - (int)FrameCount.GetSize());
+
+	bool bSuccess = !bWriteFailed && File->Overwrite(FrameCountOffset, FrameCount.GetData(), FrameCount.GetSize());
+	bSuccess = File->Close() && bSuccess;
+	if (!bSuccess)
+	{
+		UE_LOG(LogBVHRecorder, Error, TEXT("Failed to write the recorded frames"));
+	}
+	if (NumDroppedFrames > 0)
+	{
+		UE_LOG(LogBVHRecorder, Warning, TEXT("Recording dropped %d of %d frames, increase the number of queued frames"), NumDroppedFrames, NumFrames + NumDroppedFrames);
+	}
+
+	Reset();
+	return bSuccess;
+}
+
+void FBVHRecorder::Reset()
+{
+	if (WorkEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+	}
+	Slots.Empty();
+	FreeSlots.Reset();
+	QueuedSlots.Reset();
+	Text.Reset();
+	File.Reset();
+	Hierarchy.Reset();
+	FrameValues.Empty();
+	FrameCountOffset = -1;
+}
+
+uint32 FBVHRecorder::Run()
+{
+	for (;;)
+	{
+		int32 SlotIdx;
+		while (QueuedSlots->Dequeue(SlotIdx))
+		{
+			WriteFrame(Slots[SlotIdx]);
+			FreeSlots->Enqueue(SlotIdx);
+		}
+		FlushText();
+
+		// Frames queued before the stop request are visible once the request is
+		if (bStopRequested && QueuedSlots->IsEmpty())
+		{
+			break;
+		}
+		WorkEvent->Wait(100);
+	}
+	return 0;
+}
+
+void FBVHRecorder::Stop()
+{
+	bStopRequested = true;
+	WorkEvent->Trigger();
+}
+
+void FBVHRecorder::WriteFrame(const TArray<FTransform>& Pose)
+{
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+	{
+		BVHCoreAdapter::TransformToChannels(*Hierarchy, BoneIdx, Pose[BoneIdx], FrameValues.GetData());
+	}
+	FBVHFile::FormatFrame(*Text, FrameValues.GetData(), ChannelOrder, Precision);
+	++NumWrittenFrames;
+
+	if (Text->GetSize() >= BVHRecorder::FlushSize)
+	{
+		FlushText();
+	}
+}
+
+void FBVHRecorder::FlushText()
+{
+	if (Text->GetSize() > 0)
+	{
+		bWriteFailed |= !File->Write(Text->GetData(), Text->GetSize());
+		Text->Clear();
+	}
+}
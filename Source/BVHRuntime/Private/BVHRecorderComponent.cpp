@@ -0,0 +1,96 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHRecorderComponent.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "GameFramework/Actor.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(BVHRecorderComponent)
+
+UBVHRecorderComponent::UBVHRecorderComponent()
+	: FrameRate(30.f)
+	, MaxQueuedFrames(256)
+	, Precision(6)
+	, FrameTime(0.0)
+	, TimeToNextFrame(0.0)
+{
+	// Record the pose evaluated this frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+bool UBVHRecorderComponent::StartRecording(const FString& Filename)
+{
+	if (SkeletalMesh == nullptr && GetOwner())
+	{
+		SkeletalMesh = GetOwner()->FindComponentByClass<USkeletalMeshComponent>();
+	}
+	if (SkeletalMesh == nullptr || SkeletalMesh->GetSkeletalMeshAsset() == nullptr || FrameRate <= 0.f)
+	{
+		return false;
+	}
+
+	const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetSkeletalMeshAsset()->GetRefSkeleton();
+	TBitArray<> TranslatedBoneBits(false, RefSkeleton.GetNum());
+	for (const FName& BoneName : TranslatedBones)
+	{
+		const int32 BoneIdx = RefSkeleton.FindBoneIndex(BoneName);
+		if (BoneIdx != INDEX_NONE)
+		{
+			TranslatedBoneBits[BoneIdx] = true;
+		}
+	}
+
+	if (!Recorder.StartRecording(Filename, RefSkeleton, 1.f / FrameRate, MaxQueuedFrames, Precision, &TranslatedBoneBits))
+	{
+		return false;
+	}
+
+	FrameTime = 1.0 / FrameRate;
+	TimeToNextFrame = 0.0;
+	AddTickPrerequisiteComponent(SkeletalMesh);
+	SetComponentTickEnabled(true);
+	return true;
+}
+
+bool UBVHRecorderComponent::StopRecording()
+{
+	if (!Recorder.IsRecording())
+	{
+		return false;
+	}
+
+	SetComponentTickEnabled(false);
+	if (SkeletalMesh)
+	{
+		RemoveTickPrerequisiteComponent(SkeletalMesh);
+	}
+	return Recorder.StopRecording();
+}
+
+void UBVHRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!Recorder.IsRecording() || SkeletalMesh == nullptr)
+	{
+		return;
+	}
+
+	const TArray<FTransform>& Pose = SkeletalMesh->GetBoneSpaceTransforms();
+	TimeToNextFrame -= DeltaTime;
+	while (TimeToNextFrame <= 0.0)
+	{
+		Recorder.AddFrame(Pose);
+		TimeToNextFrame += FrameTime;
+	}
+}
+
+void UBVHRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,40 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "BVHRuntime.h"
+
+#include "Async/ParallelFor.h"
+
+#include "BVHCore.h"
+#include "BVHLiveSender.h"
+#include "BVHStats.h"
+
+#define LOCTEXT_NAMESPACE "FBVHRuntimeModule"
+
+DEFINE_STAT(STAT_BVHOpenFile);
+DEFINE_STAT(STAT_BVHConvertTracks);
+DEFINE_STAT(STAT_BVHMirrorTracks);
+DEFINE_STAT(STAT_BVHImportAnimation);
+DEFINE_STAT(STAT_BVHPopulateSequence);
+DEFINE_STAT(STAT_BVHSetBoneTrackKeys);
+DEFINE_STAT(STAT_BVHPostEditChange);
+DEFINE_STAT(STAT_BVHMotionMemory);
+DEFINE_STAT(STAT_BVHTrackMemory);
+
+void FBVHRuntimeModule::StartupModule()
+{
+	// The parallel loops of the core run on the task graph instead of their own threads
+	FBVHCore::SetParallelFor([](int Num, const std::function<void(int)>& Body, bool bForceSingleThread)
+	{
+		ParallelFor(Num, [&Body](int32 Index) { Body(Index); }, bForceSingleThread);
+	});
+}
+
+void FBVHRuntimeModule::ShutdownModule()
+{
+	FBVHLiveSender::StopConsoleSender();
+	FBVHCore::SetParallelFor(nullptr);
+}
+
+#undef LOCTEXT_NAMESPACE
+	
+IMPLEMENT_MODULE(FBVHRuntimeModule, BVHRuntime)
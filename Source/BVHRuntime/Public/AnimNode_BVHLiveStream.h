@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+
+#include "BVHLiveSource.h"
+#include "AnimNode_BVHLiveStream.generated.h"
+
+UENUM(BlueprintType)
+enum class EBVHLiveSampling : uint8
+{
+	/** Newest received frame, the lowest latency */
+	Newest,
+	/** Blend of the two frames around the current time minus InterpolationDelay, smooth when frames arrive unevenly */
+	Interpolated,
+};
+
+/**
+* Outputs the pose received by an FBVHLiveSource.
+* Joints are matched to bones by name, bones without a joint keep their reference pose.
+*/
+USTRUCT(BlueprintInternalUseOnly)
+struct BVHRUNTIME_API FAnimNode_BVHLiveStream : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Stream)
+	EBVHLiveProtocol Protocol = EBVHLiveProtocol::Tcp;
+
+	/** Address of the sender, TCP only */
+	UPROPERTY(EditAnywhere, Category = Stream)
+	FString Host = TEXT("127.0.0.1");
+
+	UPROPERTY(EditAnywhere, Category = Stream, meta = (ClampMin = "1", ClampMax = "65535"))
+	int32 Port = 7001;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stream, meta = (PinHiddenByDefault))
+	EBVHLiveSampling Sampling = EBVHLiveSampling::Newest;
+
+	/** Frames the interpolated pose is behind the newest one, one frame hides the jitter of a local network */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Stream, meta = (ClampMin = "0", PinHiddenByDefault))
+	float InterpolationDelay = 1.0f;
+
+	//~ Begin FAnimNode_Base Interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	//~ End FAnimNode_Base Interface
+
+private:
+	/** Matches the joints of the stream to the required bones, only when the stream or the bones change */
+	void MapJoints(const FBoneContainer& RequiredBones);
+
+	/** Reads the frame shown at Time into FrameA, and FrameB with its blend weight when interpolating */
+	bool ReadFrames(double Time, float& OutAlpha);
+
+	TSharedPtr<FBVHLiveSource> Source;
+	TSharedPtr<const FBVHLiveStream> Stream;
+	uint32 StreamGeneration = 0;
+
+	/** Compact pose index of each joint, invalid for joints without a bone */
+	TArray<FCompactPoseBoneIndex> JointBones;
+	uint16 MappedBonesSerial = 0;
+	bool bJointsMapped = false;
+
+	/** Channel values of the sampled frames, sized with the stream */
+	TArray<double> FrameA;
+	TArray<double> FrameB;
+};
@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+
+#include "BVHPoseCache.h"
+#include "AnimNode_BVHMotionPlayer.generated.h"
+
+class FBVHFile;
+class UBVHMotionAsset;
+
+/**
+* Plays a UBVHMotionAsset without importing it.
+* Only the frames around the play time are evaluated, and only for the joints matching a required bone, the last few
+* evaluated frames are kept for scrubbing. Bones without a joint keep their reference pose.
+*/
+USTRUCT(BlueprintInternalUseOnly)
+struct BVHRUNTIME_API FAnimNode_BVHMotionPlayer : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinShownByDefault))
+	TObjectPtr<UBVHMotionAsset> Motion = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault))
+	float PlayRate = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault))
+	bool bLoop = true;
+
+	/** Time the motion starts from when the node initializes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault, ClampMin = "0"))
+	float StartPosition = 0.f;
+
+	/** Plays ExplicitTime instead of advancing with the delta time, e.g. to scrub a take */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault))
+	bool bUseExplicitTime = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (PinHiddenByDefault, ClampMin = "0"))
+	float ExplicitTime = 0.f;
+
+	/** Evaluated frames kept by the node */
+	UPROPERTY(EditAnywhere, Category = Settings, meta = (ClampMin = "2", UIMax = "64"))
+	int32 CachedPoses = 8;
+
+	//~ Begin FAnimNode_Base Interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	//~ End FAnimNode_Base Interface
+
+	float GetCurrentTime() const { return CurrentTime; }
+
+private:
+	/** Picks the file of Motion up once it is loaded or reloaded */
+	void UpdateFile();
+
+	/** Matches the joints of the file to the required bones, only when the file or the bones change */
+	void MapJoints(const FBoneContainer& RequiredBones);
+
+	TSharedPtr<const FBVHFile> BvhFile;
+	FBVHPoseCache PoseCache;
+	float CurrentTime = 0.f;
+
+	/** Compact pose index of each joint, and the joints evaluated */
+	TArray<FCompactPoseBoneIndex> JointBones;
+	TBitArray<> JointMask;
+	uint16 MappedBonesSerial = 0;
+	bool bJointsMapped = false;
+};
@@ -0,0 +1,124 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimSequence.h"
+
+#include "BVHConversionSettings.h"
+
+class FBVHFile;
+class FBVHImportContext;
+struct FReferenceSkeleton;
+
+/** Converted keys for a single bone of the target skeleton */
+struct FBVHConvertedTrack
+{
+	FName BoneName;
+	FRawAnimSequenceTrack RawTrack;
+};
+
+/**
+* Result of parsing and converting one BVH file.
+* Produced on any thread, committed to a UAnimSequence on the game thread.
+*/
+struct BVHRUNTIME_API FBVHConvertedAnimation
+{
+	/** Settings the animation was converted with */
+	FBVHImportSnapshot Settings;
+
+	FString SourceFilename;
+	int64 SourceSize = 0;
+
+	TArray<FBVHConvertedTrack> Tracks;
+
+	/** Number of keys of every track, the length of the converted frame range */
+	int32 NumKeys = 0;
+
+	/** Source content hash of every bone found in the skeleton, including the ones whose conversion was skipped */
+	TMap<FName, uint32> TrackHashes;
+
+	/** Time spent in FBVHFile::Open() and in the conversion loop, in seconds */
+	double ParseSeconds = 0.0;
+	double ConvertSeconds = 0.0;
+
+	/** True when the tracks came from the Derived Data Cache */
+	bool bFromCache = false;
+
+	/** True when this is one of several clips cut from the file, see UBVHImportSettings::Clips */
+	bool bIsClip = false;
+
+	/** Tracks of the mirrored animation, one per track of Tracks, only filled when Settings.bCreateMirrored is set */
+	TArray<FBVHConvertedTrack> MirroredTracks;
+
+	/** True for the animation made by FBVHAnimConverter::MakeMirroredAnimation() */
+	bool bIsMirrored = false;
+
+	/** Memory held by the keys of Tracks and MirroredTracks */
+	SIZE_T GetTrackBytes() const;
+};
+
+class BVHRUNTIME_API FBVHAnimConverter
+{
+public:
+	/**
+	* Converts every joint of an opened BVH file that exists in the reference skeleton into raw bone tracks.
+	* Only reads its inputs, so it can run on worker threads.
+	*
+	* @param UnchangedHashes - Hashes of a previous import, joints whose hash still matches are not converted
+	*/
+	static bool Convert(const FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation, const TMap<FName, uint32>* UnchangedHashes = nullptr);
+
+	/**
+	* Fills MirroredTracks from Tracks: each bone gets the keys of its mirror bone reflected through the plane of Settings.MirrorAxis.
+	* BVH joints have no rest rotation, so reflecting the local keys mirrors the whole pose. Tracks are mirrored in parallel.
+	*/
+	static void MirrorTracks(FBVHConvertedAnimation& Animation);
+
+	/** Animation holding the MirroredTracks of a converted animation, named after it with MirroredSuffix */
+	static void MakeMirroredAnimation(const FBVHConvertedAnimation& Animation, FBVHConvertedAnimation& OutMirrored);
+
+	static const TCHAR* MirroredSuffix;
+
+	/** Drops the converted tracks whose hash matches a previous import */
+	static void RemoveUnchangedTracks(FBVHConvertedAnimation& Animation, const TMap<FName, uint32>& PreviousHashes);
+
+	/**
+	* Converts several frame ranges of one parsed file in parallel, each into its own animation.
+	* All clips share the motion buffer of BvhFile and a single joint to bone mapping.
+	*/
+	static bool ConvertClips(const FBVHFile& BvhFile, const FString& SourceFilename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, const TArray<FBVHClipRange>& Clips, TArray<FBVHConvertedAnimation>& OutAnimations);
+
+	/** Hashes the offset, channel layout and motion values of a joint over a range of frames */
+	static uint32 HashJointTrack(const FBVHFile& BvhFile, int32 JointIdx, int32 FirstFrame, int32 LastFrame);
+
+	/** Resolves the skeleton bone of every joint, NAME_None for joints the skeleton does not have. Cached for hierarchies shared by several files */
+	static void MapJointsToBones(const FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, TArray<FName>& OutBoneNames);
+
+	/**
+	* Convert() with an already resolved joint to bone mapping.
+	* The tracks already in OutAnimation are rewritten in place, an animation converted again keeps its key arrays.
+	*/
+	static bool ConvertMapped(const FBVHFile& BvhFile, const TArray<FName>& BoneNames, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation, const TMap<FName, uint32>* UnchangedHashes = nullptr);
+
+	/**
+	* Converts a file opened with FBVHFile::OpenStreaming(), reading it window by window into the bone tracks.
+	* The motion of the whole file is never held, memory is the converted tracks plus one window. Track hashes match HashJointTrack().
+	*/
+	static bool ConvertWindows(FBVHFile& BvhFile, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation);
+
+	/** Opens a file for streaming and converts it with settings whose per-file fields are already filled in */
+	static bool ConvertStreaming(const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& Settings, FBVHConvertedAnimation& OutAnimation);
+
+	/** Frames decoded at once by the streaming conversion */
+	static const int32 StreamingWindowFrames = 4096;
+
+	/**
+	* Opens a BVH file and converts it, streaming it when Settings.ShouldStream() its size. The per-file fields of the settings are taken from the file,
+	* the shared ones (skeleton, sampling) from InSettings.
+	*/
+	static bool ConvertFile(const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation);
+
+	/** ConvertFile() parsing into the file of a context, whose motion buffer is reused from the previous file */
+	static bool ConvertFile(FBVHImportContext& Context, const FString& Filename, const FReferenceSkeleton& RefSkeleton, const FBVHImportSnapshot& InSettings, FBVHConvertedAnimation& OutAnimation);
+};
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBVHFile;
+class UAnimSequence;
+struct FReferenceSkeleton;
+
+/**
+* Writes skeletal animation as BVH, the inverse of FBVHAnimConverter.
+* Every bone of the reference skeleton becomes a joint, channel values follow the axis and sign conventions of FBVHFile::GetTransform().
+* Sequences are read from their editor-only animation data model, so exporting sequences is only available in the editor.
+*/
+class BVHRUNTIME_API FBVHAnimExporter
+{
+public:
+	/**
+	* Builds joints and channels for every bone of a reference skeleton.
+	* The root bone and the bones set in TranslatedBones record position and rotation, the other bones rotation only.
+	*/
+	static void BuildHierarchy(const FReferenceSkeleton& RefSkeleton, const FString& MotionName, FBVHFile& OutFile, const TBitArray<>* TranslatedBones = nullptr);
+
+#if WITH_EDITOR
+	/** Bones whose translation is animated somewhere in the sequence, they need position channels */
+	static TBitArray<> FindTranslatedBones(const UAnimSequence* Sequence, const FReferenceSkeleton& RefSkeleton);
+
+	/**
+	* Samples every key of the sequence into the motion of a file made by BuildHierarchy(), blocks of frames are sampled in parallel.
+	* Bones without a track keep their reference pose. Only reads the sequence, so it can run on worker threads.
+	*/
+	static bool SampleSequence(const UAnimSequence* Sequence, const FReferenceSkeleton& RefSkeleton, FBVHFile& OutFile);
+
+	/** Builds the hierarchy of the sequence skeleton and samples the sequence into OutFile */
+	static bool MakeFile(const UAnimSequence* Sequence, FBVHFile& OutFile);
+
+	/** Writes a sequence to a .bvh file, or to a gzip compressed one when the name ends with .gz */
+	static bool ExportToFile(const UAnimSequence* Sequence, const FString& Filename, int32 Precision = 6);
+
+	/** Writes a sequence as BVH text into an archive */
+	static bool ExportToArchive(const UAnimSequence* Sequence, FArchive& Ar, int32 Precision = 6);
+#endif // WITH_EDITOR
+};
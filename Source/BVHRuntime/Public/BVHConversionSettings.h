@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BVHConversionSettings.generated.h"
+
+UENUM(BlueprintType)
+enum class EEulerOrder : uint8
+{
+	None = 0 UMETA(Hidden),
+	ZXY = 1,
+};
+
+UENUM(BlueprintType)
+enum class EBVHSamplingType : uint8
+{
+	PerFrame,	
+	PerXFrames UMETA(DisplayName = "Per X Frames"),
+	PerTimeStep
+};
+
+/** A named range of frames imported as its own animation */
+USTRUCT(BlueprintType)
+struct FBVHClipRange
+{
+	GENERATED_BODY()
+
+	/** Name of the animation created for this clip, defaults to the motion name with the clip index appended */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Clip)
+	FString Name;
+
+	/** First frame of the clip */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Clip, meta = (ClampMin = "0"))
+	int32 FrameStart = 0;
+
+	/** Last frame of the clip, inclusive */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Clip, meta = (ClampMin = "0"))
+	int32 FrameEnd = 0;
+};
+
+class FBVHFile;
+
+/**
+* Plain copy of the import settings taken before an import starts.
+* Unlike UBVHImportSettings it is never shared between imports, so it is safe to read from worker threads.
+*/
+struct BVHRUNTIME_API FBVHImportSnapshot
+{
+	/** Skeleton the animation is imported onto, only dereferenced on the game thread */
+	class USkeleton* Skeleton = nullptr;
+
+	EBVHSamplingType SamplingType = EBVHSamplingType::PerFrame;
+	FString MotionName;
+	float TimeStep = 0.0f;
+	int32 FrameNum = 0;
+	int32 FrameStart = 0;
+	int32 FrameEnd = 0;
+	int32 ResampleRate = DEFAULT_SAMPLERATE;
+	bool bUseDerivedDataCache = true;
+
+	/** Files of at least this many megabytes are converted window by window without holding their motion, 0 never streams */
+	int32 StreamingThresholdMB = 512;
+
+	/** Also converts a left/right mirrored animation, see FBVHAnimConverter::MirrorTracks() */
+	bool bCreateMirrored = false;
+
+	/** Normal of the mirror plane */
+	EAxis::Type MirrorAxis = EAxis::X;
+
+	/** Bones swapped by the mirror, in either direction. Bones not listed swap Left and Right in their name */
+	TMap<FName, FName> MirrorBonePairs;
+
+	/** True when a file of this size is converted with FBVHAnimConverter::ConvertStreaming() */
+	bool ShouldStream(int64 FileSize) const { return StreamingThresholdMB > 0 && FileSize >= (int64)StreamingThresholdMB * 1024 * 1024; }
+
+	/** Fills in the per-file fields (name, frame range and timing) from an opened BVH file */
+	void ApplyFile(const FBVHFile& BvhFile);
+
+	/** Hash of the fields that change the key layout of every track (frame range and timing) */
+	uint32 GetSamplingHash() const;
+
+	/** Clamps FrameStart/FrameEnd to the frames of a file, an end before the start selects up to the last frame */
+	void GetFrameRange(int32 NumFrames, int32& OutFirstFrame, int32& OutLastFrame) const;
+};
@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "BVHFile.h"
+
+/** Conversions between the math types of the engine independent core (Core/Public) and the engine ones */
+namespace BVHCoreAdapter
+{
+	FORCEINLINE FVector ToVector(const FBVHVector& Vector)
+	{
+		return FVector(Vector.X, Vector.Y, Vector.Z);
+	}
+
+	FORCEINLINE FQuat ToQuat(const FBVHQuat& Quat)
+	{
+		return FQuat(Quat.X, Quat.Y, Quat.Z, Quat.W);
+	}
+
+	FORCEINLINE FTransform ToTransform(const FBVHTransform& Transform)
+	{
+		return FTransform(ToQuat(Transform.Rotation), ToVector(Transform.Translation));
+	}
+
+	FORCEINLINE FBVHTransform FromTransform(const FTransform& Transform)
+	{
+		const FQuat Rotation = Transform.GetRotation();
+		const FVector Translation = Transform.GetTranslation();
+		return FBVHTransform(FBVHQuat(Rotation.X, Rotation.Y, Rotation.Z, Rotation.W), FBVHVector(Translation.X, Translation.Y, Translation.Z));
+	}
+
+	/** Local transform of a joint at a frame of the file, see FBVHFile::GetTransform() */
+	FORCEINLINE FTransform GetTransform(const FBVHFile& BvhFile, int32 Frame, int32 JointIdx)
+	{
+		return ToTransform(BvhFile.GetTransform(Frame, JointIdx));
+	}
+
+	/** Same as above for a frame of GetNumChannel() values held outside of the file */
+	FORCEINLINE FTransform GetTransform(const FBVHFile& BvhFile, const double* FrameValues, int32 JointIdx)
+	{
+		return ToTransform(BvhFile.GetTransform(FrameValues, JointIdx));
+	}
+
+	/** Writes the channel values of a joint into a frame, see FBVHFile::TransformToChannels() */
+	FORCEINLINE void TransformToChannels(const FBVHFile& BvhFile, int32 JointIdx, const FTransform& Transform, double* FrameValues)
+	{
+		BvhFile.TransformToChannels(JointIdx, FromTransform(Transform), FrameValues);
+	}
+}
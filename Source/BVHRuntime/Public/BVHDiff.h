@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBVHFile;
+
+/** Tolerances of a diff, a value of a channel differs when it is off by more than the tolerance of the channel */
+struct FBVHDiffSettings
+{
+	/** Joint offsets and end sites */
+	double OffsetTolerance = 1e-4;
+
+	/** Xposition..Zposition channels, in file units */
+	double PositionTolerance = 1e-3;
+
+	/** Xrotation..Zrotation channels, in degrees */
+	double RotationTolerance = 1e-3;
+
+	/** Overrides of the tolerances above, keyed by "Joint.Channel", e.g. "Hips.Yposition" */
+	TMap<FString, double> ChannelTolerances;
+
+	/** Channels and frames reported in WorstChannels and WorstFrames */
+	int32 NumWorst = 10;
+};
+
+/** Largest difference of a channel, errors are absolute, Score is the error divided by the tolerance. A NaN on either side is an infinite error */
+struct FBVHChannelDiff
+{
+	FString Name;
+	int32 Channel = INDEX_NONE;
+	double MaxError = 0.0;
+	double Score = 0.0;
+	int32 WorstFrame = INDEX_NONE;
+	int32 NumFramesOver = 0;
+	int32 NumFramesNaN = 0;
+};
+
+/** Largest score of any channel at a frame */
+struct FBVHFrameDiff
+{
+	int32 Frame = INDEX_NONE;
+	double Score = 0.0;
+	FString WorstChannel;
+};
+
+struct FBVHDiffResult
+{
+	/** Hierarchy and timing differences, one readable line each */
+	TArray<FString> StructuralDifferences;
+
+	/** Channels whose values differ by more than their tolerance at some frame, the most different first */
+	TArray<FBVHChannelDiff> WorstChannels;
+	TArray<FBVHFrameDiff> WorstFrames;
+
+	int32 NumChannelsCompared = 0;
+	int32 NumChannelsOver = 0;
+	int32 NumChannelsNaN = 0;
+	int32 NumFramesCompared = 0;
+
+	bool IsEqual() const { return StructuralDifferences.Num() == 0 && NumChannelsOver == 0; }
+};
+
+/**
+* Compares two BVH files structurally (joint names, parents, offsets, channel order) and numerically (motion, per channel tolerance),
+* so that files written with another precision or layout still compare equal. Channels are matched by joint name and type,
+* a reordered channel is reported as a structural difference and its values are still compared.
+*/
+class BVHRUNTIME_API FBVHDiff
+{
+public:
+	/** Frames of a block compared by one task */
+	static const int32 FramesPerBlock = 1024;
+
+	/** Compares two loaded files, returns Result.IsEqual() */
+	static bool Compare(const FBVHFile& A, const FBVHFile& B, const FBVHDiffSettings& Settings, FBVHDiffResult& OutResult);
+
+	/** Loads and compares two files, false with an error when either fails to load, OutResult tells whether they differ */
+	static bool CompareFiles(const FString& FilenameA, const FString& FilenameB, const FBVHDiffSettings& Settings, FBVHDiffResult& OutResult);
+
+	/** "Joint.Channel" name of a channel of a file */
+	static FString GetChannelName(const FBVHFile& File, int32 ChannelIdx);
+
+private:
+	static void CompareHierarchies(const FBVHFile& A, const FBVHFile& B, const FBVHDiffSettings& Settings, TArray<int32>& OutChannelMap, FBVHDiffResult& OutResult);
+};
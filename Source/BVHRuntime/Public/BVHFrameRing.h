@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/**
+* Fixed ring of channel value frames written by one thread and read by any number of others.
+* The writer never waits: it overwrites the oldest slot, and a reader that was copying that slot sees it in Read()'s result
+* and takes a newer frame instead. Every slot has a sequence number, odd while the writer fills it and 2 * (FrameIndex + 1)
+* once frame FrameIndex is in it, a copy is only accepted when the slot held the frame before and after it. All the memory is allocated by Init().
+*/
+class FBVHFrameRing
+{
+public:
+	void Init(int32 InNumChannels, int32 InCapacity)
+	{
+		NumChannels = InNumChannels;
+		Capacity = FMath::Max(InCapacity, 2);
+		Values.SetNumZeroed(NumChannels * Capacity);
+		Times.SetNumZeroed(Capacity);
+		Sequences = MakeUnique<std::atomic<int64>[]>(Capacity);
+		for (int32 Slot = 0; Slot < Capacity; ++Slot)
+		{
+			Sequences[Slot].store(0, std::memory_order_relaxed);
+		}
+		NumWritten.store(0, std::memory_order_relaxed);
+	}
+
+	int32 GetNumChannels() const { return NumChannels; }
+	int32 GetCapacity() const { return Capacity; }
+
+	/** Writer only: values of the next frame, published by EndWrite() */
+	double* BeginWrite()
+	{
+		const int64 FrameIndex = NumWritten.load(std::memory_order_relaxed);
+		const int32 Slot = FrameIndex % Capacity;
+
+		// Readers of the frame the slot held see the odd sequence before any of the new values
+		Sequences[Slot].store(2 * FrameIndex + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		return &Values[Slot * NumChannels];
+	}
+
+	void EndWrite(double Time)
+	{
+		const int64 FrameIndex = NumWritten.load(std::memory_order_relaxed);
+		const int32 Slot = FrameIndex % Capacity;
+		Times[Slot] = Time;
+		Sequences[Slot].store(GetSequence(FrameIndex), std::memory_order_release);
+		NumWritten.store(FrameIndex + 1, std::memory_order_release);
+	}
+
+	/** Frames written so far, the newest one is GetNumWritten() - 1 */
+	int64 GetNumWritten() const
+	{
+		return NumWritten.load(std::memory_order_acquire);
+	}
+
+	/** Copies a frame, false when it was overwritten before or during the copy */
+	bool Read(int64 FrameIndex, double* OutValues, double& OutTime) const
+	{
+		const int64 NumFrames = GetNumWritten();
+		if (FrameIndex < 0 || FrameIndex >= NumFrames || NumFrames - FrameIndex >= Capacity)
+		{
+			return false;
+		}
+
+		const int32 Slot = FrameIndex % Capacity;
+		const int64 Sequence = GetSequence(FrameIndex);
+		if (Sequences[Slot].load(std::memory_order_acquire) != Sequence)
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(OutValues, &Values[Slot * NumChannels], NumChannels * sizeof(double));
+		OutTime = Times[Slot];
+
+		// The writer changes the sequence before its first store into the slot
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return Sequences[Slot].load(std::memory_order_relaxed) == Sequence;
+	}
+
+	/** Time of a frame, same rules as Read() */
+	bool ReadTime(int64 FrameIndex, double& OutTime) const
+	{
+		const int64 NumFrames = GetNumWritten();
+		if (FrameIndex < 0 || FrameIndex >= NumFrames || NumFrames - FrameIndex >= Capacity)
+		{
+			return false;
+		}
+
+		const int32 Slot = FrameIndex % Capacity;
+		const int64 Sequence = GetSequence(FrameIndex);
+		if (Sequences[Slot].load(std::memory_order_acquire) != Sequence)
+		{
+			return false;
+		}
+
+		OutTime = Times[Slot];
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return Sequences[Slot].load(std::memory_order_relaxed) == Sequence;
+	}
+
+private:
+	/** Sequence of a slot holding frame FrameIndex, never 0 so a slot that was never written matches no frame */
+	static int64 GetSequence(int64 FrameIndex) { return 2 * (FrameIndex + 1); }
+
+	TArray<double> Values;
+	TArray<double> Times;
+	TUniquePtr<std::atomic<int64>[]> Sequences;
+	int32 NumChannels = 0;
+	int32 Capacity = 0;
+	std::atomic<int64> NumWritten{ 0 };
+};
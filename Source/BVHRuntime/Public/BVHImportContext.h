@@ -0,0 +1,60 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBVHFile;
+
+/**
+* Scratch memory of the files converted one after the other on a thread: the parsed file with its motion buffer and read blocks,
+* and the joint to bone mapping. Both are kept between files and only grow, so a batch allocates them for its largest file only.
+* Contexts are borrowed from a pool shared by the imports, see FBVHScopedImportContext. Not thread safe, one thread uses a context at a time.
+*/
+class BVHRUNTIME_API FBVHImportContext
+{
+public:
+	FBVHImportContext();
+	~FBVHImportContext();
+
+	/** Reopened for every file through FBVHFile::SetFileName() */
+	FBVHFile& GetBvhFile() { return *BvhFile; }
+
+	TArray<FName>& GetBoneNames() { return BoneNames; }
+
+	/** Memory held by the motion buffer, counted in STAT_BVHMotionMemory while the context lives */
+	SIZE_T GetMotionBytes() const;
+
+	/** A free context of the pool, or a new one when all of them are in use */
+	static TUniquePtr<FBVHImportContext> Acquire();
+
+	/** Gives a context back to the pool for the next file */
+	static void Release(TUniquePtr<FBVHImportContext> Context);
+
+	/** Frees the contexts waiting in the pool, once a batch is done */
+	static void Trim();
+
+private:
+	TUniquePtr<FBVHFile> BvhFile;
+	TArray<FName> BoneNames;
+};
+
+/** Borrows a context of the pool for the lifetime of the scope */
+class FBVHScopedImportContext
+{
+public:
+	FBVHScopedImportContext()
+		: Context(FBVHImportContext::Acquire())
+	{
+	}
+
+	~FBVHScopedImportContext()
+	{
+		FBVHImportContext::Release(MoveTemp(Context));
+	}
+
+	FBVHImportContext& Get() { return *Context; }
+
+private:
+	TUniquePtr<FBVHImportContext> Context;
+};
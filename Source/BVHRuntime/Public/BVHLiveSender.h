@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+#include "BVHLiveSource.h"
+
+#include <atomic>
+
+class FBVHFile;
+class FInternetAddr;
+class FRunnableThread;
+class FSocket;
+
+/**
+* Plays a BVH file to a socket in the text format FBVHLiveSource receives, looping at the frame rate of the file.
+* Meant for testing live streams without a capture stage, also from the console:
+* BVH.LiveSend <File> [Port] [Udp] [Host] and BVH.LiveStop.
+*/
+class BVHRUNTIME_API FBVHLiveSender : private FRunnable
+{
+public:
+	FBVHLiveSender();
+	virtual ~FBVHLiveSender();
+
+	/**
+	* Starts sending a file.
+	* With TCP the sender listens on Port and serves one receiver at a time, with UDP it sends datagrams to Host:Port.
+	*/
+	bool StartSending(const FString& Filename, EBVHLiveProtocol InProtocol, int32 InPort, const FString& InHost = TEXT("127.0.0.1"));
+	void StopSending();
+
+	bool IsSending() const { return Thread != nullptr; }
+
+	/** Stops the sender started by the console command */
+	static void StopConsoleSender();
+
+private:
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+	bool OpenSocket();
+	void CloseSockets();
+
+	/** Closes the socket of the current receiver, the TCP listener stays open */
+	void CloseConnection();
+
+	/** Sends the whole text, as datagrams ending on line breaks with UDP */
+	bool SendText(const char* Data, int32 Size);
+
+	TUniquePtr<FBVHFile> BvhFile;
+	EBVHLiveProtocol Protocol = EBVHLiveProtocol::Tcp;
+	FString Host;
+	int32 Port = 0;
+
+	/** Header text, and the column order of the frame lines */
+	TArray<char> Header;
+	std::vector<int> ChannelOrder;
+
+	FSocket* Listener = nullptr;
+	FSocket* Socket = nullptr;
+	TSharedPtr<FInternetAddr> Address;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopRequested;
+};
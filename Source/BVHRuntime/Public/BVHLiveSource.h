@@ -0,0 +1,105 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+
+#include "BVHFrameRing.h"
+
+#include <atomic>
+
+#include "BVHLiveSource.generated.h"
+
+class FBVHFile;
+class FRunnableThread;
+class FSocket;
+
+UENUM(BlueprintType)
+enum class EBVHLiveProtocol : uint8
+{
+	/** Connects to a sender listening on Host:Port, and reconnects when the connection drops */
+	Tcp,
+	/** Receives datagrams sent to Port, Host is ignored */
+	Udp,
+};
+
+/** Hierarchy of a live stream and the frames received for it */
+struct FBVHLiveStream
+{
+	/** Joints and channels parsed from the HIERARCHY text, holds no motion */
+	TSharedPtr<FBVHFile> Hierarchy;
+
+	/** Frame time announced by the sender */
+	double FrameTime = 0.0;
+
+	/** Received frames, the times are FPlatformTime::Seconds() smoothed over the network jitter */
+	FBVHFrameRing Frames;
+};
+
+/**
+* Receives BVH text on a socket: a HIERARCHY and MOTION header, then one frame line after another.
+* The header is parsed once with FBVHFile::ParseHeader(), frame lines are decoded on the receive thread straight into
+* the ring of the current stream, so a frame costs no allocation. A new header with a different hierarchy starts a new stream.
+*/
+class BVHRUNTIME_API FBVHLiveSource : private FRunnable
+{
+public:
+	/** Frames kept per stream, the oldest one is overwritten by a new frame */
+	static const int32 DefaultCapacity = 32;
+
+	FBVHLiveSource(EBVHLiveProtocol InProtocol, const FString& InHost, int32 InPort, int32 InCapacity = DefaultCapacity);
+	virtual ~FBVHLiveSource();
+
+	/** Source shared by every reader of the same endpoint, started on first use and stopped with its last reader, whose release never waits for the receive thread */
+	static TSharedPtr<FBVHLiveSource> FindOrCreate(EBVHLiveProtocol Protocol, const FString& Host, int32 Port);
+
+	bool Start();
+
+	/** Stream of the last received header, null until one is received */
+	TSharedPtr<const FBVHLiveStream> GetStream() const;
+
+	/** Incremented each time GetStream() changes, cheap to poll every frame */
+	uint32 GetGeneration() const { return Generation.load(std::memory_order_acquire); }
+
+	bool IsConnected() const { return bConnected; }
+
+private:
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+	bool OpenSocket();
+	void CloseSocket();
+
+	/** Splits received bytes into lines, a datagram always ends its last line */
+	void ReceiveData(const uint8* Data, int32 Size, bool bEndsLine);
+	void ReceiveLine(char* Line, int32 Length);
+	void EndHeader();
+	void DecodeFrame(const char* Line);
+
+	EBVHLiveProtocol Protocol;
+	FString Host;
+	int32 Port;
+	int32 Capacity;
+
+	FSocket* Socket = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopRequested;
+	std::atomic<bool> bConnected;
+
+	/** Receive thread only: bytes of an incomplete line, and the header being received */
+	TArray<char> PendingLine;
+	TArray<char> HeaderText;
+	int32 HierarchyLength = 0;
+	bool bInHeader = false;
+	double LastFrameTime = 0.0;
+
+	/** Swapped by the receive thread under StreamLock, the previous stream stays valid for its readers */
+	TSharedPtr<FBVHLiveStream> Stream;
+	TArray<char> StreamHierarchy;
+	mutable FCriticalSection StreamLock;
+	std::atomic<uint32> Generation;
+};
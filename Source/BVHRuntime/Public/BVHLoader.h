@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+class FBVHFile;
+
+/** Receives a loaded file on the game thread, null when the file could not be parsed */
+DECLARE_DELEGATE_OneParam(FOnBVHFileLoaded, TSharedPtr<FBVHFile> /*BvhFile*/);
+
+/**
+* Loads BVH files without blocking the calling thread, e.g. to open large clips at runtime without a hitch.
+* Parsing runs on the thread pool.
+*/
+class BVHRUNTIME_API FBVHLoader
+{
+public:
+	/** Parses a file on a worker thread, the future holds null when the file could not be parsed */
+	static TFuture<TSharedPtr<FBVHFile>> LoadAsync(const FString& Filename);
+
+	/** Parses a file on a worker thread and executes OnLoaded on the game thread */
+	static void LoadAsync(const FString& Filename, FOnBVHFileLoaded OnLoaded);
+
+	/** Parses a file on the calling thread */
+	static TSharedPtr<FBVHFile> Load(const FString& Filename);
+};
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "HAL/CriticalSection.h"
+#include "UObject/Object.h"
+
+#include "BVHMotionAsset.generated.h"
+
+class FBVHFile;
+
+/**
+* A BVH take played without importing it: the source file is parsed when the asset loads and poses are evaluated
+* by FAnimNode_BVHMotionPlayer for the frames being played only. Reviewing a take costs a parse instead of an import and compression.
+*/
+UCLASS(BlueprintType)
+class BVHRUNTIME_API UBVHMotionAsset : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/** The .bvh or .bvh.gz file, relative paths are relative to the project directory */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Motion, meta = (FilePathFilter = "BVH files (*.bvh;*.bvh.gz)|*.bvh;*.bvh.gz", RelativeToGameDir))
+	FFilePath SourceFile;
+
+	/** Parsed file, null until loaded or when the file cannot be parsed. Safe to call from any thread */
+	TSharedPtr<const FBVHFile> GetFile() const;
+
+	/** Parses SourceFile on a worker thread, GetFile() returns the previous file until it is done */
+	UFUNCTION(BlueprintCallable, Category = "BVH|Motion")
+	void Reload();
+
+	/** Parses SourceFile on the calling thread */
+	bool LoadNow();
+
+	UFUNCTION(BlueprintPure, Category = "BVH|Motion")
+	float GetPlayLength() const;
+
+	UFUNCTION(BlueprintPure, Category = "BVH|Motion")
+	int32 GetNumFrames() const;
+
+	FString GetSourceFilename() const;
+
+	//~ Begin UObject Interface
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	//~ End UObject Interface
+
+private:
+	void SetFile(TSharedPtr<FBVHFile> InFile);
+
+	TSharedPtr<const FBVHFile> File;
+	mutable FCriticalSection FileLock;
+};
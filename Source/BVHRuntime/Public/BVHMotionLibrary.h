@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "BVHFile.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/** A take of a motion library: one source file, its hierarchy and where its channel columns start */
+struct FBVHLibraryTake
+{
+	FString SourceFilename;
+	FString MotionName;
+	int32 Hierarchy = INDEX_NONE;
+	int32 NumFrames = 0;
+	double FrameTime = 0.0;
+
+	/** First block of the take in the block directory, each channel holds GetNumBlocks() blocks, channel after channel */
+	int32 FirstBlock = 0;
+
+	int32 GetNumBlocks() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FBVHLibraryTake& Take);
+};
+
+/** Frames of a take matching a query, LastFrame included */
+struct FBVHLibraryRange
+{
+	int32 Take = INDEX_NONE;
+	int32 FirstFrame = 0;
+	int32 LastFrame = 0;
+};
+
+/**
+* Motion of many BVH takes in one file, to query thousands of takes without parsing any of them.
+* Every take refers to one of the distinct hierarchies of the library, and stores each channel as a column
+* of compressed blocks of BlockFrames frames. The file is memory mapped, a query only reads the blocks of
+* the channels and frames it asks for.
+*
+* Reading is thread safe once Open() returned.
+*/
+class BVHRUNTIME_API FBVHMotionLibrary
+{
+public:
+	/** Frames of a column block, the granularity of the reads */
+	static const int32 BlockFrames = 2048;
+
+	/** Parses the files in parallel, BatchSize at a time, and writes their motion to LibraryFilename. Unreadable files are skipped with an error */
+	static bool Build(const TArray<FString>& Filenames, const FString& LibraryFilename, int32 BatchSize = 64);
+
+	FBVHMotionLibrary();
+	~FBVHMotionLibrary();
+
+	/** Maps a library and reads its directory, the motion is only read by the queries */
+	bool Open(const FString& LibraryFilename);
+	void Close();
+
+	bool IsOpen() const { return MappedRegion != nullptr; }
+
+	int32 GetNumTakes() const { return Takes.Num(); }
+	const FBVHLibraryTake& GetTake(int32 TakeIdx) const { return Takes[TakeIdx]; }
+
+	/** Joints and channels shared by takes, GetNumFrame() is 0 */
+	int32 GetNumHierarchies() const { return Hierarchies.Num(); }
+	const FBVHFile& GetHierarchy(int32 HierarchyIdx) const { return *Hierarchies[HierarchyIdx]; }
+
+	/** Column of a channel of a joint, INDEX_NONE when the hierarchy of the take does not have it */
+	int32 FindChannel(int32 TakeIdx, const FString& JointName, ChannelEnum Type) const;
+
+	/** Decodes NumFrames values of a column starting at FirstFrame, only the blocks holding these frames are read */
+	bool ReadChannel(int32 TakeIdx, int32 ChannelIdx, int32 FirstFrame, int32 NumFrames, double* OutValues) const;
+
+	/**
+	* Frame ranges of every take where Predicate holds for a channel of a joint, e.g. the hips dropping below a height.
+	* Takes are searched in parallel, Predicate is called from several threads.
+	*/
+	void FindFrames(const FString& JointName, ChannelEnum Type, TFunctionRef<bool(double)> Predicate, TArray<FBVHLibraryRange>& OutRanges) const;
+
+private:
+	struct FBlock
+	{
+		uint64 Offset = 0;
+		uint32 CompressedSize = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FBlock& Block)
+		{
+			return Ar << Block.Offset << Block.CompressedSize;
+		}
+	};
+
+	bool ReadBlock(const FBlock& Block, int32 NumValues, TArray<uint8>& Scratch, double* OutValues) const;
+
+	IMappedFileHandle* MappedFile;
+	IMappedFileRegion* MappedRegion;
+
+	TArray<TUniquePtr<FBVHFile>> Hierarchies;
+	TArray<FBVHLibraryTake> Takes;
+	TArray<FBlock> Blocks;
+};
@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBVHFile;
+
+/**
+* The last few frames evaluated from an FBVHFile, so scrubbing back and forth or blending two frames does not evaluate a frame twice.
+* Only the joints set in the mask are evaluated. Not thread safe, each reader owns its cache.
+*/
+class BVHRUNTIME_API FBVHPoseCache
+{
+public:
+	/** Empties the cache, e.g. when the file or the joint mask changes */
+	void Reset(int32 InNumJoints, int32 NumEntries = 8);
+
+	/** Local transforms of the joints of a frame, indexed by joint, joints not in JointMask are left at identity */
+	const TArray<FTransform>& GetPose(const FBVHFile& BvhFile, int32 Frame, const TBitArray<>& JointMask);
+
+	int32 GetNumHits() const { return NumHits; }
+	int32 GetNumMisses() const { return NumMisses; }
+
+private:
+	struct FEntry
+	{
+		int32 Frame = INDEX_NONE;
+		uint32 LastUse = 0;
+		TArray<FTransform> Pose;
+	};
+
+	TArray<FEntry> Entries;
+	int32 NumJoints = 0;
+	uint32 UseCounter = 0;
+	int32 NumHits = 0;
+	int32 NumMisses = 0;
+};
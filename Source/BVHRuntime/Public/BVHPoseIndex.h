@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FBVHFile;
+
+/** Pose features extracted from every frame, in the space of the root joint of the frame */
+struct FBVHPoseFeatureSettings
+{
+	/** Joints whose features are extracted, every clip of the index needs them */
+	TArray<FString> JointNames;
+
+	bool bPositions = true;
+	bool bVelocities = true;
+
+	int32 GetNumFeatures() const { return JointNames.Num() * 3 * ((bPositions ? 1 : 0) + (bVelocities ? 1 : 0)); }
+
+	friend FArchive& operator<<(FArchive& Ar, FBVHPoseFeatureSettings& Settings)
+	{
+		return Ar << Settings.JointNames << Settings.bPositions << Settings.bVelocities;
+	}
+};
+
+/** A frame found by a query, Distance is in normalized feature units */
+struct FBVHPoseMatch
+{
+	int32 Clip = INDEX_NONE;
+	int32 Frame = INDEX_NONE;
+	float Distance = 0.f;
+};
+
+/**
+* Nearest pose search over the frames of BVH clips, e.g. for motion matching.
+* Features come from forward kinematics on the clips, are normalized per dimension and stored in a KD-tree,
+* queries run in batches on the task graph. Thread safe for queries once built or loaded.
+*/
+class BVHRUNTIME_API FBVHPoseIndex
+{
+public:
+	/** Extracts the features of every frame of the clips and builds the tree, false when a clip lacks a joint of the settings */
+	bool Build(const TArray<const FBVHFile*>& Clips, const FBVHPoseFeatureSettings& InSettings);
+
+	/** Loads the index saved for the same clips and settings, or builds and saves it */
+	bool LoadOrBuild(const FString& IndexFilename, const TArray<const FBVHFile*>& Clips, const FBVHPoseFeatureSettings& InSettings);
+
+	bool Save(const FString& IndexFilename);
+	bool Load(const FString& IndexFilename);
+
+	/** Normalized features of a frame of a clip, GetNumFeatures() values, the query of FindNearest() */
+	bool ExtractFeatures(const FBVHFile& Clip, int32 Frame, float* OutFeatures) const;
+
+	/** K nearest frames of a query, closest first */
+	void FindNearest(const float* Query, int32 K, TArray<FBVHPoseMatch>& OutMatches) const;
+
+	/** K nearest frames of NumQueries queries of GetNumFeatures() values each, OutMatches receives K matches per query */
+	void FindNearestMany(const float* Queries, int32 NumQueries, int32 K, TArray<FBVHPoseMatch>& OutMatches) const;
+
+	int32 GetNumFeatures() const { return Settings.GetNumFeatures(); }
+	int32 GetNumEntries() const { return Entries.Num(); }
+	double GetBuildSeconds() const { return BuildSeconds; }
+
+private:
+	struct FNode
+	{
+		/** Entries of the node, contiguous in Entries and Features */
+		int32 Begin = 0;
+		int32 End = 0;
+
+		/** Children, INDEX_NONE for leaves */
+		int32 Left = INDEX_NONE;
+		int32 Right = INDEX_NONE;
+
+		int32 SplitDim = 0;
+		float SplitValue = 0.f;
+
+		friend FArchive& operator<<(FArchive& Ar, FNode& Node)
+		{
+			return Ar << Node.Begin << Node.End << Node.Left << Node.Right << Node.SplitDim << Node.SplitValue;
+		}
+	};
+
+	/** Identifies the clips and settings an index was built from, motion included */
+	static uint32 HashSource(const TArray<const FBVHFile*>& Clips, const FBVHPoseFeatureSettings& InSettings);
+
+	/** Poses of the frames extracted last, see BVHPoseIndex.cpp */
+	struct FPoseCache;
+
+	/** Raw features of a frame, JointIndices are the joints of the settings in the clip. Cache holds its neighbours when the previous frame was extracted before */
+	void ExtractRawFeatures(const FBVHFile& Clip, int32 ClipIdx, const TArray<int32>& JointIndices, int32 Frame, FPoseCache& Cache, float* OutFeatures) const;
+
+	bool FindJoints(const FBVHFile& Clip, TArray<int32>& OutJointIndices) const;
+
+	int32 BuildNode(int32 Begin, int32 End, TArray<int32>& Order, const TArray<float>& RawFeatures);
+
+	/** Range checks of a loaded node, children must exist and come after it */
+	bool IsValidNode(const FNode& Node) const;
+
+	void SearchNode(int32 NodeIdx, const float* Query, int32 K, TArray<FBVHPoseMatch>& Heap) const;
+
+	void Serialize(FArchive& Ar);
+
+	FBVHPoseFeatureSettings Settings;
+	uint32 SourceHash = 0;
+
+	/** Per dimension normalization, feature = (raw - Mean) * InvDeviation */
+	TArray<float> Mean;
+	TArray<float> InvDeviation;
+
+	/** Clip and frame of every entry, in tree order */
+	TArray<FIntPoint> Entries;
+	TArray<float> Features;
+	TArray<FNode> Nodes;
+
+	double BuildSeconds = 0.0;
+};
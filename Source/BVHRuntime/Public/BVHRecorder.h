@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include "HAL/Runnable.h"
+
+#include <atomic>
+#include <vector>
+
+class FBVHFile;
+class FBVHOutputFile;
+class FBVHTextBuffer;
+class FEvent;
+class FRunnableThread;
+struct FReferenceSkeleton;
+
+/**
+* Streams local bone poses to a BVH file while they are produced.
+* AddFrame() only copies the pose into a preallocated slot and queues the slot, a writer thread
+* converts queued poses to channel values and appends them to the file. The slots bound the memory
+* of a recording of any length, a frame arriving while every slot waits for the writer is dropped.
+*/
+class BVHRUNTIME_API FBVHRecorder : private FRunnable
+{
+public:
+	FBVHRecorder();
+	virtual ~FBVHRecorder();
+
+	/**
+	* Writes the hierarchy of the reference skeleton and starts the writer thread.
+	* Every bone records its rotation, the root and the bones set in TranslatedBones also their position.
+	*/
+	bool StartRecording(const FString& Filename, const FReferenceSkeleton& RefSkeleton, float FrameTime, int32 MaxQueuedFrames = 256, int32 Precision = 6, const TBitArray<>* TranslatedBones = nullptr);
+
+	/** Queues the bone space transforms of one frame, in reference skeleton order. False when the frame was dropped */
+	bool AddFrame(const TArray<FTransform>& BoneSpaceTransforms);
+
+	/** Writes the queued frames, patches the frame count of the header and closes the file */
+	bool StopRecording();
+
+	bool IsRecording() const { return Thread != nullptr; }
+
+	/** Frames queued since the recording started, and frames dropped because the writer fell behind */
+	int32 GetNumFrames() const { return NumFrames; }
+	int32 GetNumDroppedFrames() const { return NumDroppedFrames; }
+
+private:
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+	void WriteFrame(const TArray<FTransform>& Pose);
+	void FlushText();
+	void Reset();
+
+	/** Joints and channels of the recorded skeleton, no motion is kept in it */
+	TUniquePtr<FBVHFile> Hierarchy;
+	TUniquePtr<FBVHOutputFile> File;
+
+	/** Writer thread only: text of the frames not written yet, channel values of the current frame */
+	TUniquePtr<FBVHTextBuffer> Text;
+	std::vector<int> ChannelOrder;
+	TArray<double> FrameValues;
+	int32 NumWrittenFrames = 0;
+	bool bWriteFailed = false;
+
+	/** Pose slots, their indices move from FreeSlots to QueuedSlots on the game thread and back on the writer thread */
+	TArray<TArray<FTransform>> Slots;
+	TUniquePtr<TCircularQueue<int32>> FreeSlots;
+	TUniquePtr<TCircularQueue<int32>> QueuedSlots;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WorkEvent = nullptr;
+	std::atomic<bool> bStopRequested;
+
+	/** Offset of the frame count in the file, rewritten once the count is known */
+	long FrameCountOffset = -1;
+
+	int32 NumBones = 0;
+	int32 Precision = 6;
+	int32 NumFrames = 0;
+	int32 NumDroppedFrames = 0;
+};
@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "BVHRecorder.h"
+#include "BVHRecorderComponent.generated.h"
+
+class USkeletalMeshComponent;
+
+/**
+* Records the pose of a skeletal mesh to a BVH file while the game runs.
+* Each recorded frame costs the game thread one copy of the bone space transforms, the file is written by FBVHRecorder on its own thread.
+*/
+UCLASS(ClassGroup = Animation, meta = (BlueprintSpawnableComponent))
+class BVHRUNTIME_API UBVHRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UBVHRecorderComponent();
+
+	/** Mesh whose pose is recorded, the first skeletal mesh of the owner when not set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recording)
+	TObjectPtr<USkeletalMeshComponent> SkeletalMesh;
+
+	/** Frames written per second, hitches repeat the last pose so the file keeps real time */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recording, meta = (ClampMin = "1", UIMax = "240"))
+	float FrameRate;
+
+	/** Poses waiting for the writer thread, all the memory of a recording of any length */
+	UPROPERTY(EditAnywhere, Category = Recording, meta = (ClampMin = "1"))
+	int32 MaxQueuedFrames;
+
+	/** Bones recording their translation besides the root, e.g. the pelvis of a skeleton with a root bone */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Recording)
+	TArray<FName> TranslatedBones;
+
+	/** Decimals of the written channel values */
+	UPROPERTY(EditAnywhere, Category = Recording, meta = (ClampMin = "1", ClampMax = "15"))
+	int32 Precision;
+
+	/** Starts writing the pose of SkeletalMesh to a .bvh file */
+	UFUNCTION(BlueprintCallable, Category = "BVH|Recording")
+	bool StartRecording(const FString& Filename);
+
+	/** Finishes the file, waiting for the queued frames to be written */
+	UFUNCTION(BlueprintCallable, Category = "BVH|Recording")
+	bool StopRecording();
+
+	UFUNCTION(BlueprintPure, Category = "BVH|Recording")
+	bool IsRecording() const { return Recorder.IsRecording(); }
+
+	UFUNCTION(BlueprintPure, Category = "BVH|Recording")
+	int32 GetNumRecordedFrames() const { return Recorder.GetNumFrames(); }
+
+	UFUNCTION(BlueprintPure, Category = "BVH|Recording")
+	int32 GetNumDroppedFrames() const { return Recorder.GetNumDroppedFrames(); }
+
+	//~ Begin UActorComponent Interface
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//~ End UActorComponent Interface
+
+private:
+	FBVHRecorder Recorder;
+
+	/** Frame time of the running recording, and seconds left until its next frame is due */
+	double FrameTime;
+	double TimeToNextFrame;
+};
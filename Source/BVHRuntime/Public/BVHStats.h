@@ -0,0 +1,24 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/**
+* Phases of a BVH import, shown by "stat BVH". Cycle stats also emit CPU events to Unreal Insights,
+* the parsing done by the core shows there under its BVHFile_ events.
+*/
+DECLARE_STATS_GROUP(TEXT("BVH"), STATGROUP_BVH, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Open File"), STAT_BVHOpenFile, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Convert Tracks"), STAT_BVHConvertTracks, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mirror Tracks"), STAT_BVHMirrorTracks, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Import Animation"), STAT_BVHImportAnimation, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Populate Sequence"), STAT_BVHPopulateSequence, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Set Bone Track Keys"), STAT_BVHSetBoneTrackKeys, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Post Edit Change"), STAT_BVHPostEditChange, STATGROUP_BVH, BVHRUNTIME_API);
+
+/** Motion buffers of the opened files, and keys of the converted tracks waiting to be committed */
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Motion Memory"), STAT_BVHMotionMemory, STATGROUP_BVH, BVHRUNTIME_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Track Memory"), STAT_BVHTrackMemory, STATGROUP_BVH, BVHRUNTIME_API);
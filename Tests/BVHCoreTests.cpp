@@ -0,0 +1,515 @@
+//
+//  Native tests of the BVH core, run by ctest: save round trip, transform conversion, streaming read, hierarchy cache, gzip files and sampling.
+//  Each test reads the sample take of testdata and a synthetic file.
+//
+//  Usage: BVHCoreTests <testdata dir> <temp dir>
+//
+
+#include "BVHFile.h"
+#include "BVHStream.h"
+
+#include "BVHSyntheticFile.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+	int  num_failures = 0;
+
+	void  Check(bool condition, const char* test, const std::string& what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "%s: %s\n", test, what.c_str());
+			num_failures++;
+		}
+	}
+
+	bool  SaveToText(FBVHFile& file, std::string& text)
+	{
+		FBVHOutputFile  output;
+		text.clear();
+		return  output.Open([&text](const char* data, size_t size) { text.append(data, size); return  true; })
+			&& file.Save(output) && output.Close();
+	}
+
+	bool  WriteText(const std::string& file_name, const std::string& text)
+	{
+		FILE*  file = fopen(file_name.c_str(), "wb");
+		if (file == NULL)
+		{
+			return  false;
+		}
+		const bool  is_success = fwrite(text.data(), 1, text.size(), file) == text.size();
+		return  fclose(file) == 0 && is_success;
+	}
+
+	bool  HasSameMotion(const FBVHFile& a, const FBVHFile& b)
+	{
+		if (a.GetNumFrame() != b.GetNumFrame() || a.GetNumChannel() != b.GetNumChannel() || a.GetInterval() != b.GetInterval())
+		{
+			return  false;
+		}
+		for (int f = 0; f < a.GetNumFrame(); f++)
+		{
+			for (int c = 0; c < a.GetNumChannel(); c++)
+			{
+				if (a.GetMotion(f, c) != b.GetMotion(f, c))
+				{
+					return  false;
+				}
+			}
+		}
+		return  true;
+	}
+
+	bool  HasSameHierarchy(const FBVHFile& a, const FBVHFile& b)
+	{
+		if (a.GetNumJoint() != b.GetNumJoint() || a.GetNumChannel() != b.GetNumChannel())
+		{
+			return  false;
+		}
+		for (int j = 0; j < a.GetNumJoint(); j++)
+		{
+			const Joint*  ja = a.GetJoint(j);
+			const Joint*  jb = b.GetJoint(j);
+			if (ja->name != jb->name || ja->index != jb->index || ja->has_site != jb->has_site || ja->channels.size() != jb->channels.size()
+				|| (ja->parent ? ja->parent->index : -1) != (jb->parent ? jb->parent->index : -1))
+			{
+				return  false;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				if (ja->offset[k] != jb->offset[k] || (ja->has_site && ja->site[k] != jb->site[k]))
+				{
+					return  false;
+				}
+			}
+		}
+		for (int c = 0; c < a.GetNumChannel(); c++)
+		{
+			if (a.GetChannel(c)->type != b.GetChannel(c)->type || a.GetChannel(c)->joint->index != b.GetChannel(c)->joint->index)
+			{
+				return  false;
+			}
+		}
+		return  true;
+	}
+
+	// Save() normalizes the formatting, so the text it writes must come back unchanged through a parse and another save
+	void  TestSaveRoundTrip(const std::string& source, const std::string& temp_name)
+	{
+		const char*  test = "save round trip";
+		FBVHFile     file(source.c_str());
+		std::string  first;
+		std::string  second;
+		if (!file.Open() || !SaveToText(file, first) || !WriteText(temp_name, first))
+		{
+			Check(false, test, "cannot open or save " + source);
+			return;
+		}
+
+		FBVHFile  saved(temp_name.c_str());
+		if (!saved.Open() || !SaveToText(saved, second))
+		{
+			Check(false, test, "cannot reopen or save " + temp_name);
+			return;
+		}
+		Check(first == second, test, "saved text of " + source + " changes through a parse");
+		Check(HasSameHierarchy(file, saved), test, "hierarchy of " + source + " changes through a save");
+	}
+
+	// GetTransform() of the channels written by TransformToChannels() gives the transform back
+	void  TestTransformInverse(const std::string& source)
+	{
+		const char*  test = "transform inverse";
+		FBVHFile     file(source.c_str());
+		if (!file.Open())
+		{
+			Check(false, test, "cannot open " + source);
+			return;
+		}
+
+		const double  tolerance = 1e-9;
+		std::vector< double >  frame(file.GetNumChannel());
+		int  num_errors = 0;
+		for (int f = 0; f < file.GetNumFrame(); f++)
+		{
+			for (int j = 0; j < file.GetNumJoint(); j++)
+			{
+				const FBVHTransform  expected = file.GetTransform(f, j);
+				std::fill(frame.begin(), frame.end(), 0.0);
+				file.TransformToChannels(j, expected, frame.data());
+				const FBVHTransform  actual = file.GetTransform(frame.data(), j);
+
+				// q and -q are the same rotation
+				const FBVHQuat&  qa = expected.GetRotation();
+				const FBVHQuat&  qb = actual.GetRotation();
+				const double  dot = qa.X * qb.X + qa.Y * qb.Y + qa.Z * qb.Z + qa.W * qb.W;
+				const FBVHVector&  ta = expected.GetTranslation();
+				const FBVHVector&  tb = actual.GetTranslation();
+				const bool  is_near = std::fabs(std::fabs(dot) - 1.0) <= tolerance && std::fabs(ta.X - tb.X) <= tolerance
+					&& std::fabs(ta.Y - tb.Y) <= tolerance && std::fabs(ta.Z - tb.Z) <= tolerance;
+				if (!is_near && num_errors++ == 0)
+				{
+					Check(false, test, source + ": joint " + file.GetJoint(j)->name + " differs at frame " + std::to_string(f));
+				}
+			}
+		}
+	}
+
+	// Windows of any size decode the same values as a whole file read
+	void  TestStreaming(const std::string& source)
+	{
+		const char*  test = "streaming";
+		FBVHFile     whole(source.c_str());
+		if (!whole.Open())
+		{
+			Check(false, test, "cannot open " + source);
+			return;
+		}
+
+		const int  window_sizes[] = { 1, 7, 256, whole.GetNumFrame() + 1 };
+		for (int window_frames : window_sizes)
+		{
+			FBVHFile  stream(source.c_str());
+			if (!stream.OpenStreaming(window_frames))
+			{
+				Check(false, test, "cannot stream " + source);
+				return;
+			}
+			Check(HasSameHierarchy(whole, stream) && stream.GetNumFrame() == whole.GetNumFrame(), test, source + ": header differs");
+
+			bool  is_same = true;
+			int   next_frame = 0;
+			for (int num = stream.ReadWindow(); num > 0 && is_same; num = stream.ReadWindow())
+			{
+				is_same = stream.GetWindowFirstFrame() == next_frame && stream.GetWindowNumFrame() == num;
+				for (int f = 0; f < num && is_same; f++)
+				{
+					for (int c = 0; c < whole.GetNumChannel(); c++)
+					{
+						is_same = is_same && stream.GetMotion(f, c) == whole.GetMotion(next_frame + f, c);
+					}
+				}
+				next_frame += num;
+			}
+			Check(is_same && next_frame == whole.GetNumFrame(), test,
+				source + ": windows of " + std::to_string(window_frames) + " frames differ from Open()");
+			stream.CloseStreaming();
+		}
+	}
+
+	// A second file with the same HIERARCHY text shares the parsed hierarchy, and reads the same as a fresh parse
+	void  TestHierarchyCache(const std::string& source, const std::string& copy_name)
+	{
+		const char*  test = "hierarchy cache";
+		std::error_code  error;
+		std::filesystem::copy_file(source, copy_name, std::filesystem::copy_options::overwrite_existing, error);
+		if (error)
+		{
+			Check(false, test, "cannot copy " + source);
+			return;
+		}
+
+		FBVHFile::ClearHierarchyCache();
+		FBVHFile  fresh(source.c_str());
+		const bool  is_fresh_open = fresh.Open();
+		FBVHFile::ClearHierarchyCache();
+
+		FBVHFile  first(source.c_str());
+		FBVHFile  cached(copy_name.c_str());
+		if (!is_fresh_open || !first.Open() || !cached.Open())
+		{
+			Check(false, test, "cannot open " + source);
+			return;
+		}
+		Check(FBVHFile::GetHierarchyCacheHits() == 1, test, source + ": the copy did not hit the cache");
+		Check(cached.GetHierarchy() == first.GetHierarchy(), test, source + ": the copy does not share the hierarchy");
+		Check(cached.GetHierarchy() != fresh.GetHierarchy(), test, source + ": the cache was not cleared");
+		Check(HasSameHierarchy(fresh, cached) && HasSameMotion(fresh, cached), test, source + ": the cached read differs from a fresh parse");
+		FBVHFile::ClearHierarchyCache();
+	}
+
+	// A file whose motion is cut short fails to read and leaves nothing in the cache for the next file of the rig
+	void  TestFailedReadNotCached(const std::string& source, const std::string& cut_name)
+	{
+		const char*  test = "hierarchy cache";
+		std::ifstream  input(source, std::ios::binary);
+		std::stringstream  text;
+		text << input.rdbuf();
+		const std::string  whole = text.str();
+		const size_t  frame_time = whole.find("Frame Time");
+		if (frame_time == std::string::npos || !WriteText(cut_name, whole.substr(0, whole.find('\n', frame_time) + 1)))
+		{
+			Check(false, test, "cannot cut " + source);
+			return;
+		}
+
+		FBVHFile::ClearHierarchyCache();
+		FBVHFile  cut(cut_name.c_str());
+		FBVHFile  file(source.c_str());
+		Check(!cut.Open(), test, cut_name + ": a file without frames reads");
+		Check(file.Open() && FBVHFile::GetHierarchyCacheHits() == 0, test, source + ": the hierarchy of a failed read was cached");
+		FBVHFile::ClearHierarchyCache();
+	}
+
+	std::string  ReadText(const std::string& file_name)
+	{
+		std::ifstream  input(file_name, std::ios::binary);
+		std::stringstream  text;
+		text << input.rdbuf();
+		return  text.str();
+	}
+
+	// A take saved to .bvh.gz reads back the same as its plain save, and compressed input is told by its magic bytes, not its name
+	void  TestCompressed(const std::string& source, const std::string& plain_name, const std::string& gz_name, const std::string& other_name)
+	{
+		const char*     test = "gzip";
+		FBVHFile        file(source.c_str());
+		std::string     text;
+		FBVHOutputFile  output;
+		if (!file.Open() || !SaveToText(file, text) || !WriteText(plain_name, text)
+			|| !output.Open(gz_name.c_str()) || !file.Save(output) || !output.Close())
+		{
+			Check(false, test, "cannot open or save " + source);
+			return;
+		}
+
+		const std::string  compressed = ReadText(gz_name);
+		Check(compressed.size() > 2 && (unsigned char)compressed[0] == 0x1f && (unsigned char)compressed[1] == 0x8b && compressed.size() < text.size(),
+			test, gz_name + ": the save is not compressed");
+
+		FBVHFile  plain(plain_name.c_str());
+		FBVHFile  inflated(gz_name.c_str());
+		if (!plain.Open() || !inflated.Open())
+		{
+			Check(false, test, "cannot reopen " + gz_name);
+			return;
+		}
+		Check(HasSameHierarchy(plain, inflated) && HasSameMotion(plain, inflated), test, source + ": the gzip save reads differently from the plain one");
+
+		// gzip bytes under a plain name, and plain text under a .gz name
+		FBVHLineReader  reader;
+		FBVHFile        renamed(other_name.c_str());
+		Check(WriteText(other_name, compressed) && reader.Open(other_name.c_str()) && reader.IsCompressed(), test, other_name + ": gzip bytes are not detected");
+		reader.Close();
+		Check(renamed.Open() && HasSameMotion(plain, renamed), test, other_name + ": gzip bytes under a plain name do not read");
+
+		FBVHFile  text_gz(gz_name.c_str());
+		Check(WriteText(gz_name, text) && reader.Open(gz_name.c_str()) && !reader.IsCompressed(), test, gz_name + ": plain text is taken for gzip");
+		reader.Close();
+		Check(text_gz.Open() && HasSameMotion(plain, text_gz), test, gz_name + ": plain text under a .gz name does not read");
+	}
+
+	// A gzip stream cut short or with damaged bytes fails to open instead of reading wrong or missing frames
+	void  TestCorruptCompressed(const std::string& source, const std::string& gz_name)
+	{
+		const char*     test = "gzip";
+		FBVHFile        file(source.c_str());
+		FBVHOutputFile  output;
+		if (!file.Open() || !output.Open(gz_name.c_str()) || !file.Save(output) || !output.Close())
+		{
+			Check(false, test, "cannot save " + source);
+			return;
+		}
+		const std::string  compressed = ReadText(gz_name);
+
+		// Halfway through the motion, just before the length at the end, and one flipped byte of data
+		std::string  damaged[3] = { compressed.substr(0, compressed.size() / 2), compressed.substr(0, compressed.size() - 4), compressed };
+		damaged[2][damaged[2].size() / 2] ^= 0x55;
+		const char*  what[3] = { "cut in half", "without its length", "with a flipped byte" };
+		for (int i = 0; i < 3; i++)
+		{
+			FBVHFile  broken(gz_name.c_str());
+			Check(WriteText(gz_name, damaged[i]) && !broken.Open(), test, gz_name + ": a stream " + what[i] + " reads");
+		}
+	}
+
+	bool  IsNear(const FBVHTransform& a, const FBVHTransform& b, double tolerance)
+	{
+		// q and -q are the same rotation
+		const FBVHQuat&    qa = a.GetRotation();
+		const FBVHQuat&    qb = b.GetRotation();
+		const double       dot = qa.X * qb.X + qa.Y * qb.Y + qa.Z * qb.Z + qa.W * qb.W;
+		const FBVHVector&  ta = a.GetTranslation();
+		const FBVHVector&  tb = b.GetTranslation();
+		return  std::fabs(std::fabs(dot) - 1.0) <= tolerance && std::fabs(ta.X - tb.X) <= tolerance
+			&& std::fabs(ta.Y - tb.Y) <= tolerance && std::fabs(ta.Z - tb.Z) <= tolerance;
+	}
+
+	// Sample() halfway between two frames, before the first and past the last frame, on a subset of the joints and through SampleMany()
+	void  TestSample(const std::string& source)
+	{
+		const char*  test = "sample";
+		FBVHFile     file(source.c_str());
+		if (!file.Open() || file.GetNumFrame() < 2)
+		{
+			Check(false, test, "cannot open " + source);
+			return;
+		}
+
+		const double  tolerance = 1e-9;
+		const int     num_joint = file.GetNumJoint();
+		const int     last = file.GetNumFrame() - 1;
+		const int     f = last / 2;
+		std::vector< FBVHTransform >  halfway(num_joint);
+		std::vector< FBVHTransform >  before(num_joint);
+		std::vector< FBVHTransform >  after(num_joint);
+		file.Sample((f + 0.5) * file.GetInterval(), NULL, num_joint, halfway.data());
+		file.Sample(-1.0, NULL, num_joint, before.data());
+		file.Sample((last + 10) * file.GetInterval(), NULL, num_joint, after.data());
+
+		int  num_errors = 0;
+		for (int j = 0; j < num_joint && num_errors == 0; j++)
+		{
+			// Midpoint of the shortest arc: the normalized sum of the two quaternions on the same side
+			const FBVHTransform  a = file.GetTransform(f, j);
+			const FBVHTransform  b = file.GetTransform(f + 1, j);
+			const FBVHQuat&      qa = a.GetRotation();
+			const FBVHQuat&      qb = b.GetRotation();
+			const double         sign = (qa.X * qb.X + qa.Y * qb.Y + qa.Z * qb.Z + qa.W * qb.W < 0.0) ? -1.0 : 1.0;
+			FBVHQuat             q(qa.X + sign * qb.X, qa.Y + sign * qb.Y, qa.Z + sign * qb.Z, qa.W + sign * qb.W);
+			const double         length = std::sqrt(q.X * q.X + q.Y * q.Y + q.Z * q.Z + q.W * q.W);
+			q = FBVHQuat(q.X / length, q.Y / length, q.Z / length, q.W / length);
+			const FBVHTransform  expected(q, FBVHVector::Lerp(a.GetTranslation(), b.GetTranslation(), 0.5));
+
+			if (!IsNear(halfway[j], expected, tolerance))
+			{
+				Check(false, test, source + ": joint " + file.GetJoint(j)->name + " is not interpolated halfway to frame " + std::to_string(f + 1));
+				num_errors++;
+			}
+			if (!IsNear(before[j], file.GetTransform(0, j), tolerance) || !IsNear(after[j], file.GetTransform(last, j), tolerance))
+			{
+				Check(false, test, source + ": joint " + file.GetJoint(j)->name + " is not clamped to the first and last frames");
+				num_errors++;
+			}
+		}
+
+		// A subset in any order gives the same transforms as all joints, and SampleMany() the same rows as Sample()
+		const int  subset[] = { num_joint - 1, 0, num_joint / 2 };
+		FBVHTransform  some[3];
+		file.Sample((f + 0.5) * file.GetInterval(), subset, 3, some);
+		bool  is_same = true;
+		for (int i = 0; i < 3; i++)
+		{
+			is_same = is_same && IsNear(some[i], halfway[subset[i]], 1e-12);
+		}
+		Check(is_same, test, source + ": sampling a subset of the joints differs from sampling all of them");
+
+		// More times than a task takes, so that the batch is split
+		std::vector< double >  times(150);
+		for (size_t t = 0; t < times.size(); t++)
+		{
+			times[t] = (t * 0.37 - 2.0) * file.GetInterval();
+		}
+		std::vector< FBVHTransform >  many(times.size() * 3);
+		file.SampleMany(times.data(), (int)times.size(), subset, 3, many.data());
+		is_same = true;
+		for (size_t t = 0; t < times.size() && is_same; t++)
+		{
+			file.Sample(times[t], subset, 3, some);
+			for (int i = 0; i < 3; i++)
+			{
+				is_same = is_same && IsNear(many[t * 3 + i], some[i], 1e-12);
+			}
+		}
+		Check(is_same, test, source + ": SampleMany() differs from Sample() at the same times");
+	}
+
+	// Sample() follows motion edited through GetMotionFrame() once ResetSamples() is called, and a motion of no frames samples identities
+	void  TestSampleChanges(const std::string& source)
+	{
+		const char*  test = "sample";
+		FBVHFile     file(source.c_str());
+		if (!file.Open())
+		{
+			Check(false, test, "cannot open " + source);
+			return;
+		}
+
+		const int  num_joint = file.GetNumJoint();
+		const int  f = file.GetNumFrame() / 2;
+		std::vector< FBVHTransform >  sampled(num_joint);
+		file.Sample(f * file.GetInterval(), NULL, num_joint, sampled.data());
+
+		double*  frame = file.GetMotionFrame(f);
+		for (int c = 0; c < file.GetNumChannel(); c++)
+		{
+			frame[c] += 10.0;
+		}
+		file.ResetSamples();
+		file.Sample(f * file.GetInterval(), NULL, num_joint, sampled.data());
+		bool  is_same = true;
+		for (int j = 0; j < num_joint; j++)
+		{
+			is_same = is_same && IsNear(sampled[j], file.GetTransform(f, j), 1e-9);
+		}
+		Check(is_same, test, source + ": the samples after ResetSamples() are not of the edited frame");
+
+		// Fills every requested transform, the sampled joints included
+		file.SetMotion(0, file.GetInterval());
+		std::fill(sampled.begin(), sampled.end(), FBVHTransform(FBVHQuat(1.0, 0.0, 0.0, 0.0), FBVHVector(1.0, 2.0, 3.0)));
+		file.Sample(1.0, NULL, num_joint, sampled.data());
+		const int  subset[] = { num_joint - 1 };
+		file.Sample(0.0, subset, 1, &sampled[0]);
+		is_same = true;
+		for (int j = 0; j < num_joint; j++)
+		{
+			is_same = is_same && IsNear(sampled[j], FBVHTransform(), 1e-12);
+		}
+		Check(is_same, test, source + ": a motion of no frames does not sample identities");
+	}
+}
+
+
+int  main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: BVHCoreTests <testdata dir> <temp dir>\n");
+		return  2;
+	}
+
+	const std::filesystem::path  temp_dir = argv[2];
+	std::filesystem::create_directories(temp_dir);
+
+	FBVHSyntheticSettings  synthetic;
+	synthetic.num_joints = 31;
+	synthetic.num_frames = 600;
+	synthetic.all_positions = true;
+	synthetic.rotation_order = "YXZ";
+	synthetic.separator = '\t';
+	synthetic.crlf = true;
+	const std::string  synthetic_name = (temp_dir / "synthetic.bvh").string();
+	if (!WriteSyntheticBVH(synthetic_name, synthetic))
+	{
+		fprintf(stderr, "Cannot write %s\n", synthetic_name.c_str());
+		return  1;
+	}
+
+	const std::string  sources[] = { (std::filesystem::path(argv[1]) / "walk4_subject1.bvh").string(), synthetic_name };
+	for (const std::string& source : sources)
+	{
+		TestSaveRoundTrip(source, (temp_dir / "saved.bvh").string());
+		TestTransformInverse(source);
+		TestStreaming(source);
+		TestHierarchyCache(source, (temp_dir / "copy.bvh").string());
+		TestFailedReadNotCached(source, (temp_dir / "cut.bvh").string());
+		TestCompressed(source, (temp_dir / "plain.bvh").string(), (temp_dir / "saved.bvh.gz").string(), (temp_dir / "renamed.bvh").string());
+		TestCorruptCompressed(source, (temp_dir / "corrupt.bvh.gz").string());
+		TestSample(source);
+		TestSampleChanges(source);
+	}
+
+	std::filesystem::remove_all(temp_dir);
+	printf("%s\n", num_failures == 0 ? "All tests passed" : "Tests failed");
+	return  num_failures == 0 ? 0 : 1;
+}